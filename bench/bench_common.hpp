@@ -0,0 +1,193 @@
+#ifndef COIO_BENCH_COMMON_HPP
+#define COIO_BENCH_COMMON_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <vector>
+
+#include "common/latency_histogram.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+
+namespace bench {
+
+using namespace std::chrono;
+
+// "--key=value" or "--flag" command line options
+class options {
+public:
+  options(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+      auto arg = std::string_view{argv[i]};
+      if (!arg.starts_with("--"))
+        continue;
+      arg.remove_prefix(2);
+      auto pos = arg.find('=');
+      auto key = std::string{arg.substr(0, pos)};
+      auto value = pos == std::string_view::npos
+                       ? std::string{"1"}
+                       : std::string{arg.substr(pos + 1)};
+      m_opts.insert_or_assign(std::move(key), std::move(value));
+    }
+  }
+
+  std::string get(const std::string &key, std::string def) const {
+    auto it = m_opts.find(key);
+    return it == m_opts.end() ? def : it->second;
+  }
+
+  long get(const std::string &key, long def) const {
+    auto it = m_opts.find(key);
+    return it == m_opts.end() ? def : std::atol(it->second.c_str());
+  }
+
+  // "--key=1,2,4" -> {1 , 2 , 4}
+  std::vector<long> get_list(const std::string &key, std::string def) const {
+    std::vector<long> values{};
+    auto s = get(key, std::move(def));
+    for (std::size_t beg = 0; beg < s.size();) {
+      auto end = std::min(s.find(',', beg), s.size());
+      values.push_back(std::atol(s.substr(beg, end - beg).c_str()));
+      beg = end + 1;
+    }
+    return values;
+  }
+
+  bool has(const std::string &key) const { return m_opts.contains(key); }
+
+private:
+  std::map<std::string, std::string> m_opts;
+};
+
+// runs the coroutine body() returns on ctx until it completes. body is a
+// parameter , so a temporary lambda lives as long as its coroutine. started
+// inside run() , a body which never suspends still stops ctx.
+//
+//  bench::run_until_done(ctx, [&]() -> future<void> { co_await ...; });
+template <class F> void run_until_done(coio::io_context &ctx, F body) {
+  auto run = [&]() -> coio::future<void> {
+    co_await body();
+    ctx.request_stop();
+  };
+  ctx.post([&] { ctx.co_spawn(run()); });
+  ctx.run();
+}
+
+// process cpu time (user + sys) between construction and stop()
+class cpu_timer {
+public:
+  cpu_timer() noexcept { restart(); }
+
+  void restart() noexcept {
+    ::getrusage(RUSAGE_SELF, &m_beg);
+    m_wall = steady_clock::now();
+  }
+
+  struct result {
+    double wall_s, user_s, sys_s;
+  };
+
+  result stop() const noexcept {
+    rusage end{};
+    ::getrusage(RUSAGE_SELF, &end);
+    auto tv = [](const timeval &t) { return t.tv_sec + t.tv_usec / 1e6; };
+    return {.wall_s = duration<double>(steady_clock::now() - m_wall).count(),
+            .user_s = tv(end.ru_utime) - tv(m_beg.ru_utime),
+            .sys_s = tv(end.ru_stime) - tv(m_beg.ru_stime)};
+  }
+
+private:
+  rusage m_beg{};
+  steady_clock::time_point m_wall;
+};
+
+// one json object per line , so results can be appended and diffed
+class json_line {
+public:
+  explicit json_line(std::string_view bench) { add("bench", bench); }
+
+  json_line &add(std::string_view k, std::string_view v) {
+    key(k) << '"' << v << '"';
+    return *this;
+  }
+  json_line &add(std::string_view k, const char *v) {
+    return add(k, std::string_view{v});
+  }
+  json_line &add(std::string_view k, double v) {
+    key(k) << v;
+    return *this;
+  }
+  json_line &add(std::string_view k, long v) {
+    key(k) << v;
+    return *this;
+  }
+  json_line &add(std::string_view k, unsigned long v) {
+    key(k) << v;
+    return *this;
+  }
+  json_line &add(std::string_view k, int v) { return add(k, long{v}); }
+  json_line &add(std::string_view k, unsigned v) {
+    return add(k, static_cast<unsigned long>(v));
+  }
+
+  // latency percentiles in microseconds , histogram records nanoseconds
+  json_line &add(const coio::latency_histogram &h) {
+    add("samples", static_cast<unsigned long>(h.count()));
+    add("p50_us", h.percentile(50) / 1e3);
+    add("p99_us", h.percentile(99) / 1e3);
+    add("p999_us", h.percentile(99.9) / 1e3);
+    add("max_us", h.max() / 1e3);
+    return *this;
+  }
+
+  json_line &add(const cpu_timer::result &r) {
+    add("wall_s", r.wall_s);
+    add("cpu_user_s", r.user_s);
+    add("cpu_sys_s", r.sys_s);
+    return *this;
+  }
+
+  // ops / second and cpu time
+  json_line &add_rate(std::string_view k, double ops,
+                      const cpu_timer::result &r) {
+    add(k, ops / r.wall_s);
+    return add(r);
+  }
+
+  void print() {
+    m_ss << '}';
+    std::puts(m_ss.str().c_str());
+    std::fflush(stdout);
+  }
+
+private:
+  std::ostream &key(std::string_view k) {
+    m_ss << (m_first ? "{" : ",") << '"' << k << "\":";
+    m_first = false;
+    return m_ss;
+  }
+
+  std::stringstream m_ss{};
+  bool m_first{true};
+};
+
+inline uint64_t elapsed_ns(steady_clock::time_point beg,
+                           steady_clock::time_point end) {
+  return duration_cast<nanoseconds>(end - beg).count();
+}
+
+// keep the compiler from discarding a value computed in a timing loop
+template <class T> inline void do_not_optimize(T &&v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+} // namespace bench
+
+#endif
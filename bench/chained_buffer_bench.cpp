@@ -0,0 +1,125 @@
+// streaming parse : newline delimited messages arrive in recv sized chunks ,
+// every complete message is handed off downstream (a window of the last 64
+// is kept alive) and consumed from the receive buffer.
+//  stream_buffer  : hand off copies the message into a std::string
+//  chained_buffer : hand off is split() , only reference counts move
+//  mirrored_ring_buffer : like stream_buffer , but never compacts
+//
+// chained_buffer_bench [--chunk=1024,16384] [--msg_max=512] [--mb=512]
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "chained_buffer.hpp"
+#include "mirrored_ring_buffer.hpp"
+#include "stream_buffer.hpp"
+
+constexpr std::size_t window = 64;
+
+// random length lines , a few full segments worth
+std::string make_stream(long msg_max) {
+  auto rng = std::mt19937{42};
+  auto len = std::uniform_int_distribution<long>{16, msg_max};
+  std::string s{};
+  while (s.size() < (1 << 20)) {
+    s.append(len(rng), 'x');
+    s.push_back('\n');
+  }
+  return s;
+}
+
+template <class F>
+void run(const char *impl, long chunk, long total_mb, const std::string &src,
+         F &&feed_and_parse) {
+  uint64_t msgs{};
+  uint64_t bytes{};
+  auto timer = bench::cpu_timer{};
+  for (std::size_t off = 0; bytes < (uint64_t(total_mb) << 20);) {
+    auto n = std::min<std::size_t>(chunk, src.size() - off);
+    msgs += feed_and_parse(src.data() + off, n);
+    bytes += n;
+    off = (off + n) % src.size();
+  }
+  auto cpu = timer.stop();
+  bench::json_line{"streaming_parse"}
+      .add("impl", impl)
+      .add("chunk", chunk)
+      .add("throughput_mbps", bytes / cpu.wall_s / (1 << 20))
+      .add_rate("msgs_per_sec", msgs, cpu)
+      .print();
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto chunks = opt.get_list("chunk", "1024,16384");
+  auto msg_max = opt.get("msg_max", 512);
+  auto total_mb = opt.get("mb", 512);
+  auto src = make_stream(msg_max);
+
+  for (auto chunk : chunks) {
+    {
+      auto buf = coio::stream_buffer{};
+      auto handed = std::vector<std::string>(window);
+      std::size_t k{};
+      run("stream_buffer", chunk, total_mb, src,
+          [&](const char *p, std::size_t n) {
+            auto wb = buf.prepare(n);
+            std::memcpy(wb.data(), p, n);
+            buf.commit(n);
+            uint64_t cnt{};
+            for (auto pos = buf.data().find('\n');
+                 pos != std::string_view::npos;
+                 pos = buf.data().find('\n')) {
+              handed[k++ % window].assign(buf.data().substr(0, pos + 1));
+              buf.consume(pos + 1);
+              ++cnt;
+            }
+            return cnt;
+          });
+    }
+    {
+      auto buf = coio::mirrored_ring_buffer{256 * 1024};
+      auto handed = std::vector<std::string>(window);
+      std::size_t k{};
+      run("mirrored_ring_buffer", chunk, total_mb, src,
+          [&](const char *p, std::size_t n) {
+            auto wb = buf.prepare(n);
+            std::memcpy(wb.data(), p, n);
+            buf.commit(n);
+            uint64_t cnt{};
+            for (auto pos = buf.data().find('\n');
+                 pos != std::string_view::npos;
+                 pos = buf.data().find('\n')) {
+              handed[k++ % window].assign(buf.data().substr(0, pos + 1));
+              buf.consume(pos + 1);
+              ++cnt;
+            }
+            return cnt;
+          });
+    }
+    {
+      auto buf = coio::chained_buffer{};
+      auto handed = std::vector<coio::chained_buffer>(window);
+      std::size_t k{};
+      run("chained_buffer", chunk, total_mb, src,
+          [&](const char *p, std::size_t n) {
+            std::size_t copied{};
+            for (auto span : buf.prepare(n)) {
+              auto m = std::min(span.size(), n - copied);
+              std::memcpy(span.data(), p + copied, m);
+              copied += m;
+            }
+            buf.commit(n);
+            uint64_t cnt{};
+            while (auto pos = buf.find('\n')) {
+              handed[k++ % window] = buf.split(*pos + 1);
+              ++cnt;
+            }
+            return cnt;
+          });
+    }
+  }
+}
@@ -0,0 +1,101 @@
+// connection rate : connect + accept + close per second over loopback.
+//
+// conn_rate_bench [--concurrency=1,16,64] [--duration=3] [--port=9101]
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using coio::acceptor, coio::connector;
+
+future<void> accept_and_close(uint16_t port, std::atomic<uint64_t> &accepted) {
+  auto accpt = acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port});
+  accpt.listen();
+  while (true) {
+    auto sock = co_await accpt.accept();
+    accepted.fetch_add(1, std::memory_order_relaxed);
+    // sock closed by destructor
+  }
+}
+
+struct client_stats {
+  coio::latency_histogram latency{};
+  uint64_t connections{};
+  uint64_t errors{};
+};
+
+future<void> connect_loop(uint16_t port, const std::atomic<bool> &stop,
+                          client_stats &stats) {
+  auto addr = ipv4::address{port, "127.0.0.1"};
+  while (!stop.load(std::memory_order_relaxed)) {
+    auto beg = bench::steady_clock::now();
+    try {
+      auto conn = connector{};
+      co_await conn.connect(addr);
+      // wait for server side close , so that the whole lifetime is measured
+      std::byte b{};
+      (void)co_await conn.socket().recv(std::span{&b, 1});
+      stats.latency.record(
+          bench::elapsed_ns(beg, bench::steady_clock::now()));
+      ++stats.connections;
+    } catch (const std::exception &) {
+      // ephemeral ports exhausted or accept queue full
+      ++stats.errors;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto concurrency = opt.get_list("concurrency", "1,16,64");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9101));
+
+  std::atomic<uint64_t> accepted{};
+  auto server = std::jthread{[&](std::stop_token token) {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    ctx.co_spawn(accept_and_close(port, accepted));
+    ctx.run(token);
+  }};
+  std::this_thread::sleep_for(bench::milliseconds{100});
+
+  for (auto n : concurrency) {
+    std::atomic<bool> stop{false};
+    auto stats = client_stats{};
+    accepted = 0;
+    auto timer = bench::cpu_timer{};
+    auto client = std::jthread{[&] {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      bench::run_until_done(ctx, [&]() -> future<void> {
+        std::vector<future<void>> loops{};
+        for (long i = 0; i < n; ++i)
+          loops.emplace_back(connect_loop(port, stop, stats));
+        co_await coio::when_all(std::move(loops));
+      });
+    }};
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    client.join();
+    auto cpu = timer.stop();
+
+    bench::json_line{"conn_rate"}
+        .add("impl", "coio")
+        .add("concurrency", n)
+        .add("accepted", accepted.load())
+        .add("errors", stats.errors)
+        .add_rate("conns_per_sec", stats.connections, cpu)
+        .add(stats.latency)
+        .print();
+  }
+}
@@ -0,0 +1,43 @@
+// coroutine create / await cost of future<T> , no io involved.
+//
+// coroutine_bench [--iterations=10000000] [--depth=1,8]
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+
+using coio::future, coio::io_context;
+
+future<int> leaf(int v) { co_return v + 1; }
+
+future<int> nested(int v, long depth) {
+  if (depth <= 1)
+    co_return co_await leaf(v);
+  co_return co_await nested(v, depth - 1);
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto iterations = opt.get("iterations", 10000000);
+  auto depths = opt.get_list("depth", "1,8");
+
+  for (auto depth : depths) {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    long sum{};
+    auto timer = bench::cpu_timer{};
+    bench::run_until_done(ctx, [&]() -> future<void> {
+      for (long i = 0; i < iterations; ++i)
+        sum += co_await nested(static_cast<int>(i & 0xff), depth);
+    });
+    auto cpu = timer.stop();
+
+    bench::json_line{"coroutine_await"}
+        .add("impl", "coio")
+        .add("depth", depth)
+        .add("ns_per_await", cpu.wall_s * 1e9 / iterations)
+        .add_rate("awaits_per_sec", iterations, cpu)
+        .add("checksum", sum)
+        .print();
+  }
+}
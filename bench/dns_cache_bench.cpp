@@ -0,0 +1,112 @@
+// name lookups against a stub dns server on loopback : every lookup sent
+// to the server (async_query) vs dns_cache , whose answers live for the
+// record ttl. lookups per second and latency per lookup.
+//
+// dns_cache_bench [--lookups=20000] [--names=16] [--port=9600]
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "http/dns_cache.hpp"
+#include "http/resolver.hpp"
+#include "io_context.hpp"
+#include "ioutils/udp.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+
+// answers every A query with 10.0.0.1 , ttl 300
+future<void> serve_dns(uint16_t port) {
+  auto sock = coio::udp_sock{};
+  sock.bind(ipv4::address{port, "127.0.0.1"});
+  auto buf = std::array<unsigned char, 512>{};
+  while (true) {
+    auto peer = ipv4::address{};
+    auto len =
+        co_await sock.recvfrom(peer, std::as_writable_bytes(std::span{buf}));
+    auto end = std::size_t{12};
+    while (end < len && buf[end] != 0)
+      end += buf[end] + 1;
+    end += 5;
+    buf[2] = 0x81, buf[3] = 0x80;
+    buf[6] = 0, buf[7] = 1;
+    buf[8] = buf[9] = buf[10] = buf[11] = 0;
+    const unsigned char answer[] = {0xc0, 12, 0, 1, 0,  1, 0, 0,
+                                    1,    44, 0, 4, 10, 0, 0, 1};
+    std::copy(std::begin(answer), std::end(answer), buf.begin() + end);
+    co_await sock.sendto(
+        peer, std::as_bytes(std::span{buf.data(), end + sizeof(answer)}));
+  }
+}
+
+template <class F>
+void lookup_bench(const char *impl, long lookups,
+                  const std::vector<std::string> &names, uint16_t port,
+                  F &&lookup) {
+  auto latency = coio::latency_histogram{};
+  auto failed = uint64_t{};
+  auto timer = bench::cpu_timer{};
+  auto client = std::jthread{[&] {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    auto servers = "127.0.0.1:" + std::to_string(port);
+    coio::async_resolver::current().set_servers(servers.c_str());
+    bench::run_until_done(ctx, [&]() -> future<void> {
+      for (long i = 0; i < lookups; ++i) {
+        auto &name = names[i % names.size()];
+        auto beg = bench::steady_clock::now();
+        auto ok = co_await lookup(name);
+        latency.record(bench::elapsed_ns(beg, bench::steady_clock::now()));
+        failed += !ok;
+      }
+    });
+  }};
+  client.join();
+  auto cpu = timer.stop();
+  bench::json_line{"dns_cache"}
+      .add("impl", impl)
+      .add("names", names.size())
+      .add("failed", failed)
+      .add_rate("lookups_per_sec", lookups, cpu)
+      .add(latency)
+      .print();
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto lookups = opt.get("lookups", 20000L);
+  auto name_cnt = opt.get("names", 16L);
+  auto port = static_cast<uint16_t>(opt.get("port", 9600));
+
+  auto server = std::jthread{[&](std::stop_token token) {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    ctx.co_spawn(serve_dns(port));
+    ctx.run(token);
+  }};
+  std::this_thread::sleep_for(bench::milliseconds{100});
+
+  auto names = std::vector<std::string>{};
+  for (long i = 0; i < name_cnt; ++i)
+    names.push_back("host" + std::to_string(i) + ".bench.test");
+
+  lookup_bench("uncached", lookups, names, port,
+               [](const std::string &name) -> future<bool> {
+                 auto list = co_await coio::async_query(name, "80");
+                 co_return list.has_value();
+               });
+
+  auto cache = coio::dns_cache{};
+  lookup_bench("cached", lookups, names, port,
+               [&](const std::string &name) -> future<bool> {
+                 auto addrs = co_await cache.lookup(name, "80");
+                 co_return addrs != nullptr;
+               });
+  bench::json_line{"dns_cache_stats"}
+      .add("hits", cache.stats().hits)
+      .add("misses", cache.stats().misses)
+      .print();
+}
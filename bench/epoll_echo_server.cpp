@@ -0,0 +1,94 @@
+// baseline : edge triggered epoll echo server bound to loopback only.
+// every thread owns an epoll instance and a SO_REUSEPORT listener.
+//
+// epoll_echo_server [--port=9200] [--threads=1]
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_common.hpp"
+
+static int make_listener(uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  sockaddr_in addr{.sin_family = AF_INET, .sin_port = htons(port)};
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, SOMAXCONN) != 0) {
+    std::perror("listen");
+    std::exit(1);
+  }
+  return fd;
+}
+
+static void echo(int fd, std::vector<char> &buff) {
+  while (true) {
+    auto n = ::recv(fd, buff.data(), buff.size(), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN)) {
+      ::close(fd);
+      return;
+    }
+    if (n < 0)
+      return;
+    for (ssize_t sent = 0; sent < n;) {
+      auto m = ::send(fd, buff.data() + sent, n - sent, MSG_NOSIGNAL);
+      if (m < 0) {
+        if (errno == EAGAIN)
+          continue; // rare for echo , spin instead of buffering
+        ::close(fd);
+        return;
+      }
+      sent += m;
+    }
+  }
+}
+
+static void serve(uint16_t port) {
+  int lfd = make_listener(port);
+  int efd = ::epoll_create1(0);
+  epoll_event ev{.events = EPOLLIN, .data = {.fd = lfd}};
+  ::epoll_ctl(efd, EPOLL_CTL_ADD, lfd, &ev);
+
+  auto buff = std::vector<char>(64 * 1024);
+  auto events = std::vector<epoll_event>(1024);
+  while (true) {
+    int n = ::epoll_wait(efd, events.data(), events.size(), -1);
+    for (int i = 0; i < n; ++i) {
+      int fd = events[i].data.fd;
+      if (fd != lfd) {
+        echo(fd, buff);
+        continue;
+      }
+      while (true) {
+        int cfd = ::accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (cfd < 0)
+          break;
+        int on = 1;
+        ::setsockopt(cfd, SOL_TCP, TCP_NODELAY, &on, sizeof(on));
+        epoll_event cev{.events = EPOLLIN | EPOLLET, .data = {.fd = cfd}};
+        ::epoll_ctl(efd, EPOLL_CTL_ADD, cfd, &cev);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto port = static_cast<uint16_t>(opt.get("port", 9200));
+  auto threads = opt.get("threads", 1);
+
+  std::vector<std::jthread> tds{};
+  for (long i = 1; i < threads; ++i)
+    tds.emplace_back(serve, port);
+  serve(port);
+}
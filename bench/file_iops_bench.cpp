@@ -0,0 +1,114 @@
+// file random read iops with a given queue depth (concurrent coroutines) ,
+// buffered through the page cache vs direct io (O_DIRECT) into buffers of an
+// aligned_buffer_pool. the file is likely cached after it was written , the
+// buffered reads then never reach the device.
+//
+// file_iops_bench [--file=./tmp/bench_file] [--file_mb=256] [--block=4096]
+//                 [--qd=1,8,32] [--duration=3] [--huge_pages=0]
+
+#include <fcntl.h>
+#include <filesystem>
+#include <random>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "aligned_buffer_pool.hpp"
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/direct_file.hpp"
+#include "ioutils/file.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::file, coio::direct_file;
+
+// prepare test file with blocking io , it's not part of the measurement
+void make_file(const std::string &path, std::size_t size) {
+  namespace fs = std::filesystem;
+  fs::create_directories(fs::path{path}.parent_path());
+  if (fs::exists(path) && fs::file_size(path) == size)
+    return;
+  int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  auto chunk = std::vector<char>(1 << 20, 'x');
+  for (std::size_t n = 0; n < size; n += chunk.size())
+    (void)::write(fd, chunk.data(), chunk.size());
+  ::fsync(fd);
+  ::close(fd);
+}
+
+struct reader_stats {
+  coio::latency_histogram latency{};
+  uint64_t reads{};
+};
+
+// buff : block bytes , owned by the reader
+template <class File, class Buffer>
+future<void> random_reader(File &f, Buffer buff, std::size_t file_size,
+                           std::size_t block, unsigned seed,
+                           bench::steady_clock::time_point end,
+                           reader_stats &stats) {
+  auto rng = std::mt19937_64{seed};
+  auto blocks = file_size / block;
+  while (bench::steady_clock::now() < end) {
+    auto off = static_cast<off_t>(rng() % blocks * block);
+    auto beg = bench::steady_clock::now();
+    (void)co_await f.read(buff, off);
+    stats.latency.record(bench::elapsed_ns(beg, bench::steady_clock::now()));
+    ++stats.reads;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto path = opt.get("file", "./tmp/bench_file");
+  auto file_size = static_cast<std::size_t>(opt.get("file_mb", 256)) << 20;
+  auto block = static_cast<std::size_t>(opt.get("block", 4096));
+  auto depths = opt.get_list("qd", "1,8,32");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto huge_pages = opt.get("huge_pages", 0) != 0;
+
+  make_file(path, file_size);
+
+  for (auto mode : {std::string_view{"buffered"}, std::string_view{"direct"}}) {
+    for (auto qd : depths) {
+      auto stats = reader_stats{};
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      auto timer = bench::cpu_timer{};
+      bench::run_until_done(ctx, [&]() -> future<void> {
+        auto end = bench::steady_clock::now() + duration;
+        if (mode == "buffered") {
+          auto f = co_await file::openat(path.c_str(), O_RDONLY);
+          std::vector<future<void>> readers{};
+          for (long i = 0; i < qd; ++i)
+            readers.emplace_back(random_reader(f,
+                                               std::vector<std::byte>(block),
+                                               file_size, block, i + 1, end,
+                                               stats));
+          co_await coio::when_all(std::move(readers));
+        } else {
+          auto f = co_await direct_file::openat(path.c_str(), O_RDONLY);
+          auto pool = coio::aligned_buffer_pool{block, f.memory_alignment(),
+                                                huge_pages};
+          // the readers hold buffers , gone before the pool
+          std::vector<future<void>> readers{};
+          for (long i = 0; i < qd; ++i)
+            readers.emplace_back(random_reader(f, pool.acquire(), file_size,
+                                               block, i + 1, end, stats));
+          co_await coio::when_all(std::move(readers));
+        }
+      });
+      auto cpu = timer.stop();
+
+      bench::json_line{"file_iops"}
+          .add("impl", "coio")
+          .add("mode", mode)
+          .add("block", block)
+          .add("qd", qd)
+          .add_rate("iops", stats.reads, cpu)
+          .add(stats.latency)
+          .print();
+    }
+  }
+}
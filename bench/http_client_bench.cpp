@@ -0,0 +1,155 @@
+// http_client requests per second over loopback , pooled keep-alive
+// connections vs a new connection per request (pool keeps nothing) vs
+// pipelined_get on one connection , concurrency requests in flight.
+//
+// http_client_bench [--concurrency=1,16] [--duration=3] [--body=128]
+//                   [--port=9400]
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "http/httpclient.hpp"
+#include "io_context.hpp"
+#include "ioutils/buffered_stream.hpp"
+#include "ioutils/tcp.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using namespace std::literals;
+
+// answers every request with the same response , closes when asked to
+future<void> serve_conn(coio::tcp_sock<> sock, const std::string &response) {
+  auto reader = coio::buffered_reader{sock};
+  auto writer = coio::buffered_writer{sock};
+  try {
+    while (true) {
+      auto head = co_await reader.read_until("\r\n\r\n");
+      if (!head.ends_with("\r\n\r\n"))
+        break;
+      auto close = head.find("Connection: close") != std::string_view::npos;
+      writer.write(std::string_view{response});
+      co_await writer.flush();
+      if (close)
+        break;
+    }
+  } catch (const std::exception &) {
+  }
+}
+
+future<void> serve(uint16_t port, const std::string &response) {
+  auto accpt = coio::acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port});
+  accpt.listen();
+  while (true) {
+    auto sock = co_await accpt.accept();
+    sock.set_no_delay();
+    io_context::current_context()->co_spawn(
+        serve_conn(std::move(sock), response));
+  }
+}
+
+struct client_stats {
+  coio::latency_histogram latency{};
+  uint64_t requests{};
+  uint64_t errors{};
+};
+
+future<void> request_loop(coio::http_client &client, std::string_view url,
+                          const std::atomic<bool> &stop, client_stats &stats) {
+  while (!stop.load(std::memory_order_relaxed)) {
+    auto beg = bench::steady_clock::now();
+    auto result = co_await client.get(url);
+    if (result.is_error()) {
+      ++stats.errors;
+      continue;
+    }
+    stats.latency.record(bench::elapsed_ns(beg, bench::steady_clock::now()));
+    ++stats.requests;
+  }
+}
+
+// concurrency gets queued at once , awaited in order
+future<void> pipeline_loop(coio::http_client &client, std::string_view url,
+                           long depth, const std::atomic<bool> &stop,
+                           client_stats &stats) {
+  using response_future =
+      future<coio::result<coio::http_response, std::string>>;
+  while (!stop.load(std::memory_order_relaxed)) {
+    auto beg = bench::steady_clock::now();
+    auto futures = std::vector<response_future>{};
+    for (long i = 0; i < depth; ++i)
+      futures.push_back(client.pipelined_get(url));
+    for (auto &f : futures) {
+      auto result = co_await std::move(f);
+      if (result.is_error()) {
+        ++stats.errors;
+        continue;
+      }
+      stats.latency.record(bench::elapsed_ns(beg, bench::steady_clock::now()));
+      ++stats.requests;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto concurrency = opt.get_list("concurrency", "1,16");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto body_size = opt.get("body", 128);
+  auto port = static_cast<uint16_t>(opt.get("port", 9400));
+
+  auto response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                  std::to_string(body_size) + "\r\n\r\n" +
+                  std::string(body_size, 'x');
+  auto server = std::jthread{[&](std::stop_token token) {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    ctx.co_spawn(serve(port, response));
+    ctx.run(token);
+  }};
+  std::this_thread::sleep_for(bench::milliseconds{100});
+
+  auto url = "http://127.0.0.1:" + std::to_string(port) + "/";
+  for (auto impl : {"keep_alive", "no_pool", "pipelined"}) {
+    for (auto n : concurrency) {
+      auto pipelined = impl == "pipelined"sv;
+      auto opts = coio::http_pool_options{};
+      opts.max_idle_per_host = impl == "no_pool"sv ? 0 : n;
+      opts.max_pipeline_depth = n;
+      std::atomic<bool> stop{false};
+      auto stats = client_stats{};
+      auto timer = bench::cpu_timer{};
+      auto client_thread = std::jthread{[&] {
+        auto ctx = io_context{};
+        auto _ = ctx.bind_this_thread();
+        auto client = coio::http_client{opts};
+        bench::run_until_done(ctx, [&]() -> future<void> {
+          std::vector<future<void>> loops{};
+          if (pipelined)
+            loops.emplace_back(pipeline_loop(client, url, n, stop, stats));
+          else
+            for (long i = 0; i < n; ++i)
+              loops.emplace_back(request_loop(client, url, stop, stats));
+          co_await coio::when_all(std::move(loops));
+        });
+      }};
+      std::this_thread::sleep_for(duration);
+      stop = true;
+      client_thread.join();
+      auto cpu = timer.stop();
+
+      bench::json_line{"http_client"}
+          .add("impl", impl)
+          .add("concurrency", n)
+          .add("body", body_size)
+          .add("errors", stats.errors)
+          .add_rate("req_per_sec", stats.requests, cpu)
+          .add(stats.latency)
+          .print();
+    }
+  }
+}
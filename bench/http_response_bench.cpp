@@ -0,0 +1,95 @@
+// building a small json api response from a parsed head and its body ,
+// then looking up a few headers : http_response (a string per header name /
+// value , body copied into a string) vs http_view_response (one buffer).
+// ns and heap allocations per response.
+//
+// http_response_bench [--iterations=2000000] [--body=256]
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "bench_common.hpp"
+#include "http/http_parser.hpp"
+#include "http/http_view_response.hpp"
+#include "http/httpclient.hpp"
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+}
+
+void *operator new(std::size_t n) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto *p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+std::string make_head(std::size_t body_size) {
+  return "HTTP/1.1 200 OK\r\n"
+         "Date: Mon, 19 Oct 2026 08:00:00 GMT\r\n"
+         "Content-Type: application/json; charset=utf-8\r\n"
+         "Content-Length: " +
+         std::to_string(body_size) +
+         "\r\n"
+         "Connection: keep-alive\r\n"
+         "Cache-Control: no-cache\r\n"
+         "Server: nginx\r\n"
+         "X-Request-Id: 5d6653688d944558ae68f231902fffa2\r\n"
+         "Vary: Accept-Encoding\r\n"
+         "\r\n";
+}
+
+template <class F>
+void response_bench(const char *impl, long iterations, F &&build) {
+  auto before = allocations.load();
+  auto timer = bench::cpu_timer{};
+  for (long i = 0; i < iterations; ++i)
+    build();
+  auto cpu = timer.stop();
+  auto allocs = allocations.load() - before;
+  bench::json_line{"http_response"}
+      .add("impl", impl)
+      .add("ns_per_response", cpu.wall_s * 1e9 / iterations)
+      .add("allocs_per_response", double(allocs) / iterations)
+      .print();
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto iterations = opt.get("iterations", 2000000L);
+  auto body_size = opt.get("body", 256);
+
+  auto head = make_head(body_size);
+  auto body = std::string(body_size, 'j');
+  auto parser = coio::http_parser{};
+  parser.parse_response(head);
+
+  response_bench("http_response", iterations, [&] {
+    auto rsp = coio::http_response{
+        .header = coio::http_header{parser.headers |
+                                    std::views::take(parser.headers_cnt)},
+        .body_length = parser.body_len,
+        .status_code = parser.status,
+    };
+    rsp.rsp.append(body);
+    bench::do_not_optimize(rsp.header.get_header_value("content-type"));
+    bench::do_not_optimize(rsp.header.get_header_value("x-request-id"));
+    bench::do_not_optimize(rsp.header.get_header_value("etag"));
+    bench::do_not_optimize(rsp.rsp.data());
+  });
+
+  response_bench("view", iterations, [&] {
+    auto builder =
+        coio::http_view_response::builder{head, parser, parser.body_len};
+    builder.append_body(body);
+    auto rsp = std::move(builder).finish();
+    bench::do_not_optimize(rsp.header("content-type"));
+    bench::do_not_optimize(rsp.header("x-request-id"));
+    bench::do_not_optimize(rsp.header("etag"));
+    bench::do_not_optimize(rsp.body().data());
+  });
+}
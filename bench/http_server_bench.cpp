@@ -0,0 +1,138 @@
+// http_server over loopback , wrk style : connections keep-alive clients ,
+// each writes depth pipelined GETs at once and waits for all responses.
+// requests per second and latency from the write to each response.
+//
+// http_server_bench [--connections=1,64] [--depth=1,16] [--duration=3]
+//                   [--body=128] [--port=9500]
+//                   [--external] : a server already listening on port ,
+//                                  answering GET / with the same response
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "http/httpserver.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+#include "stream_buffer.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using namespace std::literals;
+
+struct client_stats {
+  coio::latency_histogram latency{};
+  uint64_t requests{};
+  uint64_t errors{};
+};
+
+// the response is known , so it is counted by size and checked once
+future<void> connection_loop(uint16_t port, long depth,
+                             std::string_view response,
+                             const std::atomic<bool> &stop,
+                             client_stats &stats) {
+  try {
+    auto conn = coio::connector{};
+    co_await conn.connect(ipv4::address{port, "127.0.0.1"});
+    conn.set_no_delay();
+    auto requests = std::string{};
+    for (long i = 0; i < depth; ++i)
+      requests.append("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+    auto in = coio::stream_buffer{};
+    auto checked = false;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto beg = bench::steady_clock::now();
+      co_await conn.send(std::as_bytes(std::span{requests}));
+      for (long answered = 0; answered < depth;) {
+        auto n = co_await conn.recv(in.prepare(16 * 1024));
+        if (n == 0)
+          throw std::runtime_error{"closed by server"};
+        in.commit(n);
+        if (!checked && in.size() >= response.size()) {
+          if (in.data().substr(0, response.size()) != response)
+            throw std::runtime_error{"unexpected response"};
+          checked = true;
+        }
+        auto now = bench::steady_clock::now();
+        for (; answered < depth && in.size() >= response.size(); ++answered) {
+          in.consume(response.size());
+          stats.latency.record(bench::elapsed_ns(beg, now));
+          ++stats.requests;
+        }
+      }
+    }
+  } catch (const std::exception &) {
+    ++stats.errors;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto connections = opt.get_list("connections", "1,64");
+  auto depths = opt.get_list("depth", "1,16");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto body_size = opt.get("body", 128);
+  auto port = static_cast<uint16_t>(opt.get("port", 9500));
+  auto external = opt.has("external");
+
+  auto body = std::string(body_size, 'x');
+  auto response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                  std::to_string(body_size) +
+                  "\r\nContent-Type: text/plain\r\n\r\n" + body;
+  auto server_thread = std::jthread{};
+  if (!external) {
+    server_thread = std::jthread{[&](std::stop_token token) {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      auto server = coio::http_server{};
+      server.get("/", [&](const coio::http_request &, coio::http_reply &rep) {
+        rep.header("Content-Type", "text/plain");
+        rep.body_ref(body);
+      });
+      auto accpt = coio::acceptor{};
+      accpt.set_reuse_address();
+      accpt.bind(ipv4::address{port});
+      accpt.listen();
+      ctx.co_spawn(server.serve(accpt));
+      ctx.run(token);
+    }};
+    std::this_thread::sleep_for(bench::milliseconds{100});
+  }
+
+  for (auto n : connections) {
+    for (auto depth : depths) {
+      std::atomic<bool> stop{false};
+      auto stats = client_stats{};
+      auto timer = bench::cpu_timer{};
+      auto client_thread = std::jthread{[&] {
+        auto ctx = io_context{};
+        auto _ = ctx.bind_this_thread();
+        bench::run_until_done(ctx, [&]() -> future<void> {
+          std::vector<future<void>> loops{};
+          for (long i = 0; i < n; ++i)
+            loops.emplace_back(
+                connection_loop(port, depth, response, stop, stats));
+          co_await coio::when_all(std::move(loops));
+        });
+      }};
+      std::this_thread::sleep_for(duration);
+      stop = true;
+      client_thread.join();
+      auto cpu = timer.stop();
+
+      bench::json_line{"http_server"}
+          .add("impl", external ? "external" : "coio")
+          .add("connections", n)
+          .add("depth", depth)
+          .add("body", body_size)
+          .add("errors", stats.errors)
+          .add_rate("req_per_sec", stats.requests, cpu)
+          .add(stats.latency)
+          .print();
+    }
+  }
+}
@@ -0,0 +1,144 @@
+// vectored send of header + body + trailer.
+//  iovec_build : cost of building the iovec array alone
+//  send        : bytes/s over loopback tcp into a draining peer
+//
+// iovec_bench [--body=64,1024,16384] [--messages=200000] [--port=9300]
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using coio::acceptor, coio::connector;
+
+using bytes_t = std::span<const std::byte>;
+
+// the pre inline_iovecs behaviour , one malloc per call
+std::vector<::iovec> heap_iovecs(bytes_t h, bytes_t b, bytes_t t) {
+  std::vector<::iovec> iovecs{};
+  iovecs.reserve(3);
+  for (auto s : {h, b, t})
+    iovecs.push_back(coio::to_iovec(s));
+  return iovecs;
+}
+
+template <class F> void build_bench(const char *impl, long iterations, F &&f) {
+  auto timer = bench::cpu_timer{};
+  for (long i = 0; i < iterations; ++i)
+    bench::do_not_optimize(f());
+  auto cpu = timer.stop();
+  bench::json_line{"iovec_build"}
+      .add("impl", impl)
+      .add("buffers", 3)
+      .add("ns_per_build", cpu.wall_s * 1e9 / iterations)
+      .print();
+}
+
+// accept one connection and throw everything away
+void drain(int lfd) {
+  int fd = ::accept(lfd, nullptr, nullptr);
+  auto buff = std::vector<char>(256 * 1024);
+  while (::recv(fd, buff.data(), buff.size(), 0) > 0)
+    ;
+  ::close(fd);
+}
+
+enum class send_mode { copy, sendmsg, sendmsg_seq };
+
+future<void> sender(uint16_t port, send_mode mode, std::size_t body_size,
+                    long messages, uint64_t &bytes) {
+  auto conn = connector{};
+  co_await conn.connect(ipv4::address{port, "127.0.0.1"});
+  auto &sock = conn.socket();
+
+  auto header = std::vector<std::byte>(64);
+  auto body = std::vector<std::byte>(body_size);
+  auto trailer = std::vector<std::byte>(16);
+  auto total = header.size() + body.size() + trailer.size();
+  auto flat = std::vector<std::byte>(total);
+
+  for (long i = 0; i < messages; ++i) {
+    std::size_t n{};
+    switch (mode) {
+    case send_mode::copy: {
+      auto p = flat.data();
+      for (auto *v : {&header, &body, &trailer})
+        p = std::copy(v->begin(), v->end(), p);
+      n = co_await sock.send(flat);
+      break;
+    }
+    case send_mode::sendmsg:
+      n = co_await sock.sendmsg(bytes_t{header}, bytes_t{body},
+                                bytes_t{trailer});
+      break;
+    case send_mode::sendmsg_seq: {
+      bytes_t seq[] = {header, body, trailer};
+      n = co_await sock.sendmsg(seq);
+      break;
+    }
+    }
+    // loopback rarely sends partially , count what actually went out
+    bytes += n;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto bodies = opt.get_list("body", "64,1024,16384");
+  auto messages = opt.get("messages", 200000);
+  auto port = static_cast<uint16_t>(opt.get("port", 9300));
+
+  {
+    auto h = std::vector<std::byte>(64), b = std::vector<std::byte>(1024),
+         t = std::vector<std::byte>(16);
+    auto iterations = messages * 50;
+    build_bench("heap_vector", iterations,
+                [&] { return heap_iovecs(h, b, t); });
+    build_bench("array", iterations, [&] {
+      return coio::make_iovecs(bytes_t{h}, bytes_t{b}, bytes_t{t});
+    });
+    build_bench("inline_iovecs", iterations, [&] {
+      bytes_t seq[] = {h, b, t};
+      return coio::make_iovecs(seq);
+    });
+  }
+
+  auto accpt = acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port, "127.0.0.1"});
+  accpt.listen();
+
+  const std::pair<const char *, send_mode> modes[] = {
+      {"copy", send_mode::copy},
+      {"sendmsg", send_mode::sendmsg},
+      {"sendmsg_seq", send_mode::sendmsg_seq}};
+  for (auto body : bodies) {
+    for (auto [name, mode] : modes) {
+      auto peer = std::jthread{drain, accpt.native_handle()};
+      uint64_t bytes{};
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      auto timer = bench::cpu_timer{};
+      bench::run_until_done(ctx, [&]() -> future<void> {
+        co_await sender(port, mode, body, messages, bytes);
+      });
+      auto cpu = timer.stop();
+
+      bench::json_line{"iovec_send"}
+          .add("impl", name)
+          .add("body", body)
+          .add("throughput_mbps", bytes / cpu.wall_s / (1 << 20))
+          .add_rate("msgs_per_sec", messages, cpu)
+          .print();
+    }
+  }
+}
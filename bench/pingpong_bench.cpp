@@ -0,0 +1,151 @@
+// echo pingpong : round trip latency and throughput by message size and
+// connection count.
+//
+// pingpong_bench [--sizes=64,1024,16384] [--conns=1,16,256] [--threads=1]
+//                [--duration=3] [--port=9100] [--impl=coio]
+//
+// without --external an in-process coio echo server is started on --port ,
+// with --external the client runs against a server already listening on
+// --port (epoll_echo_server , libhv echo servers ...) and --impl names it.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using coio::tcp_sock, coio::acceptor, coio::connector;
+
+future<void> echo_session(tcp_sock<> sock, std::size_t buf_size) {
+  sock.set_no_delay();
+  try {
+    auto buff = std::vector<std::byte>(buf_size);
+    while (auto n = co_await sock.recv(buff)) {
+      for (std::size_t sent = 0; sent < n;)
+        sent += co_await sock.send(std::span{buff.data() + sent, n - sent});
+    }
+  } catch (const std::exception &) {
+  }
+}
+
+future<void> echo_server(io_context &ctx, uint16_t port, std::size_t buf_size) {
+  auto accpt = acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port});
+  accpt.listen();
+  while (true) {
+    auto sock = co_await accpt.accept();
+    ctx.co_spawn(echo_session(std::move(sock), buf_size));
+  }
+}
+
+struct client_stats {
+  coio::latency_histogram latency{};
+  uint64_t bytes{};
+  uint64_t round_trips{};
+};
+
+future<void> pingpong(uint16_t port, std::size_t size,
+                      const std::atomic<bool> &stop, client_stats &stats) {
+  try {
+    auto conn = connector{};
+    conn.set_no_delay();
+    co_await conn.connect(ipv4::address{port, "127.0.0.1"});
+    auto &sock = conn.socket();
+    auto buff = std::vector<std::byte>(size);
+
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto beg = bench::steady_clock::now();
+      for (std::size_t sent = 0; sent < size;)
+        sent += co_await sock.send(std::span{buff.data() + sent, size - sent});
+      std::size_t recv = 0;
+      while (recv < size) {
+        auto n =
+            co_await sock.recv(std::span{buff.data() + recv, size - recv});
+        if (n == 0)
+          co_return;
+        recv += n;
+      }
+      stats.latency.record(
+          bench::elapsed_ns(beg, bench::steady_clock::now()));
+      stats.bytes += size;
+      ++stats.round_trips;
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "pingpong : %s\n", e.what());
+  }
+}
+
+void client_thread(uint16_t port, std::size_t size, long conns,
+                   const std::atomic<bool> &stop, client_stats &stats) {
+  auto ctx = io_context{};
+  auto _ = ctx.bind_this_thread();
+  bench::run_until_done(ctx, [&]() -> future<void> {
+    std::vector<future<void>> clients{};
+    for (long i = 0; i < conns; ++i)
+      clients.emplace_back(pingpong(port, size, stop, stats));
+    co_await coio::when_all(std::move(clients));
+  });
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto sizes = opt.get_list("sizes", "64,1024,16384");
+  auto conns_list = opt.get_list("conns", "1,16,256");
+  auto threads = opt.get("threads", 1);
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9100));
+  auto impl = opt.get("impl", "coio");
+
+  std::jthread server{};
+  if (!opt.has("external")) {
+    auto max_size = *std::max_element(sizes.begin(), sizes.end());
+    server = std::jthread{[=](std::stop_token token) {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      ctx.co_spawn(echo_server(ctx, port, max_size));
+      ctx.run(token);
+    }};
+    std::this_thread::sleep_for(bench::milliseconds{100});
+  }
+
+  for (auto size : sizes) {
+    for (auto conns : conns_list) {
+      std::atomic<bool> stop{false};
+      auto stats = std::vector<client_stats>(threads);
+      auto timer = bench::cpu_timer{};
+      {
+        std::vector<std::jthread> clients{};
+        for (long t = 0; t < threads; ++t)
+          clients.emplace_back(client_thread, port, size,
+                               std::max(conns / threads, 1l), std::ref(stop),
+                               std::ref(stats[t]));
+        std::this_thread::sleep_for(duration);
+        stop = true;
+      }
+      auto cpu = timer.stop();
+
+      auto total = client_stats{};
+      for (auto &s : stats) {
+        total.latency.merge(s.latency);
+        total.bytes += s.bytes;
+        total.round_trips += s.round_trips;
+      }
+      bench::json_line{"pingpong"}
+          .add("impl", impl)
+          .add("msg_size", size)
+          .add("conns", conns)
+          .add("threads", threads)
+          .add("throughput_mbps", total.bytes / cpu.wall_s / (1 << 20))
+          .add_rate("round_trips_per_sec", total.round_trips, cpu)
+          .add(total.latency)
+          .print();
+    }
+  }
+  // in-process server thread is stopped by jthread destructor
+}
@@ -0,0 +1,56 @@
+// cross thread post : producer threads post tasks into one io_context.
+// latency is the time from post() to the task being executed.
+//
+// post_bench [--producers=1,4] [--posts=1000000]
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "io_context.hpp"
+
+using coio::io_context;
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto producers = opt.get_list("producers", "1,4");
+  auto posts = static_cast<uint64_t>(opt.get("posts", 1000000));
+
+  for (auto n : producers) {
+    auto ctx = io_context{};
+    auto latency = coio::latency_histogram{};
+    uint64_t executed{};
+    auto total = posts / n * n;
+
+    auto timer = bench::cpu_timer{};
+    auto consumer = std::jthread{[&] {
+      auto _ = ctx.bind_this_thread();
+      ctx.run();
+    }};
+    {
+      std::vector<std::jthread> threads{};
+      for (long i = 0; i < n; ++i)
+        threads.emplace_back([&] {
+          for (uint64_t k = 0; k < total / n; ++k) {
+            ctx.post([&, beg = bench::steady_clock::now()] {
+              // runs on the consumer thread only
+              latency.record(
+                  bench::elapsed_ns(beg, bench::steady_clock::now()));
+              if (++executed == total)
+                ctx.request_stop();
+            });
+          }
+        });
+    }
+    consumer.join();
+    auto cpu = timer.stop();
+
+    bench::json_line{"cross_thread_post"}
+        .add("impl", "coio")
+        .add("producers", n)
+        .add_rate("posts_per_sec", executed, cpu)
+        .add(latency)
+        .print();
+  }
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+# run all benchmarks , every result is one json object per line.
+# usage : run.sh <bench bin dir> [result file]
+#
+# LIBHV_ECHO_PORT=<port> : also run pingpong against a libhv echo server
+#                          already listening on loopback (see bench/libhv)
+
+BIN=${1:-./bin/bench}
+OUT=${2:-$BIN/results.jsonl}
+DURATION=${DURATION:-3}
+
+: > $OUT
+run() {
+    echo "==== $*" >&2
+    "$@" | tee -a $OUT
+}
+
+run $BIN/coroutine_bench
+run $BIN/post_bench
+run $BIN/timer_bench --duration=$DURATION
+run $BIN/file_iops_bench --duration=$DURATION
+run $BIN/conn_rate_bench --duration=$DURATION
+run $BIN/pingpong_bench --duration=$DURATION
+run $BIN/iovec_bench
+run $BIN/http_client_bench --duration=$DURATION
+run $BIN/http_server_bench --duration=$DURATION
+run $BIN/http_response_bench
+run $BIN/dns_cache_bench
+run $BIN/udp_pps_bench --duration=$DURATION
+run $BIN/uds_latency_bench --duration=$DURATION
+run $BIN/splice_proxy_bench --duration=$DURATION
+run $BIN/send_file_bench --duration=$DURATION
+run $BIN/chained_buffer_bench
+run $BIN/string_search_bench
+
+# baselines , same client against other servers on loopback
+$BIN/epoll_echo_server --port=9200 & EPOLL_PID=$!
+sleep 1
+run $BIN/pingpong_bench --duration=$DURATION --external --port=9200 --impl=epoll
+kill $EPOLL_PID
+
+if [ -n "$LIBHV_ECHO_PORT" ]; then
+    run $BIN/pingpong_bench --duration=$DURATION --external \
+        --port=$LIBHV_ECHO_PORT --impl=libhv
+fi
+
+echo "results : $OUT" >&2
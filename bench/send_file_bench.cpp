@@ -0,0 +1,158 @@
+// file serving throughput over loopback : every connection gets the whole
+// file again and again , read / send through a user buffer vs send_file()
+// splicing through a pooled pipe vs send_file() reading and sending with
+// send_zc. the file stays in the page cache , cpu time is the figure to
+// watch , loopback copies zero copy sends anyway.
+//
+// send_file_bench [--file=./tmp/send_file_bench] [--file_mb=64]
+//                 [--conns=1,4] [--duration=3] [--port=9140]
+//
+// every mode listens on its own port , from --port up
+
+#include <atomic>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/file.hpp"
+#include "ioutils/send_file.hpp"
+#include "ioutils/tcp.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4, coio::file;
+using coio::tcp_sock, coio::acceptor, coio::connector;
+
+constexpr std::size_t chunk_size = 64 * 1024;
+
+// prepare test file with blocking io , it's not part of the measurement
+void make_file(const std::string &path, std::size_t size) {
+  namespace fs = std::filesystem;
+  fs::create_directories(fs::path{path}.parent_path());
+  if (fs::exists(path) && fs::file_size(path) == size)
+    return;
+  int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  auto chunk = std::vector<char>(1 << 20, 'x');
+  for (std::size_t n = 0; n < size; n += chunk.size())
+    (void)::write(fd, chunk.data(), chunk.size());
+  ::close(fd);
+}
+
+future<std::size_t> copy_file(tcp_sock<> &sock, file &f, std::size_t len) {
+  auto buff = std::vector<std::byte>(chunk_size);
+  auto sent = std::size_t{};
+  while (sent < len) {
+    auto n = co_await f.read(buff, sent);
+    if (n == 0)
+      break;
+    for (std::size_t out = 0; out < n;)
+      out += co_await sock.send(std::span{buff.data() + out, n - out});
+    sent += n;
+  }
+  co_return sent;
+}
+
+future<void> serve(tcp_sock<> sock, const std::string &path,
+                   std::size_t size, std::string_view mode) {
+  try {
+    auto f = co_await file::openat(path.c_str(), O_RDONLY);
+    auto send_opt = coio::send_file_options{.splice = mode == "splice"};
+    while (true) {
+      if (mode == "copy")
+        co_await copy_file(sock, f, size);
+      else
+        co_await coio::send_file(sock, f, 0, size, send_opt);
+    }
+  } catch (const std::exception &) {
+  }
+}
+
+// session kept by value , the lambda passed in is a temporary
+template <class F>
+future<void> accept_loop(io_context &ctx, uint16_t port, F session) {
+  auto accpt = acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port});
+  accpt.listen();
+  while (true) {
+    auto sock = co_await accpt.accept();
+    ctx.co_spawn(session(std::move(sock)));
+  }
+}
+
+future<void> recv_loop(uint16_t port, const std::atomic<bool> &stop,
+                       std::atomic<uint64_t> &received) {
+  try {
+    auto conn = connector{};
+    co_await conn.connect(ipv4::address{port, "127.0.0.1"});
+    auto buff = std::vector<std::byte>(chunk_size);
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto n = co_await conn.socket().recv(buff);
+      if (n == 0)
+        break;
+      received.fetch_add(n, std::memory_order_relaxed);
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "recv : %s\n", e.what());
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto path = opt.get("file", "./tmp/send_file_bench");
+  auto size = static_cast<std::size_t>(opt.get("file_mb", 64)) << 20;
+  auto conns_list = opt.get_list("conns", "1,4");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9140));
+
+  make_file(path, size);
+
+  for (auto mode : {std::string_view{"copy"}, std::string_view{"splice"},
+                    std::string_view{"zc"}}) {
+    auto server_port = port++;
+    auto server = std::jthread{[&](std::stop_token token) {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      ctx.co_spawn(accept_loop(ctx, server_port, [&](tcp_sock<> sock) {
+        return serve(std::move(sock), path, size, mode);
+      }));
+      ctx.run(token);
+    }};
+    std::this_thread::sleep_for(bench::milliseconds{100});
+
+    for (auto conns : conns_list) {
+      std::atomic<bool> stop{false};
+      std::atomic<uint64_t> received{};
+      auto timer = bench::cpu_timer{};
+      auto client = std::jthread{[&] {
+        auto ctx = io_context{};
+        auto _ = ctx.bind_this_thread();
+        bench::run_until_done(ctx, [&]() -> future<void> {
+          std::vector<future<void>> loops{};
+          for (long i = 0; i < conns; ++i)
+            loops.emplace_back(recv_loop(server_port, stop, received));
+          co_await coio::when_all(std::move(loops));
+        });
+      }};
+      std::this_thread::sleep_for(duration);
+      auto bytes = received.load();
+      auto cpu = timer.stop();
+      stop = true;
+      client.join();
+
+      bench::json_line{"send_file"}
+          .add("mode", mode)
+          .add("conns", conns)
+          .add("file_mb", size >> 20)
+          .add("throughput_gbps", bytes / cpu.wall_s / (1 << 30))
+          .add(cpu)
+          .print();
+    }
+  }
+}
@@ -0,0 +1,139 @@
+// tcp proxy throughput over loopback : client -> proxy -> sink , the proxy
+// copying through a user space buffer (recv / send) vs splicing through
+// pooled pipes (coio::proxy).
+//
+// splice_proxy_bench [--conns=1,8] [--duration=3] [--port=9130]
+//
+// every mode listens on its own two ports , from --port up
+
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/proxy.hpp"
+#include "ioutils/tcp.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context, coio::ipv4;
+using coio::tcp_sock, coio::acceptor, coio::connector;
+
+constexpr std::size_t chunk_size = 64 * 1024;
+
+future<void> sink_session(tcp_sock<> sock, std::atomic<uint64_t> &received) {
+  try {
+    auto buff = std::vector<std::byte>(chunk_size);
+    while (auto n = co_await sock.recv(buff))
+      received.fetch_add(n, std::memory_order_relaxed);
+  } catch (const std::exception &) {
+  }
+}
+
+future<void> copy_forward(tcp_sock<> &from, tcp_sock<> &to) {
+  try {
+    auto buff = std::vector<std::byte>(chunk_size);
+    while (auto n = co_await from.recv(buff)) {
+      for (std::size_t sent = 0; sent < n;)
+        sent += co_await to.send(std::span{buff.data() + sent, n - sent});
+    }
+    co_await to.shutdown(to.shutdown_write);
+  } catch (const std::exception &) {
+  }
+}
+
+future<void> proxy_session(tcp_sock<> client, uint16_t sink_port,
+                           std::string_view mode) {
+  try {
+    auto conn = connector{};
+    co_await conn.connect(ipv4::address{sink_port, "127.0.0.1"});
+    if (mode == "splice") {
+      co_await coio::proxy(client, conn.socket());
+    } else {
+      auto both = coio::when_all(copy_forward(client, conn.socket()),
+                                 copy_forward(conn.socket(), client));
+      co_await std::move(both);
+    }
+  } catch (const std::exception &) {
+  }
+}
+
+// session kept by value , the lambda passed in is a temporary
+template <class F>
+future<void> accept_loop(io_context &ctx, uint16_t port, F session) {
+  auto accpt = acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(ipv4::address{port});
+  accpt.listen();
+  while (true) {
+    auto sock = co_await accpt.accept();
+    ctx.co_spawn(session(std::move(sock)));
+  }
+}
+
+future<void> send_loop(uint16_t port, const std::atomic<bool> &stop) {
+  try {
+    auto conn = connector{};
+    co_await conn.connect(ipv4::address{port, "127.0.0.1"});
+    auto buff = std::vector<std::byte>(chunk_size);
+    while (!stop.load(std::memory_order_relaxed))
+      co_await conn.socket().send(buff);
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "send : %s\n", e.what());
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto conns_list = opt.get_list("conns", "1,8");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9130));
+
+  for (auto mode : {std::string_view{"copy"}, std::string_view{"splice"}}) {
+    auto proxy_port = port++;
+    auto sink_port = port++;
+    std::atomic<uint64_t> received{};
+    auto server = std::jthread{[&](std::stop_token token) {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      ctx.co_spawn(accept_loop(ctx, sink_port, [&](tcp_sock<> sock) {
+        return sink_session(std::move(sock), received);
+      }));
+      ctx.co_spawn(accept_loop(ctx, proxy_port, [&](tcp_sock<> sock) {
+        return proxy_session(std::move(sock), sink_port, mode);
+      }));
+      ctx.run(token);
+    }};
+    std::this_thread::sleep_for(bench::milliseconds{100});
+
+    for (auto conns : conns_list) {
+      std::atomic<bool> stop{false};
+      received = 0;
+      auto timer = bench::cpu_timer{};
+      auto client = std::jthread{[&] {
+        auto ctx = io_context{};
+        auto _ = ctx.bind_this_thread();
+        bench::run_until_done(ctx, [&]() -> future<void> {
+          std::vector<future<void>> loops{};
+          for (long i = 0; i < conns; ++i)
+            loops.emplace_back(send_loop(proxy_port, stop));
+          co_await coio::when_all(std::move(loops));
+        });
+      }};
+      std::this_thread::sleep_for(duration);
+      auto bytes = received.load();
+      auto cpu = timer.stop();
+      stop = true;
+      client.join();
+
+      bench::json_line{"splice_proxy"}
+          .add("mode", mode)
+          .add("conns", conns)
+          .add("throughput_mbps", bytes / cpu.wall_s / (1 << 20))
+          .add(cpu)
+          .print();
+    }
+  }
+}
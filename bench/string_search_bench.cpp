@@ -0,0 +1,120 @@
+// delimiter search and ascii case insensitive compare.
+//  find    : GB/s scanning header like text for a delimiter at its end ,
+//            std::string_view::find vs scalar / sse2 / avx2 / dispatched
+//  iequals : ns per header name compare , ranges + std::tolower vs
+//            ascii_iequals
+//
+// string_search_bench [--sizes=64,512,4096,65536] [--bytes=1000000000]
+
+#include <cctype>
+#include <random>
+#include <ranges>
+
+#include "bench_common.hpp"
+#include "common/string_search.hpp"
+
+using namespace std::literals;
+namespace search = coio::details::search;
+
+// "name: value\r\n" lines , no blank line until the very end.
+// a single byte delimiter ("\n" of read_line) gets one long line instead.
+std::string make_head(std::size_t size, std::string_view delim) {
+  auto rng = std::mt19937{1};
+  auto eol = delim.size() == 1 ? "; "sv : "\r\n"sv;
+  auto head = std::string{};
+  while (head.size() < size) {
+    auto name_len = 4 + rng() % 12, value_len = 8 + rng() % 40;
+    for (std::size_t i = 0; i < name_len; ++i)
+      head.push_back("abcdefghijklmnopqrstuvwxyz-"[rng() % 27]);
+    head.append(": ");
+    for (std::size_t i = 0; i < value_len; ++i)
+      head.push_back(static_cast<char>(' ' + rng() % 94));
+    head.append(eol);
+  }
+  head.resize(size - delim.size());
+  head.append(delim);
+  return head;
+}
+
+template <class F>
+void find_bench(const char *impl, std::string_view needle, std::string &head,
+                long total_bytes, F &&find) {
+  auto iterations = std::max(1L, total_bytes / long(head.size()));
+  auto timer = bench::cpu_timer{};
+  for (long i = 0; i < iterations; ++i) {
+    auto pos = find(std::string_view{head}, needle);
+    bench::do_not_optimize(pos);
+  }
+  auto cpu = timer.stop();
+  bench::json_line{"string_find"}
+      .add("impl", impl)
+      .add("needle_len", needle.size())
+      .add("bytes", head.size())
+      .add("gb_per_s", double(iterations) * head.size() / cpu.wall_s / 1e9)
+      .print();
+}
+
+void find_suite(std::string_view needle, std::size_t size, long total_bytes) {
+  auto head = make_head(size, needle);
+  auto raw = [](search::find_fn fn) {
+    return [fn](std::string_view s, std::string_view p) {
+      return fn(s.data(), s.size(), p.data(), p.size());
+    };
+  };
+  find_bench("std_find", needle, head, total_bytes,
+             [](std::string_view s, std::string_view p) { return s.find(p); });
+  find_bench("dispatch", needle, head, total_bytes,
+             [](std::string_view s, std::string_view p) {
+               return coio::find_delimiter(s, p);
+             });
+  if (needle.size() < 2)
+    return; // single bytes always go to memchr
+  find_bench("scalar", needle, head, total_bytes, raw(search::find_scalar));
+#ifdef COIO_SEARCH_X86
+  find_bench("sse2", needle, head, total_bytes, raw(search::find_sse2));
+  if (search::has_avx2())
+    find_bench("avx2", needle, head, total_bytes, raw(search::find_avx2));
+#endif
+}
+
+// the pre string_search http_parser compare
+bool ranges_iequals(std::string_view a, std::string_view b) {
+  constexpr auto tolower = [](char c) { return std::tolower(c); };
+  return std::ranges::equal(a | std::views::transform(tolower),
+                            b | std::views::transform(tolower));
+}
+
+template <class F>
+void iequals_bench(const char *impl, long iterations, F &&f) {
+  // lookup of content-length among typical response header names
+  std::string_view names[] = {"Date",          "Content-Type",
+                              "Cache-Control", "Set-Cookie",
+                              "Server",        "Access-Control-Allow-Origin",
+                              "Content-Length"};
+  auto timer = bench::cpu_timer{};
+  for (long i = 0; i < iterations; ++i) {
+    for (auto name : names) {
+      auto eq = f(name, std::string_view{"content-length"});
+      bench::do_not_optimize(eq);
+    }
+  }
+  auto cpu = timer.stop();
+  bench::json_line{"iequals"}
+      .add("impl", impl)
+      .add("ns_per_lookup", cpu.wall_s * 1e9 / iterations)
+      .print();
+}
+
+int main(int argc, char *argv[]) {
+  auto opts = bench::options{argc, argv};
+  auto sizes = opts.get_list("sizes", "64,512,4096,65536");
+  auto total_bytes = opts.get("bytes", 1000L * 1000 * 1000);
+
+  for (auto needle : {"\r\n\r\n"sv, "\n"sv, "--boundary-7d93b1"sv})
+    for (auto size : sizes)
+      find_suite(needle, size, total_bytes);
+
+  auto iterations = total_bytes / 100;
+  iequals_bench("ranges_tolower", iterations, ranges_iequals);
+  iequals_bench("ascii_iequals", iterations, coio::ascii_iequals);
+}
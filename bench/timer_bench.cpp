@@ -0,0 +1,72 @@
+// timer churn : many coroutines repeatedly arming short timers.
+// latency is the lateness of each timer (fired time - expected time).
+//
+// timer_bench [--timers=100,10000] [--max_delay_us=1000] [--duration=3]
+
+#include <bit>
+#include <random>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "time_delay.hpp"
+#include "when_all.hpp"
+
+using coio::future, coio::io_context;
+
+struct timer_stats {
+  coio::latency_histogram lateness{};
+  uint64_t fired{};
+};
+
+future<void> churn(unsigned seed, long max_delay_us,
+                   bench::steady_clock::time_point end, timer_stats &stats) {
+  auto rng = std::mt19937{seed};
+  auto dist = std::uniform_int_distribution<long>{1, max_delay_us};
+  while (bench::steady_clock::now() < end) {
+    auto delay_us = dist(rng);
+    auto expect = bench::steady_clock::now() + bench::microseconds{delay_us};
+    co_await coio::time_delay(bench::microseconds{delay_us});
+    auto now = bench::steady_clock::now();
+    stats.lateness.record(now > expect ? bench::elapsed_ns(expect, now) : 0);
+    ++stats.fired;
+  }
+}
+
+future<void> run_all(io_context &ctx, long n, long max_delay_us,
+                     bench::seconds duration, timer_stats &stats) {
+  auto end = bench::steady_clock::now() + duration;
+  std::vector<future<void>> timers{};
+  for (long i = 0; i < n; ++i)
+    timers.emplace_back(churn(i + 1, max_delay_us, end, stats));
+  co_await coio::when_all(std::move(timers));
+  ctx.request_stop();
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto counts = opt.get_list("timers", "100,10000");
+  auto max_delay_us = opt.get("max_delay_us", 1000);
+  auto duration = bench::seconds{opt.get("duration", 3)};
+
+  for (auto n : counts) {
+    auto stats = timer_stats{};
+    // every coroutine holds one pending timeout sqe
+    auto ctx = io_context{coio::ctx_opt{
+        .ring_size = std::bit_ceil(static_cast<uint32_t>(n) + 64)}};
+    auto _ = ctx.bind_this_thread();
+    auto timer = bench::cpu_timer{};
+    ctx.co_spawn(run_all(ctx, n, max_delay_us, duration, stats));
+    ctx.run();
+    auto cpu = timer.stop();
+
+    bench::json_line{"timer_churn"}
+        .add("impl", "coio")
+        .add("timers", n)
+        .add("max_delay_us", max_delay_us)
+        .add_rate("timers_per_sec", stats.fired, cpu)
+        .add(stats.lateness)
+        .print();
+  }
+}
@@ -0,0 +1,129 @@
+// udp datagrams per second over loopback , one sender thread and one
+// receiver thread. a recvmsg per datagram vs a multishot recvmsg into
+// provided buffers (with and without gro) , a sendmsg per datagram vs a
+// send on a connected socket vs gso.
+//
+// udp_pps_bench [--size=1200] [--batch=16] [--duration=3] [--port=9110]
+//
+// every mode binds its own port , from --port up
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/provided_buffers.hpp"
+#include "ioutils/udp.hpp"
+
+using coio::future, coio::io_context, coio::ipv4, coio::udp_sock;
+
+struct mode {
+  std::string_view send; // sendto , send (connected) , gso
+  std::string_view recv; // recvfrom , multishot , multishot_gro
+};
+
+future<void> recv_loop(udp_sock<> &sock, std::string_view recv,
+                       std::atomic<uint64_t> &received) {
+  if (recv == "recvfrom") {
+    auto buf = std::vector<std::byte>(2048);
+    auto peer = ipv4::address{};
+    while (true) {
+      co_await sock.recvfrom(peer, buf);
+      received.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  // a coalesced datagram holds up to 64 segments
+  auto size = recv == "multishot_gro" ? 65536u : 2048u;
+  auto pool = std::make_shared<coio::provided_buffers>(256, size);
+  auto datagrams = sock.recvmsg_multishot(pool);
+  while (true) {
+    auto d = co_await datagrams.next();
+    received.fetch_add(d.segment_count(), std::memory_order_relaxed);
+  }
+}
+
+future<void> send_loop(udp_sock<> &sock, ipv4::address to, mode m,
+                       std::size_t size, std::size_t batch,
+                       const std::atomic<bool> &stop, uint64_t &sent) {
+  auto payload = std::vector<std::byte>(size * batch);
+  if (m.send == "send")
+    sock.connect(to);
+  while (!stop.load(std::memory_order_relaxed)) {
+    if (m.send == "gso") {
+      co_await sock.sendto_segmented(to, payload, size);
+      sent += batch;
+    } else if (m.send == "send") {
+      co_await sock.send(std::span{payload}.first(size));
+      ++sent;
+    } else {
+      co_await sock.sendto(to, std::span{payload}.first(size));
+      ++sent;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto size = static_cast<std::size_t>(opt.get("size", 1200));
+  auto batch = static_cast<std::size_t>(opt.get("batch", 16));
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9110));
+
+  auto modes = std::vector<mode>{{"sendto", "recvfrom"},
+                                 {"send", "recvfrom"},
+                                 {"sendto", "multishot"},
+                                 {"gso", "multishot"},
+                                 {"gso", "multishot_gro"}};
+  for (auto m : modes) {
+    // the last receiver socket is held until its ring is torn down
+    auto recv_port = port++;
+    std::atomic<uint64_t> received{};
+    auto receiver = std::jthread{[&](std::stop_token token) {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      auto sock = udp_sock{};
+      sock.bind(ipv4::address{recv_port, "127.0.0.1"});
+      if (m.recv == "multishot_gro")
+        sock.set_gro();
+      ctx.co_spawn(recv_loop(sock, m.recv, received));
+      ctx.run(token);
+    }};
+    std::this_thread::sleep_for(bench::milliseconds{100});
+
+    std::atomic<bool> stop{false};
+    uint64_t sent{};
+    received = 0;
+    auto timer = bench::cpu_timer{};
+    auto sender = std::jthread{[&] {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      auto sock = udp_sock{};
+      bench::run_until_done(ctx, [&]() -> future<void> {
+        co_await send_loop(sock, ipv4::address{recv_port, "127.0.0.1"}, m,
+                           size, batch, stop, sent);
+      });
+    }};
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    sender.join();
+    auto cpu = timer.stop();
+    auto got = received.load();
+    receiver.request_stop();
+    receiver.join();
+
+    bench::json_line{"udp_pps"}
+        .add("send", m.send)
+        .add("recv", m.recv)
+        .add("size", size)
+        .add("batch", m.send == "gso" ? batch : 1)
+        .add("sent", sent)
+        .add("send_pps", sent / cpu.wall_s)
+        .add("received", got)
+        .add_rate("pps", got, cpu)
+        .print();
+  }
+}
@@ -0,0 +1,125 @@
+// round trip latency of one connection , loopback tcp vs a unix domain
+// stream socket vs a unix domain seqpacket socket (abstract names).
+//
+// uds_latency_bench [--sizes=64,1024,16384] [--duration=3] [--port=9120]
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+
+using coio::future, coio::io_context, coio::ipv4, coio::iplocal;
+using coio::tcp_sock, coio::acceptor, coio::connector;
+
+template <class Domain>
+future<void> echo_session(tcp_sock<Domain> sock, std::size_t buf_size) {
+  try {
+    auto buff = std::vector<std::byte>(buf_size);
+    while (auto n = co_await sock.recv(buff)) {
+      for (std::size_t sent = 0; sent < n;)
+        sent += co_await sock.send(std::span{buff.data() + sent, n - sent});
+    }
+  } catch (const std::exception &) {
+  }
+}
+
+template <class Domain>
+future<void> echo_server(io_context &ctx, acceptor<Domain> &accpt,
+                         std::size_t buf_size) {
+  while (true) {
+    auto sock = co_await accpt.accept();
+    ctx.co_spawn(echo_session(std::move(sock), buf_size));
+  }
+}
+
+template <class Domain>
+future<void> pingpong(typename tcp_sock<Domain>::address_t addr,
+                      std::size_t size, const std::atomic<bool> &stop,
+                      coio::latency_histogram &latency, uint64_t &round_trips) {
+  try {
+    auto conn = connector<Domain>{};
+    if constexpr (!tcp_sock<Domain>::is_local)
+      conn.set_no_delay();
+    co_await conn.connect(addr);
+    auto &sock = conn.socket();
+    auto buff = std::vector<std::byte>(size);
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto beg = bench::steady_clock::now();
+      for (std::size_t sent = 0; sent < size;)
+        sent += co_await sock.send(std::span{buff.data() + sent, size - sent});
+      for (std::size_t recv = 0; recv < size;) {
+        auto n =
+            co_await sock.recv(std::span{buff.data() + recv, size - recv});
+        if (n == 0)
+          co_return;
+        recv += n;
+      }
+      latency.record(bench::elapsed_ns(beg, bench::steady_clock::now()));
+      ++round_trips;
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "pingpong : %s\n", e.what());
+  }
+}
+
+template <class Domain>
+void run(const char *transport, typename tcp_sock<Domain>::address_t addr,
+         const std::vector<long> &sizes, bench::seconds duration) {
+  auto max_size = *std::max_element(sizes.begin(), sizes.end());
+  auto server = std::jthread{[&](std::stop_token token) {
+    auto ctx = io_context{};
+    auto _ = ctx.bind_this_thread();
+    auto accpt = acceptor<Domain>{};
+    accpt.set_reuse_address();
+    accpt.bind(addr);
+    accpt.listen();
+    ctx.co_spawn(echo_server(ctx, accpt, max_size));
+    ctx.run(token);
+  }};
+  std::this_thread::sleep_for(bench::milliseconds{100});
+
+  for (auto size : sizes) {
+    std::atomic<bool> stop{false};
+    auto latency = coio::latency_histogram{};
+    auto round_trips = uint64_t{};
+    auto timer = bench::cpu_timer{};
+    auto client = std::jthread{[&] {
+      auto ctx = io_context{};
+      auto _ = ctx.bind_this_thread();
+      bench::run_until_done(ctx, [&]() -> future<void> {
+        co_await pingpong<Domain>(addr, size, stop, latency, round_trips);
+      });
+    }};
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    client.join();
+    auto cpu = timer.stop();
+
+    bench::json_line{"uds_latency"}
+        .add("transport", transport)
+        .add("msg_size", size)
+        .add_rate("round_trips_per_sec", round_trips, cpu)
+        .add(latency)
+        .print();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opt = bench::options{argc, argv};
+  auto sizes = opt.get_list("sizes", "64,1024,16384");
+  auto duration = bench::seconds{opt.get("duration", 3)};
+  auto port = static_cast<uint16_t>(opt.get("port", 9120));
+  auto name = "coio_uds_latency_bench." + std::to_string(::getpid());
+
+  run<ipv4>("tcp", ipv4::address{port, "127.0.0.1"}, sizes, duration);
+  run<iplocal>("uds_stream", iplocal::address::abstract(name + ".stream"),
+               sizes, duration);
+  run<iplocal::seqpacket>("uds_seqpacket",
+                          iplocal::address::abstract(name + ".seqpacket"),
+                          sizes, duration);
+}
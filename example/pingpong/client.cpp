@@ -1,9 +1,13 @@
 #include <chrono>
+#include <cstring>
+#include <deque>
 #include <iostream>
-#include <numeric>
+#include <map>
+#include <random>
 #include <span>
 #include <thread>
 
+#include "common/latency_histogram.hpp"
 #include "future.hpp"
 #include "io_context.hpp"
 #include "ioutils/tcp.hpp"
@@ -12,121 +16,290 @@
 
 using coio::future, coio::io_context;
 using coio::tcp_sock, coio::ipv4, coio::connector;
-using coio::to_bytes, coio::to_const_bytes, coio::when_all;
+using coio::latency_histogram, coio::when_all;
+
+using namespace std::chrono;
+using clock_type = steady_clock;
 
 constexpr uint64_t KB = 1024;
 constexpr uint64_t MB = 1024 * 1024;
 
-uint16_t g_server_port{};
-
-future<uint64_t> client(io_context &ctx, uint times) {
-  uint64_t bytes_read{};
-  [[maybe_unused]] uint64_t expect_read = KB * times;
+// message size distribution :
+//  "1024"            fixed size
+//  "uniform:64:4096" uniform in [64 , 4096]
+//  "exp:1024"        exponential with mean 1024
+struct size_dist {
+  enum kind_t { fixed, uniform, exponential } kind{fixed};
+  std::size_t a{KB}, b{KB};
 
-  try {
+  static size_dist parse(std::string_view s) {
+    auto num = [](std::string_view v) {
+      return static_cast<std::size_t>(std::atol(std::string{v}.c_str()));
+    };
+    if (s.starts_with("uniform:")) {
+      s.remove_prefix(8);
+      auto pos = s.find(':');
+      return {uniform, num(s.substr(0, pos)), num(s.substr(pos + 1))};
+    }
+    if (s.starts_with("exp:"))
+      return {exponential, num(s.substr(4)), num(s.substr(4)) * 8};
+    return {fixed, num(s), num(s)};
+  }
 
-    auto conn = connector{};
-    conn.set_no_delay();
-    co_await conn.connect(ipv4::address{g_server_port});
-    auto &sock = conn.socket();
-    auto buff = std::vector<std::byte>(KB);
+  // upper bound of generated sizes
+  std::size_t max() const noexcept { return b; }
 
-    while (times--) {
-      [[maybe_unused]] auto n = co_await sock.send(buff);
-      auto m = co_await sock.recv(buff);
-      if (m == 0)
-        break;
-      bytes_read += m;
+  std::size_t operator()(std::mt19937_64 &rng) const {
+    switch (kind) {
+    case uniform:
+      return std::uniform_int_distribution<std::size_t>{a, b}(rng);
+    case exponential: {
+      auto v = std::exponential_distribution<double>{1.0 / a}(rng);
+      return std::clamp<std::size_t>(static_cast<std::size_t>(v), 1, b);
     }
+    default:
+      return a;
+    }
+  }
+};
 
-  } catch (const std::exception &e) {
-    std::cout << "exception : " << e.what() << std::endl;
+struct config {
+  uint16_t port{8888};
+  int threads{1};
+  int conns{1};       // connections per thread
+  double rate{0};     // total requests per second , 0 : closed loop
+  int depth{1};       // max in flight requests per connection
+  size_dist sizes{};  // message size distribution
+  seconds warmup{1};  // not recorded
+  seconds duration{5}; // recorded
+};
+
+// only requests intended to be sent in [measure_beg , measure_end) count
+struct phase {
+  clock_type::time_point start, measure_beg, measure_end;
+};
+
+struct thread_stats {
+  latency_histogram latency{};
+  uint64_t requests{};
+  uint64_t bytes{};
+};
+
+// a single waiting coroutine.
+// resume is posted rather than inlined , the waiter may finish the whole
+// connection and destroy the frame of the notifier.
+struct waiter {
+  std::coroutine_handle<> waiting{};
+
+  auto wait() noexcept {
+    struct awaiter : std::suspend_always {
+      waiter &self;
+      void await_suspend(std::coroutine_handle<> h) noexcept {
+        self.waiting = h;
+      }
+    };
+    return awaiter{{}, *this};
   }
 
-  // std::cout << "total read " << bytes_read<< std::endl;
-  // std::cout << "expect " << expect_read << std::endl;
-  // assert(bytes_read != expect_read );
-  co_return bytes_read;
-}
+  void notify() noexcept {
+    if (auto h = std::exchange(waiting, nullptr))
+      io_context::current_context()->post([h] { h.resume(); });
+  }
+};
 
-std::atomic<double> g_throughput{0.0};
-std::atomic<int> thread_id{0};
+struct in_flight {
+  clock_type::time_point intended; // scheduled send time
+  std::size_t size;
+};
 
-auto start_all_conn(io_context &ctx, uint conns, uint times,
-                    std::atomic<uint64_t> &bytes) -> future<void> {
+struct connection_state {
+  std::deque<in_flight> queue{};
+  waiter slot{};    // sender waits for a free pipeline slot
+  waiter pending{}; // receiver waits for a request to be sent
+  bool sender_done{false};
+};
 
-  auto this_tid = ++thread_id;
+future<void> sender(tcp_sock<> &sock, connection_state &state,
+                    const config &cfg, const phase &ph, unsigned seed,
+                    nanoseconds interval) {
+  auto rng = std::mt19937_64{seed};
+  auto buff = std::vector<std::byte>(cfg.sizes.max());
+  auto next = ph.start;
+  try {
+    while (true) {
+      auto now = clock_type::now();
+      if (cfg.rate > 0) {
+        // open loop : never wait for responses to decide when to send ,
+        // latency is measured from the intended send time.
+        if (next > now)
+          co_await coio::time_delay(nanoseconds{next - now});
+      } else {
+        next = now;
+      }
+      if (next >= ph.measure_end)
+        break;
+      while (state.queue.size() >= static_cast<std::size_t>(cfg.depth))
+        co_await state.slot.wait();
 
-  using namespace std::chrono;
-  std::vector<future<uint64_t>> futures;
+      auto size = cfg.sizes(rng);
+      state.queue.push_back({next, size});
+      state.pending.notify();
+      for (std::size_t sent = 0; sent < size;)
+        sent += co_await sock.send(std::span{buff.data() + sent, size - sent});
+      next += interval;
+    }
+  } catch (const std::exception &e) {
+    std::cout << "send exception : " << e.what() << std::endl;
+  }
+  state.sender_done = true;
+  state.pending.notify();
+}
+
+future<void> receiver(tcp_sock<> &sock, connection_state &state,
+                      const config &cfg, const phase &ph,
+                      thread_stats &stats) {
+  auto buff = std::vector<std::byte>(cfg.sizes.max());
+  try {
+    while (!state.sender_done || !state.queue.empty()) {
+      if (state.queue.empty()) {
+        co_await state.pending.wait();
+        continue;
+      }
+      auto req = state.queue.front();
+      for (std::size_t n = 0; n < req.size;) {
+        auto m = co_await sock.recv(std::span{buff.data(), req.size - n});
+        if (m == 0)
+          co_return;
+        n += m;
+      }
+      state.queue.pop_front();
+      state.slot.notify();
 
-  // for all connections
-  while (conns--) {
-    futures.emplace_back(client(ctx, times));
+      if (req.intended >= ph.measure_beg && req.intended < ph.measure_end) {
+        stats.latency.record(
+            duration_cast<nanoseconds>(clock_type::now() - req.intended)
+                .count());
+        ++stats.requests;
+        stats.bytes += req.size;
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cout << "recv exception : " << e.what() << std::endl;
   }
+}
 
-  auto beg = steady_clock::now();
-  auto results = co_await when_all(std::move(futures));
-  auto end = steady_clock::now();
+future<void> client(const config &cfg, const phase &ph, unsigned seed,
+                    thread_stats &stats) {
+  try {
+    auto conn = connector{};
+    conn.set_no_delay();
+    co_await conn.connect(ipv4::address{cfg.port});
+    auto &sock = conn.socket();
 
-  auto this_bytes = std::accumulate(results.begin(), results.end(), 0ull);
-  auto cost_tm = duration_cast<milliseconds>(end - beg);
-  auto this_throughput = (this_bytes / 1024.0) / cost_tm.count();
-  g_throughput += this_throughput;
-  bytes += this_bytes;
+    auto total_conns = cfg.threads * cfg.conns;
+    auto interval = cfg.rate > 0 ? nanoseconds{static_cast<int64_t>(
+                                       1e9 * total_conns / cfg.rate)}
+                                 : nanoseconds{0};
+    connection_state state{};
+    co_await when_all(sender(sock, state, cfg, ph, seed, interval),
+                      receiver(sock, state, cfg, ph, stats));
+  } catch (const std::exception &e) {
+    std::cout << "exception : " << e.what() << std::endl;
+  }
+}
 
-  std::cout << "thread" << this_tid << " pingpong cost " << cost_tm.count()
-            << " ms , "
-            << "throughput " << this_throughput << " MB/S" << std::endl;
+future<void> start_all_conn(io_context &ctx, const config &cfg,
+                            const phase &ph, int tid, thread_stats &stats) {
+  std::vector<future<void>> clients{};
+  for (int i = 0; i < cfg.conns; ++i)
+    clients.emplace_back(client(cfg, ph, tid * cfg.conns + i + 1, stats));
+  co_await when_all(std::move(clients));
   ctx.request_stop();
 }
 
-void start(uint conns, uint times, std::atomic<uint64_t> &bytes) {
-  auto ctx = io_context{
-      // coio::ctx_opt{.sq_polling = true}
-  };
+void start(const config &cfg, const phase &ph, int tid, thread_stats &stats) {
+  auto ctx = io_context{};
   auto _ = ctx.bind_this_thread();
-  ctx.post([&] { ctx.co_spawn(start_all_conn(ctx, conns, times, bytes)); });
-  // ctx.poll();
+  ctx.post([&] { ctx.co_spawn(start_all_conn(ctx, cfg, ph, tid, stats)); });
   ctx.run();
 }
 
-int main(int argc, char *argv[]) {
-
-  // read params "client <thread cnt> <pingpong times> <connection/thread>"
-  if (argc != 5) {
-    std::cout << "[error] expect use : client <thread_cnt>  <echo times>  "
-                 "<connection per thread> <server port>\n";
-    std::cout << "got : ";
-    for (int i = 0; i < argc; ++i)
-      std::cout << argv[i] << " ";
-    std::cout << std::endl;
-    return 1;
+config parse_args(int argc, char *argv[]) {
+  std::map<std::string_view, std::string_view> opts{};
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string_view{argv[i]};
+    auto pos = arg.find('=');
+    if (!arg.starts_with("--") || pos == std::string_view::npos)
+      throw std::invalid_argument{std::string{"bad argument "}.append(arg)};
+    opts[arg.substr(2, pos - 2)] = arg.substr(pos + 1);
   }
+  auto get = [&](std::string_view k, double def) {
+    return opts.contains(k) ? std::atof(std::string{opts[k]}.c_str()) : def;
+  };
 
-  auto thread_cnt = std::atoi(argv[1]);
-  auto echo_times = std::atoi(argv[2]);
-  auto connect_ptd = std::atoi(argv[3]);
-  g_server_port = std::atoi(argv[4]);
+  config cfg{};
+  cfg.port = static_cast<uint16_t>(get("port", cfg.port));
+  cfg.threads = static_cast<int>(get("threads", cfg.threads));
+  cfg.conns = static_cast<int>(get("conns", cfg.conns));
+  cfg.rate = get("rate", cfg.rate);
+  cfg.depth = static_cast<int>(get("depth", cfg.depth));
+  cfg.warmup = seconds{static_cast<int64_t>(get("warmup", 1))};
+  cfg.duration = seconds{static_cast<int64_t>(get("duration", 5))};
+  if (opts.contains("size"))
+    cfg.sizes = size_dist::parse(opts["size"]);
 
-  assert(connect_ptd > 0);
-  assert(thread_cnt > 0);
-  assert(echo_times > 0);
-  assert(g_server_port > 0);
+  if (cfg.threads <= 0 || cfg.conns <= 0 || cfg.depth <= 0 ||
+      cfg.sizes.max() == 0 || cfg.rate < 0)
+    throw std::invalid_argument{"invalid argument value"};
+  return cfg;
+}
 
-  // co_spawn all
-  std::vector<std::thread> tds{};
-  std::atomic<uint64_t> bytes{};
-  auto cnt = thread_cnt;
-  while (cnt--) {
-    tds.emplace_back(
-        std::thread([&] { start(connect_ptd, echo_times, bytes); }));
+int main(int argc, char *argv[]) {
+  config cfg{};
+  try {
+    cfg = parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    std::cout << "[error] " << e.what() << "\n"
+              << "expect use : client [--port=8888] [--threads=1] "
+                 "[--conns=<per thread>] [--rate=<total req/s , 0 closed "
+                 "loop>] [--depth=<pipeline>] [--size=1024|uniform:a:b|"
+                 "exp:mean] [--warmup=1] [--duration=5]"
+              << std::endl;
+    return 1;
   }
 
+  auto now = clock_type::now();
+  auto ph = phase{.start = now,
+                  .measure_beg = now + cfg.warmup,
+                  .measure_end = now + cfg.warmup + cfg.duration};
+
+  auto stats = std::vector<thread_stats>(cfg.threads);
+  std::vector<std::thread> tds{};
+  for (int i = 0; i < cfg.threads; ++i)
+    tds.emplace_back([&, i] { start(cfg, ph, i, stats[i]); });
   for (auto &t : tds)
     t.join();
 
-  std::cout << thread_cnt
-            << " threads client throughput = " << g_throughput.load()
-            << " MB/s , read " << bytes << " bytes." << std::endl;
-}
\ No newline at end of file
+  // merge per thread histograms
+  thread_stats total{};
+  for (auto &s : stats) {
+    total.latency.merge(s.latency);
+    total.requests += s.requests;
+    total.bytes += s.bytes;
+  }
+
+  auto secs = static_cast<double>(cfg.duration.count());
+  auto us = [](uint64_t ns) { return ns / 1000.0; };
+  auto &h = total.latency;
+  std::cout << cfg.threads << " threads , " << cfg.threads * cfg.conns
+            << " connections , depth " << cfg.depth << " , "
+            << (cfg.rate > 0 ? "open loop" : "closed loop") << "\n"
+            << "requests " << total.requests << " , "
+            << total.requests / secs << " req/s (target " << cfg.rate
+            << ") , throughput " << total.bytes / secs / MB << " MB/s\n"
+            << "latency(us) p50 " << us(h.percentile(50)) << " p90 "
+            << us(h.percentile(90)) << " p99 " << us(h.percentile(99))
+            << " p99.9 " << us(h.percentile(99.9)) << " p99.99 "
+            << us(h.percentile(99.99)) << " max " << us(h.max())
+            << std::endl;
+}
@@ -1,73 +1,148 @@
 #include "common/cpu_affinity.hpp"
 #include "future.hpp"
 #include "ioutils/tcp.hpp"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <thread>
 
 using coio::future, coio::io_context;
 using coio::tcp_sock, coio::ipv4, coio::acceptor;
-using coio::to_bytes, coio::to_const_bytes;
 
-future<void> start_session(tcp_sock<> sock, std::atomic<uint32_t> &bytes_read) {
-  // std::cout << "accept connection : " << sock.get_peer_address().to_string()
-  // << std::endl;
+struct config {
+  uint16_t port{8888};
+  int threads{1};
+  int cpu_base{-1};         // thread i is pinned to cpu_base + i , -1 : no pin
+  // connections handled on cpu c go to thread (c - cpu_base) mod threads ,
+  // the thread pinned to c when c is one of them
+  bool cpu_steering{false};
+  std::size_t buffer{16 * 1024};
+  int report{0}; // seconds between per thread reports , 0 : never
+};
+
+// written by its own thread only , read by the reporter
+struct alignas(64) thread_stats {
+  std::atomic<uint64_t> connections{};
+  std::atomic<uint64_t> bytes{};
+};
+
+future<void> start_session(tcp_sock<> sock, std::size_t buffer,
+                           thread_stats &stats) {
   sock.set_no_delay();
-  uint32_t read_cnt{};
   try {
-    auto buff = std::vector<std::byte>(1024);
+    auto buff = std::vector<std::byte>(buffer);
     while (true) {
       auto n = co_await sock.recv(buff);
       if (n == 0)
         break;
-      auto m = co_await sock.send(std::span{buff.begin(), n});
-      assert(m == n);
-      read_cnt += n;
+      for (std::size_t sent = 0; sent < n;)
+        sent += co_await sock.send(std::span{buff.data() + sent, n - sent});
+      stats.bytes.fetch_add(n, std::memory_order_relaxed);
     }
   } catch (const std::exception &e) {
     std::cout << "exception : " << e.what() << std::endl;
   }
-  bytes_read += read_cnt;
 }
 
-future<uint32_t> server(io_context &ctx, std::atomic<uint32_t> &bytes_read) {
+future<void> server(io_context &ctx, acceptor<> &accpt, std::size_t buffer,
+                    thread_stats &stats) {
   try {
-    auto accpt = acceptor{};
-    accpt.bind(ipv4::address{8888});
-    // accpt.set_reuse_port();
-    accpt.listen();
     while (true) {
       auto sock = co_await accpt.accept();
-      ctx.co_spawn(start_session(std::move(sock), bytes_read));
+      stats.connections.fetch_add(1, std::memory_order_relaxed);
+      ctx.co_spawn(start_session(std::move(sock), buffer, stats));
     }
   } catch (const std::exception &e) {
     std::cout << "exception : " << e.what() << std::endl;
   }
 }
 
+void start(const config &cfg, int tid, acceptor<> &accpt,
+           thread_stats &stats) {
+  if (cfg.cpu_base >= 0 && !coio::reset_cpu_affinity(cfg.cpu_base + tid))
+    std::cout << "thread " << tid << " : failed to pin cpu "
+              << cfg.cpu_base + tid << std::endl;
+
+  io_context ctx{};
+  auto _ = ctx.bind_this_thread();
+  ctx.co_spawn(server(ctx, accpt, cfg.buffer, stats));
+  ctx.run();
+}
+
+config parse_args(int argc, char *argv[]) {
+  std::map<std::string_view, std::string_view> opts{};
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string_view{argv[i]};
+    auto pos = arg.find('=');
+    if (!arg.starts_with("--"))
+      throw std::invalid_argument{std::string{"bad argument "}.append(arg)};
+    opts[arg.substr(2, pos - 2)] =
+        pos == std::string_view::npos ? "1" : arg.substr(pos + 1);
+  }
+  auto get = [&](std::string_view k, long def) {
+    return opts.contains(k) ? std::atol(std::string{opts[k]}.c_str()) : def;
+  };
+
+  config cfg{};
+  cfg.port = static_cast<uint16_t>(get("port", cfg.port));
+  cfg.threads = static_cast<int>(get("threads", cfg.threads));
+  cfg.cpu_base = static_cast<int>(get("cpu_base", cfg.cpu_base));
+  cfg.cpu_steering = get("cpu_steering", 0) != 0;
+  cfg.buffer = static_cast<std::size_t>(get("buffer", cfg.buffer));
+  cfg.report = static_cast<int>(get("report", cfg.report));
+
+  if (cfg.threads <= 0 || cfg.buffer == 0 || cfg.report < 0)
+    throw std::invalid_argument{"invalid argument value"};
+  return cfg;
+}
+
 int main(int argc, char *argv[]) {
-  // if(argc!= 2) {
-  //     puts("[error] \n expect parameter : server <thread_cnt> ");
-  //     return 1;
-  // }
+  config cfg{};
+  try {
+    cfg = parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    std::cout << "[error] " << e.what() << "\n"
+              << "expect use : server [--port=8888] [--threads=1] "
+                 "[--cpu_base=<first cpu , -1 no pin>] [--cpu_steering] "
+                 "[--buffer=16384] [--report=<seconds>]"
+              << std::endl;
+    return 1;
+  }
 
-  std::atomic<uint32_t> cnt{};
+  // one listener per thread sharing the port , the kernel spreads incoming
+  // connections among them. bind in thread order , the steering program
+  // picks the listener by its index in the group.
+  auto acceptors = std::vector<acceptor<>>(cfg.threads);
+  for (auto &accpt : acceptors) {
+    accpt.set_reuse_port();
+    accpt.bind(ipv4::address{cfg.port});
+    accpt.listen();
+  }
+  if (cfg.cpu_steering)
+    acceptors.front().set_reuse_port_cpu_steering(
+        cfg.threads, static_cast<uint32_t>(std::max(cfg.cpu_base, 0)));
 
-  // auto thread_cnt = std::atoi(argv[1]);
-  // assert(thread_cnt > 0);
-  // auto tds = std::vector<std::thread>(thread_cnt);
-  // for(auto & t : tds ){
-  //     t = std::thread([&](){
+  auto stats = std::vector<thread_stats>(cfg.threads);
+  std::vector<std::jthread> tds{};
+  for (int i = 0; i < cfg.threads; ++i)
+    tds.emplace_back([&, i] { start(cfg, i, acceptors[i], stats[i]); });
 
-  io_context ctx{
-      // coio::ctx_opt{.sq_cpu_affinity = 1 , .sq_polling = true}
-  };
-  auto _ = ctx.bind_this_thread();
-  ctx.co_spawn(server(ctx, cnt));
-  ctx.run();
-  // ctx.poll();
+  if (cfg.report == 0)
+    return 0; // joins server threads , run until killed
 
-  // });
-  // }
-  // for(auto & t : tds) t.join();
-}
\ No newline at end of file
+  auto last = std::vector<uint64_t>(cfg.threads);
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds{cfg.report});
+    for (int i = 0; i < cfg.threads; ++i) {
+      auto bytes = stats[i].bytes.load(std::memory_order_relaxed);
+      std::cout << "thread " << i << " : connections "
+                << stats[i].connections.load(std::memory_order_relaxed)
+                << " , " << (bytes - last[i]) / cfg.report / 1024.0 / 1024.0
+                << " MB/s\n";
+      last[i] = bytes;
+    }
+    std::cout << std::flush;
+  }
+}
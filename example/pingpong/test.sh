@@ -3,10 +3,14 @@
 killall pingpong_server
 for connections in 1000 ; do
     sleep 1
-    ./pingpong_server > ./server_log.txt 2>&1 & srvpid=$!
+    ./pingpong_server --threads=2 --cpu_base=0 --cpu_steering > ./server_log.txt 2>&1 & srvpid=$!
     echo ------- connections per thread: $connections ---------
     sleep 1
-    taskset -c 2,3 ./pingpong_client 4 500 $connections 8888
+    # closed loop throughput
+    taskset -c 2,3 ./pingpong_client --threads=4 --conns=$connections --port=8888
+    # open loop latency at a fixed request rate
+    taskset -c 2,3 ./pingpong_client --threads=4 --conns=$connections --port=8888 \
+        --rate=200000 --size=uniform:64:1024
     echo =-----------------------------------------------------
     kill -9 $srvpid
 
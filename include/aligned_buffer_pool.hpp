@@ -0,0 +1,137 @@
+#ifndef COIO_ALIGNED_BUFFER_POOL_HPP
+#define COIO_ALIGNED_BUFFER_POOL_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+#include "system_error.hpp"
+
+namespace coio {
+
+// buffers of one size , their address and size multiples of alignment , as
+// O_DIRECT io wants them (see direct_file). carved from slabs mapped when the
+// pool runs dry , a released buffer is reused , the memory goes back with
+// the pool.
+//
+//  auto pool = aligned_buffer_pool{64 * 1024};
+//  auto buf = pool.acquire();
+//  co_await f.read(buf, off);
+//  // buf goes back to the pool
+//
+// used on one thread , destroyed after its buffers.
+class aligned_buffer_pool : non_copyable {
+public:
+  static constexpr std::size_t huge_page_size = 2 << 20;
+
+  // buffer_size : rounded up to alignment
+  // alignment : a power of 2 , at most a page
+  // huge_pages : slabs of 2 MiB huge pages (MAP_HUGETLB , needs pages in
+  //              /proc/sys/vm/nr_hugepages) , else transparent huge pages
+  //              are asked for
+  explicit aligned_buffer_pool(std::size_t buffer_size,
+                               std::size_t alignment = 4096,
+                               bool huge_pages = false)
+      : m_alignment(alignment), m_huge(huge_pages), m_hugetlb(huge_pages) {
+    auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    if (!std::has_single_bit(alignment) || alignment > page)
+      throw std::invalid_argument{"alignment must be a power of 2 , at most "
+                                  "a page."};
+    if (buffer_size == 0)
+      throw std::invalid_argument{"buffer size must not be 0."};
+    m_size = (buffer_size + alignment - 1) & ~(alignment - 1);
+    auto slab = huge_pages ? huge_page_size : std::size_t{64 * 1024};
+    m_slab_size = (std::max(m_size, slab) + slab - 1) / slab * slab;
+  }
+
+  ~aligned_buffer_pool() {
+    for (auto [ptr, len] : m_slabs)
+      ::munmap(ptr, len);
+  }
+
+  // a buffer back in the pool when destroyed
+  class buffer : non_copyable {
+  public:
+    buffer(aligned_buffer_pool &pool, std::byte *data) noexcept
+        : m_pool(&pool), m_data(data) {}
+    buffer(buffer &&other) noexcept
+        : m_pool(std::exchange(other.m_pool, nullptr)),
+          m_data(std::exchange(other.m_data, nullptr)) {}
+    ~buffer() {
+      if (m_pool)
+        m_pool->m_idle.push_back(m_data);
+    }
+
+    std::byte *data() noexcept { return m_data; }
+    const std::byte *data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_pool ? m_pool->m_size : 0; }
+
+    // the first n bytes , n a multiple of the alignment for direct io
+    std::span<std::byte> first(std::size_t n) noexcept { return {m_data, n}; }
+
+  private:
+    aligned_buffer_pool *m_pool;
+    std::byte *m_data;
+  };
+
+public:
+  buffer acquire() {
+    if (m_idle.empty())
+      grow();
+    auto *data = m_idle.back();
+    m_idle.pop_back();
+    return buffer{*this, data};
+  }
+
+  std::size_t buffer_size() const noexcept { return m_size; }
+  std::size_t alignment() const noexcept { return m_alignment; }
+  std::size_t idle() const noexcept { return m_idle.size(); }
+  // the slabs are MAP_HUGETLB pages , false once they were not available
+  bool huge_pages() const noexcept { return m_hugetlb; }
+
+private:
+  void grow() {
+    void *slab = MAP_FAILED;
+    auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (m_hugetlb) {
+      slab = ::mmap(nullptr, m_slab_size, PROT_READ | PROT_WRITE,
+                    flags | MAP_HUGETLB, -1, 0);
+      m_hugetlb = slab != MAP_FAILED;
+    }
+    if (slab == MAP_FAILED) {
+      slab = ::mmap(nullptr, m_slab_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (slab == MAP_FAILED)
+        throw make_system_error(errno);
+      if (m_huge)
+        (void)::madvise(slab, m_slab_size, MADV_HUGEPAGE);
+    }
+    m_slabs.emplace_back(slab, m_slab_size);
+    auto per_slab = m_slab_size / m_size;
+    // room for every buffer , a release never allocates
+    m_idle.reserve(m_slabs.size() * per_slab);
+    auto *base = static_cast<std::byte *>(slab);
+    // handed out from the front of the slab first
+    for (auto n = per_slab; n-- > 0;)
+      m_idle.push_back(base + n * m_size);
+  }
+
+private:
+  std::size_t m_size;
+  std::size_t m_alignment;
+  std::size_t m_slab_size;
+  bool m_huge;
+  bool m_hugetlb;
+  std::vector<std::byte *> m_idle{};
+  std::vector<std::pair<void *, std::size_t>> m_slabs{};
+};
+
+} // namespace coio
+
+#endif
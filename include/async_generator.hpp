@@ -0,0 +1,124 @@
+#ifndef COIO_ASYNC_GENERATOR_HPP
+#define COIO_ASYNC_GENERATOR_HPP
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "common/non_copyable.hpp"
+
+namespace coio {
+
+// a generator which may co_await between its values ,
+// e.g. slices of a body read from a socket. values are pulled one by one :
+//
+//  while (auto *v = co_await gen.next())
+//    use(*v);
+//
+// a yielded value is valid until the next one is asked for.
+template <class T> class async_generator : private non_copyable {
+public:
+  using value_type = std::remove_reference_t<T>;
+
+  class promise_type {
+    // hands control back to the consumer waiting in next()
+    struct to_consumer {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+        return handle.promise().m_consumer;
+      }
+      void await_resume() const noexcept {}
+    };
+
+  public:
+    constexpr auto initial_suspend() const noexcept {
+      return std::suspend_always{};
+    }
+    constexpr auto final_suspend() const noexcept { return to_consumer{}; }
+
+    auto yield_value(value_type &value) noexcept {
+      m_value_ptr = std::addressof(value);
+      return to_consumer{};
+    }
+
+    auto yield_value(value_type &&value) noexcept {
+      m_value_ptr = std::addressof(value);
+      return to_consumer{};
+    }
+
+    async_generator get_return_object() noexcept {
+      return async_generator{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept {
+      m_exception = std::current_exception();
+    }
+
+  private:
+    friend class async_generator;
+    value_type *m_value_ptr{};
+    std::coroutine_handle<> m_consumer{};
+    std::exception_ptr m_exception{};
+  };
+
+private:
+  explicit async_generator(std::coroutine_handle<promise_type> handle) noexcept
+      : m_handle(handle) {}
+
+public:
+  async_generator(async_generator &&other) noexcept
+      : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+  async_generator &operator=(async_generator &&other) noexcept {
+    if (this != std::addressof(other)) {
+      this->~async_generator();
+      m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  ~async_generator() {
+    if (m_handle)
+      m_handle.destroy();
+    m_handle = nullptr;
+  }
+
+  // runs the generator to its next value.
+  // nullptr once it returned , rethrows what escaped from it.
+  auto next() noexcept {
+    struct awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() const noexcept { return !handle || handle.done(); }
+
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> consumer) noexcept {
+        handle.promise().m_consumer = consumer;
+        return handle;
+      }
+
+      value_type *await_resume() {
+        if (!handle)
+          return nullptr;
+        auto &promise = handle.promise();
+        if (promise.m_exception)
+          std::rethrow_exception(std::exchange(promise.m_exception, nullptr));
+        return handle.done() ? nullptr : promise.m_value_ptr;
+      }
+    };
+    return awaiter{m_handle};
+  }
+
+private:
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+} // namespace coio
+
+#endif
@@ -2,12 +2,14 @@
 #define COIO_BUFFER_HPP
 
 #include <array>
+#include <climits>
 #include <concepts>
 #include <cstddef>
+#include <memory>
 #include <ranges>
 #include <span>
+#include <stdexcept>
 #include <sys/uio.h>
-#include <vector>
 
 namespace coio {
 
@@ -44,27 +46,50 @@ auto to_bytes(T &t) noexcept -> concepts::writeable_buffer auto {
   return std::as_writable_bytes(std::span{t});
 }
 
-template <concepts::buffer... T> auto make_iovecs(T &&...buff) noexcept {
-  return std::array<::iovec, sizeof...(T)>{
-      ::iovec{.iov_base = const_cast<void *>((const void *)buff.data()),
-              .iov_len = buff.size()}...,
-  };
+// iovec array keeping the first N entries inline ,
+// only longer runtime sequences (up to IOV_MAX) spill to the heap.
+template <std::size_t N> class inline_iovecs {
+public:
+  explicit inline_iovecs(std::size_t capacity) {
+    if (capacity > IOV_MAX)
+      throw std::length_error{"too many buffers for one vectored io."};
+    if (capacity > N)
+      m_heap = std::make_unique_for_overwrite<::iovec[]>(capacity);
+  }
+
+  // data() is recomputed after move , inline storage moves with the object
+  inline_iovecs(inline_iovecs &&) noexcept = default;
+  inline_iovecs &operator=(inline_iovecs &&) noexcept = default;
+
+  void push_back(const ::iovec &iov) noexcept { data()[m_size++] = iov; }
+
+  ::iovec *data() noexcept { return m_heap ? m_heap.get() : m_inline.data(); }
+  const ::iovec *data() const noexcept {
+    return m_heap ? m_heap.get() : m_inline.data();
+  }
+  std::size_t size() const noexcept { return m_size; }
+
+private:
+  std::array<::iovec, N> m_inline;
+  std::unique_ptr<::iovec[]> m_heap{};
+  std::size_t m_size{};
+};
+
+template <class T> ::iovec to_iovec(T &&buff) noexcept {
+  return {.iov_base = const_cast<void *>((const void *)buff.data()),
+          .iov_len = buff.size()};
 }
 
-template <concepts::buffer... T>
-  requires(sizeof...(T) > 2)
-auto make_iovecs(T &&...buff) {
-  std::vector<::iovec> iovecs{};
-  iovecs.reserve(sizeof...(T));
-  (iovecs.emplace_back(buff.data(), buff.size()), ...);
-  return iovecs;
+// buffer count is known at compile time , never allocates.
+template <concepts::buffer... T> auto make_iovecs(T &&...buff) noexcept {
+  return std::array<::iovec, sizeof...(T)>{to_iovec(buff)...};
 }
 
-template <concepts::buffer_sequence T> auto make_iovecs(T &&buffs) {
-  std::vector<::iovec> iovecs{};
-  iovecs.reserve(buffs.size());
+template <std::size_t N = 8, concepts::buffer_sequence T>
+auto make_iovecs(T &&buffs) {
+  auto iovecs = inline_iovecs<N>{std::ranges::size(buffs)};
   for (auto &b : buffs)
-    iovecs.emplace_back(b.data(), b.size());
+    iovecs.push_back(to_iovec(b));
   return iovecs;
 }
 
@@ -0,0 +1,346 @@
+#ifndef COIO_CHAINED_BUFFER_HPP
+#define COIO_CHAINED_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "buffer.hpp"
+#include "common/non_copyable.hpp"
+
+namespace coio {
+
+namespace details {
+
+// fixed size , reference counted block. bytes follow the header.
+struct buffer_segment {
+  std::atomic<uint32_t> refs{1};
+  uint32_t capacity{};
+
+  std::byte *data() noexcept { return reinterpret_cast<std::byte *>(this + 1); }
+};
+
+// per thread free list of segments , bounded.
+// a segment released on another thread just joins that thread's list.
+class segment_pool : non_copyable {
+public:
+  static constexpr uint32_t segment_size = 16 * 1024;
+  static constexpr std::size_t max_cached = 64;
+
+  static segment_pool &this_thread() {
+    thread_local segment_pool pool{};
+    return pool;
+  }
+
+  segment_pool() { m_free.reserve(max_cached); }
+  ~segment_pool() {
+    for (auto *s : m_free)
+      ::operator delete(s);
+  }
+
+  buffer_segment *acquire() {
+    if (m_free.empty())
+      return allocate(segment_size);
+    auto *s = m_free.back();
+    m_free.pop_back();
+    s->refs.store(1, std::memory_order_relaxed);
+    return s;
+  }
+
+  // a pooled segment if it fits , else one allocated to size (not cached)
+  buffer_segment *acquire(std::size_t capacity) {
+    if (capacity <= segment_size)
+      return acquire();
+    if (capacity > UINT32_MAX)
+      throw std::length_error{"buffer segment too large"};
+    return allocate(static_cast<uint32_t>(capacity));
+  }
+
+  void recycle(buffer_segment *s) noexcept {
+    if (s->capacity == segment_size && m_free.size() < max_cached)
+      m_free.push_back(s); // never reallocates , reserved
+    else
+      ::operator delete(s);
+  }
+
+private:
+  static buffer_segment *allocate(uint32_t capacity) {
+    auto mem = ::operator new(sizeof(buffer_segment) + capacity);
+    return new (mem) buffer_segment{.capacity = capacity};
+  }
+
+private:
+  std::vector<buffer_segment *> m_free{};
+};
+
+inline void retain(buffer_segment *s) noexcept {
+  s->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void release(buffer_segment *s) noexcept {
+  if (s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    segment_pool::this_thread().recycle(s);
+}
+
+} // namespace details
+
+// a read only view into one segment , keeps the segment alive.
+// copying only bumps the reference count.
+class buffer_slice {
+  friend class chained_buffer;
+
+public:
+  buffer_slice() = default;
+  buffer_slice(details::buffer_segment *seg, std::byte *ptr,
+               std::size_t len) noexcept
+      : m_seg(seg), m_ptr(ptr), m_len(len) {
+    details::retain(seg);
+  }
+
+  buffer_slice(const buffer_slice &other) noexcept
+      : m_seg(other.m_seg), m_ptr(other.m_ptr), m_len(other.m_len) {
+    if (m_seg)
+      details::retain(m_seg);
+  }
+  buffer_slice(buffer_slice &&other) noexcept
+      : m_seg(std::exchange(other.m_seg, nullptr)), m_ptr(other.m_ptr),
+        m_len(std::exchange(other.m_len, 0)) {}
+
+  buffer_slice &operator=(buffer_slice other) noexcept {
+    std::swap(m_seg, other.m_seg);
+    std::swap(m_ptr, other.m_ptr);
+    std::swap(m_len, other.m_len);
+    return *this;
+  }
+
+  ~buffer_slice() {
+    if (m_seg)
+      details::release(m_seg);
+  }
+
+public:
+  const std::byte *data() const noexcept { return m_ptr; }
+  std::size_t size() const noexcept { return m_len; }
+
+  std::string_view view() const noexcept {
+    return {reinterpret_cast<const char *>(m_ptr), m_len};
+  }
+
+  buffer_slice prefix(std::size_t n) const noexcept {
+    return m_seg ? buffer_slice{m_seg, m_ptr, std::min(n, m_len)}
+                 : buffer_slice{};
+  }
+
+  void remove_prefix(std::size_t n) noexcept {
+    n = std::min(n, m_len);
+    m_ptr += n;
+    m_len -= n;
+  }
+
+private:
+  details::buffer_segment *m_seg{};
+  std::byte *m_ptr{};
+  std::size_t m_len{};
+};
+
+// segmented byte queue over pooled segments :
+//  append : prepare() / commit() write into the tail segment , new segments
+//           are chained when it is full , nothing is ever moved.
+//  consume : drops slices from the front , segments go back to the pool
+//           once no slice refers to them.
+//  split : hands the first n bytes off as another chain without copying.
+//
+//  sock.recvmsg(buf.prepare(n)) , sock.sendmsg(buf.slices())
+class chained_buffer : non_copyable {
+public:
+  chained_buffer() = default;
+  chained_buffer(chained_buffer &&other) noexcept
+      : m_slices(std::move(other.m_slices)),
+        m_tail(std::exchange(other.m_tail, nullptr)),
+        m_tail_pos(std::exchange(other.m_tail_pos, 0)),
+        m_reserved(std::move(other.m_reserved)),
+        m_size(std::exchange(other.m_size, 0)) {}
+
+  chained_buffer &operator=(chained_buffer &&other) noexcept {
+    auto tmp = chained_buffer{std::move(other)};
+    std::swap(m_slices, tmp.m_slices);
+    std::swap(m_tail, tmp.m_tail);
+    std::swap(m_tail_pos, tmp.m_tail_pos);
+    std::swap(m_reserved, tmp.m_reserved);
+    std::swap(m_size, tmp.m_size);
+    return *this;
+  }
+
+  ~chained_buffer() {
+    release_write_area();
+    if (m_tail)
+      details::release(m_tail);
+  }
+
+public:
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  // readable bytes , a buffer_sequence
+  const std::deque<buffer_slice> &slices() const noexcept { return m_slices; }
+
+  // writeable space of at least n bytes , a writeable_buffer_sequence.
+  // valid until the next prepare / commit.
+  auto prepare(std::size_t n) -> std::span<const std::span<std::byte>> {
+    release_write_area();
+    if (!m_tail || m_tail_pos == m_tail->capacity) {
+      if (m_tail)
+        details::release(m_tail);
+      m_tail = details::segment_pool::this_thread().acquire();
+      m_tail_pos = 0;
+    }
+    auto avail = m_tail->capacity - m_tail_pos;
+    m_prepared.emplace_back(m_tail->data() + m_tail_pos, avail);
+    for (std::size_t total = avail; total < n;) {
+      auto *seg = details::segment_pool::this_thread().acquire();
+      m_reserved.push_back(seg);
+      m_prepared.emplace_back(seg->data(), seg->capacity);
+      total += seg->capacity;
+    }
+    return m_prepared;
+  }
+
+  // make n bytes written into the last prepare() readable
+  void commit(std::size_t n) {
+    n = append_tail(n);
+    for (auto &seg : m_reserved) {
+      if (n == 0)
+        break;
+      details::release(m_tail);
+      m_tail = seg;
+      m_tail_pos = 0;
+      seg = nullptr; // ownership moved to m_tail
+      n = append_tail(n);
+    }
+    release_write_area();
+  }
+
+  void consume(std::size_t n) noexcept {
+    while (n > 0 && !m_slices.empty()) {
+      auto &front = m_slices.front();
+      auto k = std::min(n, front.size());
+      front.remove_prefix(k);
+      if (front.size() == 0)
+        m_slices.pop_front();
+      n -= k;
+      m_size -= k;
+    }
+  }
+
+  // move the first n bytes into a new chain , no byte is copied
+  chained_buffer split(std::size_t n) {
+    chained_buffer head{};
+    while (n > 0 && !m_slices.empty()) {
+      auto &front = m_slices.front();
+      if (front.size() <= n) {
+        n -= front.size();
+        head.append(std::move(front));
+        m_size -= head.m_slices.back().size();
+        m_slices.pop_front();
+      } else {
+        head.append(front.prefix(n));
+        front.remove_prefix(n);
+        m_size -= n;
+        n = 0;
+      }
+    }
+    return head;
+  }
+
+  void append(buffer_slice slice) {
+    if (slice.size() == 0)
+      return;
+    m_size += slice.size();
+    m_slices.push_back(std::move(slice));
+  }
+
+  void append(chained_buffer &&other) {
+    for (auto &s : other.m_slices)
+      append(std::move(s));
+    other.m_slices.clear();
+    other.m_size = 0;
+  }
+
+  // offset of the first byte equal to c
+  std::optional<std::size_t> find(char c) const noexcept {
+    std::size_t off{};
+    for (auto &s : m_slices) {
+      if (auto p = std::memchr(s.data(), c, s.size()))
+        return off + (static_cast<const std::byte *>(p) - s.data());
+      off += s.size();
+    }
+    return {};
+  }
+
+  // copy out the first min(size() , out.size()) bytes
+  std::size_t copy_to(std::span<std::byte> out) const noexcept {
+    std::size_t n{};
+    for (auto &s : m_slices) {
+      if (n == out.size())
+        break;
+      auto k = std::min(s.size(), out.size() - n);
+      std::memcpy(out.data() + n, s.data(), k);
+      n += k;
+    }
+    return n;
+  }
+
+  std::string to_string() const {
+    auto str = std::string(m_size, '\0');
+    copy_to(std::as_writable_bytes(std::span{str}));
+    return str;
+  }
+
+private:
+  // commit up to n bytes of the tail write area , return the rest
+  std::size_t append_tail(std::size_t n) {
+    auto k = std::min<std::size_t>(n, m_tail ? m_tail->capacity - m_tail_pos
+                                             : 0);
+    if (k == 0)
+      return n;
+    auto ptr = m_tail->data() + m_tail_pos;
+    if (!m_slices.empty() && m_slices.back().m_seg == m_tail &&
+        m_slices.back().m_ptr + m_slices.back().m_len == ptr)
+      m_slices.back().m_len += k; // grow the last slice in place
+    else
+      m_slices.emplace_back(m_tail, ptr, k);
+    m_tail_pos += k;
+    m_size += k;
+    return n - k;
+  }
+
+  void release_write_area() noexcept {
+    for (auto *seg : m_reserved)
+      if (seg)
+        details::release(seg);
+    m_reserved.clear();
+    m_prepared.clear();
+  }
+
+private:
+  std::deque<buffer_slice> m_slices{};
+  // write area : [m_tail_pos , capacity) of m_tail , then m_reserved
+  details::buffer_segment *m_tail{};
+  uint32_t m_tail_pos{};
+  std::vector<details::buffer_segment *> m_reserved{};
+  std::vector<std::span<std::byte>> m_prepared{};
+  std::size_t m_size{};
+};
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef COIO_LATENCY_HISTOGRAM_HPP
+#define COIO_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace coio {
+
+// log-linear histogram (HDR-like) for latency values in nanoseconds.
+// every power of two range is split into 2^sub_bits linear sub buckets ,
+// so relative error of a recorded value is below 1 / 2^sub_bits (~3%).
+// values above 2^max_bits are clamped into the last bucket.
+// not thread safe , use one histogram per thread and merge() them.
+class latency_histogram {
+public:
+  static inline constexpr unsigned sub_bits = 5;
+  static inline constexpr unsigned max_bits = 40; // ~18 minutes in ns
+  static inline constexpr std::size_t sub_count = std::size_t{1} << sub_bits;
+  static inline constexpr std::size_t bucket_count =
+      (max_bits - sub_bits + 1) * sub_count;
+
+public:
+  void record(uint64_t v, uint64_t n = 1) noexcept {
+    m_counts[index_of(v)] += n;
+    m_total += n;
+    m_min = std::min(m_min, v);
+    m_max = std::max(m_max, v);
+    m_sum += v * n;
+  }
+
+  void merge(const latency_histogram &other) noexcept {
+    for (std::size_t i = 0; i < bucket_count; ++i)
+      m_counts[i] += other.m_counts[i];
+    m_total += other.m_total;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+  }
+
+  void reset() noexcept { *this = latency_histogram{}; }
+
+  uint64_t count() const noexcept { return m_total; }
+  uint64_t min() const noexcept { return m_total ? m_min : 0; }
+  uint64_t max() const noexcept { return m_max; }
+  double mean() const noexcept {
+    return m_total ? static_cast<double>(m_sum) / m_total : 0.0;
+  }
+
+  // p in [0 , 100] , returns the upper bound of the bucket holding the
+  // p-th percentile value (clamped by the recorded max).
+  uint64_t percentile(double p) const noexcept {
+    if (m_total == 0)
+      return 0;
+    auto rank = static_cast<uint64_t>(p / 100.0 * m_total + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, m_total);
+    uint64_t acc{};
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      acc += m_counts[i];
+      if (acc >= rank)
+        return i + 1 == bucket_count ? m_max
+                                     : std::min(upper_bound_of(i), m_max);
+    }
+    return m_max;
+  }
+
+  // visit all non empty buckets : f(lower , upper , count)
+  template <class F> void for_each_bucket(F &&f) const {
+    for (std::size_t i = 0; i < bucket_count; ++i)
+      if (m_counts[i])
+        f(lower_bound_of(i), upper_bound_of(i), m_counts[i]);
+  }
+
+private:
+  static constexpr std::size_t index_of(uint64_t v) noexcept {
+    if (v < sub_count)
+      return v;
+    unsigned exp = std::bit_width(v) - 1; // >= sub_bits
+    if (exp >= max_bits)
+      return bucket_count - 1;
+    auto sub = (v >> (exp - sub_bits)) & (sub_count - 1);
+    return (exp - sub_bits + 1) * sub_count + sub;
+  }
+
+  static constexpr uint64_t lower_bound_of(std::size_t i) noexcept {
+    if (i < sub_count)
+      return i;
+    unsigned exp = i / sub_count + sub_bits - 1;
+    auto sub = i % sub_count;
+    return (uint64_t{1} << exp) + (sub << (exp - sub_bits));
+  }
+
+  static constexpr uint64_t upper_bound_of(std::size_t i) noexcept {
+    if (i < sub_count)
+      return i;
+    unsigned exp = i / sub_count + sub_bits - 1;
+    return lower_bound_of(i) + (uint64_t{1} << (exp - sub_bits)) - 1;
+  }
+
+private:
+  std::array<uint64_t, bucket_count> m_counts{};
+  uint64_t m_total{};
+  uint64_t m_min{std::numeric_limits<uint64_t>::max()};
+  uint64_t m_max{};
+  uint64_t m_sum{};
+};
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef COIO_STRING_SEARCH_HPP
+#define COIO_STRING_SEARCH_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define COIO_SEARCH_X86
+#endif
+
+namespace coio {
+
+namespace details::search {
+
+inline constexpr auto npos = std::string_view::npos;
+
+inline constexpr char ascii_lower(char c) noexcept {
+  return static_cast<unsigned char>(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+// ---- scalar , any target ----
+
+// first occurrence of p[0 , k) in s[0 , n) , k >= 2
+inline std::size_t find_scalar(const char *s, std::size_t n, const char *p,
+                               std::size_t k) noexcept {
+  for (std::size_t i = 0; i + k <= n;) {
+    auto hit = std::memchr(s + i, p[0], n - k + 1 - i);
+    if (!hit)
+      break;
+    i = static_cast<const char *>(hit) - s;
+    if (std::memcmp(s + i + 1, p + 1, k - 1) == 0)
+      return i;
+    ++i;
+  }
+  return npos;
+}
+
+inline bool iequals_scalar(const char *a, const char *b,
+                           std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; ++i)
+    if (ascii_lower(a[i]) != ascii_lower(b[i]))
+      return false;
+  return true;
+}
+
+#ifdef COIO_SEARCH_X86
+
+// ---- vector , first + last byte filter ----
+// compare a block against needle[0] and the block shifted by k - 1 against
+// needle[k - 1] , only candidates passing both are checked by memcmp.
+// sse2 is part of x86_64 , avx2 is picked at runtime.
+
+// 0x20 on every byte in 'A'..'Z' : c + 128 - 'A' < -128 + 26 , signed
+inline __m128i upper_bits_sse2(__m128i x) noexcept {
+  auto shifted = _mm_add_epi8(x, _mm_set1_epi8(static_cast<char>(128 - 'A')));
+  auto upper = _mm_cmpgt_epi8(_mm_set1_epi8(-128 + 26), shifted);
+  return _mm_and_si128(upper, _mm_set1_epi8(0x20));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+upper_bits_avx2(__m256i x) noexcept {
+  auto shifted =
+      _mm256_add_epi8(x, _mm256_set1_epi8(static_cast<char>(128 - 'A')));
+  auto upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_and_si256(upper, _mm256_set1_epi8(0x20));
+}
+
+inline std::size_t find_sse2(const char *s, std::size_t n, const char *p,
+                             std::size_t k) noexcept {
+  const auto first = _mm_set1_epi8(p[0]);
+  const auto last = _mm_set1_epi8(p[k - 1]);
+  std::size_t i = 0;
+  for (; i + k - 1 + 16 <= n; i += 16) {
+    auto bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    auto bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + k - 1));
+    unsigned mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl)));
+    for (; mask != 0; mask &= mask - 1) {
+      auto pos = i + __builtin_ctz(mask);
+      if (std::memcmp(s + pos + 1, p + 1, k - 2) == 0)
+        return pos;
+    }
+  }
+  auto r = find_scalar(s + i, n - i, p, k);
+  return r == npos ? npos : i + r;
+}
+
+__attribute__((target("avx2"))) inline std::size_t
+find_avx2(const char *s, std::size_t n, const char *p, std::size_t k) noexcept {
+  const auto first = _mm256_set1_epi8(p[0]);
+  const auto last = _mm256_set1_epi8(p[k - 1]);
+  std::size_t i = 0;
+  for (; i + k - 1 + 32 <= n; i += 32) {
+    auto bf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+    auto bl =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i + k - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl)));
+    for (; mask != 0; mask &= mask - 1) {
+      auto pos = i + __builtin_ctz(mask);
+      if (std::memcmp(s + pos + 1, p + 1, k - 2) == 0)
+        return pos;
+    }
+  }
+  // at most 32 + k bytes left , finish with 16 byte blocks
+  auto r = find_sse2(s + i, n - i, p, k);
+  return r == npos ? npos : i + r;
+}
+
+inline bool iequals_sse2(const char *a, const char *b,
+                         std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    va = _mm_or_si128(va, upper_bits_sse2(va));
+    vb = _mm_or_si128(vb, upper_bits_sse2(vb));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff)
+      return false;
+  }
+  return iequals_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline bool
+iequals_avx2(const char *a, const char *b, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    va = _mm256_or_si256(va, upper_bits_avx2(va));
+    vb = _mm256_or_si256(vb, upper_bits_avx2(vb));
+    if (static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(va, vb))) != 0xffffffffu)
+      return false;
+  }
+  return iequals_sse2(a + i, b + i, n - i);
+}
+
+inline bool has_avx2() noexcept {
+  static const bool avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return avx2;
+}
+
+#else
+
+inline bool has_avx2() noexcept { return false; }
+
+#endif
+
+using find_fn = std::size_t (*)(const char *, std::size_t, const char *,
+                                std::size_t) noexcept;
+using iequals_fn = bool (*)(const char *, const char *, std::size_t) noexcept;
+
+// resolved once per process
+inline find_fn best_find() noexcept {
+#ifdef COIO_SEARCH_X86
+  static const find_fn fn = has_avx2() ? find_avx2 : find_sse2;
+  return fn;
+#else
+  return find_scalar;
+#endif
+}
+
+inline iequals_fn best_iequals() noexcept {
+#ifdef COIO_SEARCH_X86
+  static const iequals_fn fn = has_avx2() ? iequals_avx2 : iequals_sse2;
+  return fn;
+#else
+  return iequals_scalar;
+#endif
+}
+
+} // namespace details::search
+
+// same result as s.find(needle , from) , vectorized for needles of 2+ bytes
+// ("\r\n\r\n" , multipart boundaries ...) , memchr for a single byte.
+inline std::size_t find_delimiter(std::string_view s, std::string_view needle,
+                                  std::size_t from = 0) noexcept {
+  using namespace details::search;
+  if (from > s.size())
+    return npos;
+  if (needle.empty())
+    return from;
+  if (s.size() - from < needle.size())
+    return npos;
+  if (needle.size() == 1) {
+    auto p = std::memchr(s.data() + from, needle[0], s.size() - from);
+    return p ? static_cast<const char *>(p) - s.data() : npos;
+  }
+  auto r = best_find()(s.data() + from, s.size() - from, needle.data(),
+                       needle.size());
+  return r == npos ? npos : from + r;
+}
+
+// ascii case insensitive equality , e.g. http header names
+inline bool ascii_iequals(std::string_view a, std::string_view b) noexcept {
+  using namespace details::search;
+  if (a.size() != b.size())
+    return false;
+  // most header names are shorter than one vector
+  if (a.size() < 16)
+    return iequals_scalar(a.data(), b.data(), a.size());
+  return best_iequals()(a.data(), b.data(), a.size());
+}
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef COIO_IO_TRACE_HPP
+#define COIO_IO_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <liburing.h>
+#include <unistd.h>
+
+#include "common/latency_histogram.hpp"
+#include "common/non_copyable.hpp"
+
+// per operation latency tracing of io_context.
+// define COIO_IO_TRACING (see DEFINE in makefile) to compile it into
+// io_context , otherwise io_awaiter has no tracing overhead at all.
+
+namespace coio {
+
+enum class io_op : uint8_t {
+  recv,
+  send,
+  accept,
+  connect,
+  read,
+  write,
+  timeout,
+  other,
+};
+
+inline constexpr std::size_t io_op_count =
+    static_cast<std::size_t>(io_op::other) + 1;
+
+constexpr std::string_view to_str(io_op op) noexcept {
+  constexpr std::array<std::string_view, io_op_count> names{
+      "recv", "send", "accept", "connect", "read", "write", "timeout", "other"};
+  return names[static_cast<std::size_t>(op)];
+}
+
+constexpr io_op to_io_op(uint8_t opcode) noexcept {
+  switch (opcode) {
+  case IORING_OP_RECV:
+  case IORING_OP_RECVMSG:
+    return io_op::recv;
+  case IORING_OP_SEND:
+  case IORING_OP_SENDMSG:
+    return io_op::send;
+  case IORING_OP_ACCEPT:
+    return io_op::accept;
+  case IORING_OP_CONNECT:
+    return io_op::connect;
+  case IORING_OP_READ:
+  case IORING_OP_READV:
+  case IORING_OP_READ_FIXED:
+    return io_op::read;
+  case IORING_OP_WRITE:
+  case IORING_OP_WRITEV:
+  case IORING_OP_WRITE_FIXED:
+    return io_op::write;
+  case IORING_OP_TIMEOUT:
+    return io_op::timeout;
+  default:
+    return io_op::other;
+  }
+}
+
+// one traced operation , all timestamps are steady clock nanoseconds.
+//  submit : sqe filled in await_suspend
+//  reap   : cqe batch taken from completion queue
+//  resume : right before the awaiting coroutine is resumed
+struct io_trace_event {
+  uint64_t submit_ns;
+  uint64_t reap_ns;
+  uint64_t resume_ns;
+  int32_t res;
+  io_op op;
+};
+
+// latency histograms aggregated by io_context
+//  kernel : submit -> reap , time spent in io_uring
+//  queue  : reap -> resume , time waiting behind other ready coroutines
+//  total  : submit -> resume
+struct io_trace_stats {
+  struct op_stats {
+    latency_histogram kernel;
+    latency_histogram queue;
+    latency_histogram total;
+  };
+
+  void record(const io_trace_event &e) noexcept {
+    auto &s = ops[static_cast<std::size_t>(e.op)];
+    s.kernel.record(e.reap_ns - e.submit_ns);
+    s.queue.record(e.resume_ns - e.reap_ns);
+    s.total.record(e.resume_ns - e.submit_ns);
+  }
+
+  const op_stats &operator[](io_op op) const noexcept {
+    return ops[static_cast<std::size_t>(op)];
+  }
+
+  void reset() noexcept {
+    for (auto &s : ops)
+      s = op_stats{};
+  }
+
+  std::array<op_stats, io_op_count> ops{};
+};
+
+namespace details {
+
+inline uint64_t trace_now_ns() noexcept {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// single producer ring , overwrites the oldest events when full.
+// the owner thread pushes without locking or waiting , readers on
+// other threads use the per slot sequence to skip slots being written.
+class trace_ring : non_copyable {
+public:
+  static inline constexpr std::size_t capacity = 1 << 14;
+
+  explicit trace_ring(uint32_t tid) noexcept : m_tid(tid) {}
+
+  void push(const io_trace_event &e) noexcept {
+    auto pos = m_head.load(std::memory_order_relaxed);
+    auto &slot = m_slots[pos & (capacity - 1)];
+    auto seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed); // odd : writing
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = e;
+    slot.seq.store(seq + 2, std::memory_order_release);
+    m_head.store(pos + 1, std::memory_order_release);
+  }
+
+  // copy out all complete events currently in ring , oldest first
+  template <class F> void for_each(F &&f) const {
+    auto head = m_head.load(std::memory_order_acquire);
+    auto beg = head > capacity ? head - capacity : 0;
+    for (auto pos = beg; pos != head; ++pos) {
+      auto &slot = m_slots[pos & (capacity - 1)];
+      auto seq = slot.seq.load(std::memory_order_acquire);
+      if (seq & 1)
+        continue;
+      io_trace_event e = slot.event;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) != seq)
+        continue;
+      f(e);
+    }
+  }
+
+  uint32_t tid() const noexcept { return m_tid; }
+
+private:
+  struct slot_t {
+    std::atomic<uint64_t> seq{0};
+    io_trace_event event{};
+  };
+
+  std::atomic<uint64_t> m_head{0};
+  uint32_t m_tid;
+  std::unique_ptr<slot_t[]> m_slots{new slot_t[capacity]};
+};
+
+// keep rings alive after thread exits so that they can still be dumped
+class trace_registry {
+public:
+  static trace_registry &instance() {
+    static trace_registry registry{};
+    return registry;
+  }
+
+  std::shared_ptr<trace_ring> make_ring() {
+    std::lock_guard guard{m_mutex};
+    auto ring = std::make_shared<trace_ring>(m_next_tid++);
+    m_rings.push_back(ring);
+    return ring;
+  }
+
+  std::vector<std::shared_ptr<trace_ring>> rings() {
+    std::lock_guard guard{m_mutex};
+    return m_rings;
+  }
+
+  void clear() {
+    std::lock_guard guard{m_mutex};
+    m_rings.clear();
+  }
+
+private:
+  std::mutex m_mutex;
+  std::vector<std::shared_ptr<trace_ring>> m_rings;
+  uint32_t m_next_tid{1};
+};
+
+// print nanoseconds as microseconds with 3 fixed decimals
+struct us_from_ns {
+  uint64_t ns;
+  friend std::ostream &operator<<(std::ostream &os, us_from_ns v) {
+    auto frac = v.ns % 1000;
+    os << v.ns / 1000 << '.';
+    if (frac < 100)
+      os << '0';
+    if (frac < 10)
+      os << '0';
+    return os << frac;
+  }
+};
+
+inline trace_ring &this_thread_trace_ring() {
+  thread_local auto ring = trace_registry::instance().make_ring();
+  return *ring;
+}
+
+} // namespace details
+
+// write raw events of all threads in chrome trace event format
+// (load it with chrome://tracing or https://ui.perfetto.dev).
+// every operation becomes two complete events : kernel and queue.
+inline void dump_chrome_trace(std::ostream &os) {
+  auto pid = ::getpid();
+  bool first = true;
+  auto emit = [&](std::string_view name, std::string_view cat, uint32_t tid,
+                  uint64_t beg_ns, uint64_t end_ns, int res) {
+    os << (first ? "\n" : ",\n");
+    first = false;
+    os << R"({"name":")" << name << R"(","cat":")" << cat
+       << R"(","ph":"X","pid":)" << pid << R"(,"tid":)" << tid
+       << R"(,"ts":)" << details::us_from_ns{beg_ns} << R"(,"dur":)"
+       << details::us_from_ns{end_ns - beg_ns} << R"(,"args":{"res":)" << res
+       << "}}";
+  };
+
+  os << R"({"displayTimeUnit":"ns","traceEvents":[)";
+  for (auto &ring : details::trace_registry::instance().rings()) {
+    ring->for_each([&](const io_trace_event &e) {
+      emit(to_str(e.op), "kernel", ring->tid(), e.submit_ns, e.reap_ns, e.res);
+      emit(to_str(e.op), "queue", ring->tid(), e.reap_ns, e.resume_ns, e.res);
+    });
+  }
+  os << "\n]}\n";
+}
+
+} // namespace coio
+
+#endif
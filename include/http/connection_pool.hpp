@@ -0,0 +1,170 @@
+#ifndef COIO_HTTP_CONNECTION_POOL_HPP
+#define COIO_HTTP_CONNECTION_POOL_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+
+#include "common/non_copyable.hpp"
+#include "http/http_parser.hpp"
+#include "io_context.hpp"
+#include "ioutils/buffered_stream.hpp"
+#include "ioutils/tcp.hpp"
+
+namespace coio {
+
+struct http_pool_options {
+  // idle connections kept per host , 0 disables keep-alive
+  std::size_t max_idle_per_host = 8;
+  // idle + in use per host , more requests wait for a release
+  std::size_t max_per_host = 64;
+  // idle connections older than this are closed instead of reused
+  std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds{30};
+  // unanswered pipelined requests written ahead on one connection
+  std::size_t max_pipeline_depth = 16;
+};
+
+namespace details {
+
+// one (possibly persistent) connection.
+// heap allocated , reader / writer refer to the socket.
+struct http_connection : non_copyable {
+  explicit http_connection(std::string key) : key(std::move(key)) {}
+
+  std::string key; // host:port
+  tcp_sock<ip> conn = tcp_sock<ip>::invalid(); // connect() assigns it
+  buffered_reader<tcp_sock<ip>> reader{conn};
+  buffered_writer<tcp_sock<ip>> writer{conn};
+  http_parser parser{};
+  bool connected{};
+  std::size_t requests{}; // completed on this connection , > 0 : reused
+  std::chrono::steady_clock::time_point idle_since{};
+
+  // the peer did not close an idle connection , nor send anything unasked
+  bool is_alive() noexcept {
+    char c;
+    auto n = ::recv(conn.native_handle(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+};
+
+} // namespace details
+
+// per host pool of keep-alive connections , single threaded.
+//
+//  auto c = co_await pool.acquire("example.com:80");
+//  if (!c->connected) ... connect
+//  ... request / response
+//  pool.release(std::move(c) , response_was_keep_alive);
+//
+// the pool must outlive every connection it handed out.
+class http_connection_pool : non_copyable {
+public:
+  using connection_ptr = std::unique_ptr<details::http_connection>;
+
+  explicit http_connection_pool(http_pool_options opts = {}) : m_opts(opts) {}
+
+public:
+  // a healthy idle connection if any , else a new unconnected one.
+  // waits while the host already has max_per_host connections.
+  auto acquire(std::string_view key) {
+    struct awaiter {
+      http_connection_pool &pool;
+      host_entry &host;
+      waiter w;
+
+      bool await_ready() {
+        w.result = pool.try_acquire(host, w.key);
+        return w.result != nullptr;
+      }
+      void await_suspend(std::coroutine_handle<> h) {
+        w.handle = h;
+        host.waiters.push_back(&w);
+      }
+      connection_ptr await_resume() noexcept { return std::move(w.result); }
+    };
+    return awaiter{*this, m_hosts[std::string{key}], waiter{std::string{key}}};
+  }
+
+  // keep_alive : the connection is in a clean state for another request
+  void release(connection_ptr conn, bool keep_alive) {
+    auto &host = m_hosts.find(conn->key)->second;
+    if (keep_alive) {
+      ++conn->requests;
+      conn->idle_since = std::chrono::steady_clock::now();
+    }
+
+    if (!host.waiters.empty()) {
+      // hand over directly , the total stays the same
+      auto *w = host.waiters.front();
+      host.waiters.pop_front();
+      w->result = keep_alive ? std::move(conn) : make_connection(w->key);
+      io_context::current_context()->post([h = w->handle] { h.resume(); });
+      return;
+    }
+
+    if (keep_alive && host.idle.size() < m_opts.max_idle_per_host)
+      host.idle.push_back(std::move(conn));
+    else
+      --host.total;
+  }
+
+  std::size_t idle_count(std::string_view key) const {
+    auto it = m_hosts.find(key);
+    return it == m_hosts.end() ? 0 : it->second.idle.size();
+  }
+
+  const http_pool_options &options() const noexcept { return m_opts; }
+
+private:
+  struct waiter {
+    std::string key;
+    connection_ptr result{};
+    std::coroutine_handle<> handle{};
+  };
+
+  struct host_entry {
+    std::deque<connection_ptr> idle{}; // oldest first
+    std::deque<waiter *> waiters{};
+    std::size_t total{};
+  };
+
+  connection_ptr try_acquire(host_entry &host, const std::string &key) {
+    auto now = std::chrono::steady_clock::now();
+    // expired ones are at the front
+    while (!host.idle.empty() &&
+           now - host.idle.front()->idle_since > m_opts.idle_timeout) {
+      host.idle.pop_front();
+      --host.total;
+    }
+    // most recently used first , the least likely closed by the peer
+    while (!host.idle.empty()) {
+      auto conn = std::move(host.idle.back());
+      host.idle.pop_back();
+      if (conn->is_alive())
+        return conn;
+      --host.total;
+    }
+    if (host.total < m_opts.max_per_host) {
+      ++host.total;
+      return make_connection(key);
+    }
+    return nullptr;
+  }
+
+  static connection_ptr make_connection(std::string_view key) {
+    return std::make_unique<details::http_connection>(std::string{key});
+  }
+
+private:
+  http_pool_options m_opts;
+  std::map<std::string, host_entry, std::less<>> m_hosts{};
+};
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef COIO_DNS_CACHE_HPP
+#define COIO_DNS_CACHE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+#include "future.hpp"
+#include "http/dns_resolver.hpp"
+#include "http/resolver.hpp"
+#include "io_context.hpp"
+#include "ioutils/protocol.hpp"
+
+namespace coio {
+
+enum class dns_backend {
+  c_ares, // async_resolver
+  native, // dns_resolver
+};
+
+struct dns_cache_options {
+  dns_backend backend = dns_backend::c_ares;
+  // record ttls are clamped into [min_ttl , max_ttl]
+  std::chrono::seconds min_ttl{1};
+  std::chrono::seconds max_ttl{300};
+  // how long a name that does not exist stays cached
+  std::chrono::seconds negative_ttl{30};
+  // an expired answer is still returned for this long while it is refreshed
+  std::chrono::seconds stale_ttl{30};
+  std::size_t max_entries = 1024;
+};
+
+struct dns_cache_stats {
+  uint64_t hits{};          // fresh answers , negative ones included
+  uint64_t negative_hits{}; // cached "no such name"
+  uint64_t stale_hits{};    // expired answers returned while refreshing
+  uint64_t misses{};        // queries sent
+  uint64_t coalesced{};     // lookups waiting on a query already sent
+};
+
+// answers of async_resolver (or dns_resolver) kept for their ttl , keyed by
+// host and service. concurrent lookups of one name share one query , a stale
+// answer is returned at once while a refresh runs. single threaded like its
+// context.
+//
+//  auto addrs = co_await dns_cache::current().lookup("example.com" , "http");
+//  if (addrs)
+//    for (auto &addr : *addrs) ...
+//
+// a failed query (timeout , refused ...) is not cached , a failed refresh
+// keeps the stale answer.
+class dns_cache : non_copyable {
+public:
+  using clock = std::chrono::steady_clock;
+  using addresses = std::vector<ip::address>;
+  // null : no such name , or the query failed
+  using addresses_ptr = std::shared_ptr<const addresses>;
+
+private:
+  // shared with the query filling it , which outlives an evicted entry
+  struct entry {
+    addresses_ptr addrs{};
+    clock::time_point expires{};
+    bool resolving{};
+    std::vector<std::coroutine_handle<>> waiters{};
+  };
+
+public:
+  explicit dns_cache(dns_cache_options opts = {}) : m_opts(opts) {}
+
+  // the cache of the current context , created on first use
+  static dns_cache &current() {
+    thread_local std::unique_ptr<dns_cache> cache{};
+    thread_local uint64_t ctx_id{};
+    auto id = io_context::current_context()->id();
+    if (!cache || ctx_id != id) {
+      cache = std::make_unique<dns_cache>();
+      ctx_id = id;
+    }
+    return *cache;
+  }
+
+public:
+  auto lookup(std::string_view host, std::string_view service) {
+    struct awaiter {
+      std::shared_ptr<entry> e;
+      addresses_ptr hit;
+      bool await_ready() const noexcept { return !e; }
+      void await_suspend(std::coroutine_handle<> h) {
+        e->waiters.push_back(h);
+      }
+      addresses_ptr await_resume() noexcept {
+        return e ? e->addrs : std::move(hit);
+      }
+    };
+
+    auto now = clock::now();
+    if (m_entries.size() >= m_opts.max_entries)
+      evict(now);
+    m_key.assign(host).append(":").append(service);
+    auto &e = m_entries[m_key];
+    if (!e)
+      e = std::make_shared<entry>();
+
+    if (now < e->expires) {
+      ++m_stats.hits;
+      m_stats.negative_hits += !e->addrs;
+      return awaiter{nullptr, e->addrs};
+    }
+    if (e->addrs && now < e->expires + m_opts.stale_ttl) {
+      ++m_stats.stale_hits;
+      if (!e->resolving)
+        start_query(e, host, service);
+      return awaiter{nullptr, e->addrs};
+    }
+    if (e->resolving) {
+      ++m_stats.coalesced;
+      return awaiter{e, nullptr};
+    }
+
+    ++m_stats.misses;
+    e->addrs = nullptr;
+    start_query(e, host, service);
+    // numeric hosts are answered at once
+    if (!e->resolving)
+      return awaiter{nullptr, e->addrs};
+    return awaiter{e, nullptr};
+  }
+
+  const dns_cache_stats &stats() const noexcept { return m_stats; }
+  std::size_t size() const noexcept { return m_entries.size(); }
+  void clear() noexcept { m_entries.clear(); }
+
+private:
+  // drops what can not be returned any more , then what expires first ,
+  // leaves room for one more
+  void evict(clock::time_point now) {
+    std::erase_if(m_entries, [&](auto &kv) {
+      auto &e = *kv.second;
+      return !e.resolving && e.expires + m_opts.stale_ttl <= now;
+    });
+    while (!m_entries.empty() && m_entries.size() >= m_opts.max_entries) {
+      auto it = std::min_element(
+          m_entries.begin(), m_entries.end(), [](auto &a, auto &b) {
+            return a.second->expires < b.second->expires;
+          });
+      m_entries.erase(it);
+    }
+  }
+
+  void start_query(const std::shared_ptr<entry> &e, std::string_view host,
+                   std::string_view service) {
+    e->resolving = true;
+    io_context::current_context()->co_spawn(
+        query(e, std::string{host}, std::string{service}, m_opts));
+  }
+
+  // touches only the entry , the cache may be gone when it ends
+  static future<void> query(std::shared_ptr<entry> e, std::string host,
+                            std::string service, dns_cache_options opts) {
+    auto rsp = dns_lookup_result{};
+    if (opts.backend == dns_backend::native)
+      rsp = co_await dns_resolver::current().lookup(std::move(host),
+                                                    std::move(service));
+    else
+      rsp = co_await ares_lookup(std::move(host), std::move(service));
+    auto now = clock::now();
+    if (rsp.status == dns_lookup_result::ok) {
+      auto ttl = std::chrono::seconds{rsp.ttl};
+      e->addrs = std::make_shared<addresses>(std::move(rsp.addresses));
+      e->expires = now + std::clamp(ttl, opts.min_ttl,
+                                    std::max(opts.min_ttl, opts.max_ttl));
+    } else if (rsp.status == dns_lookup_result::not_found) {
+      e->addrs = nullptr;
+      e->expires = now + opts.negative_ttl;
+    } else if (!e->addrs) {
+      e->expires = now; // not cached
+    }
+    e->resolving = false;
+    for (auto h : std::exchange(e->waiters, {}))
+      io_context::current_context()->post([h] { h.resume(); });
+  }
+
+  static future<dns_lookup_result> ares_lookup(std::string host,
+                                               std::string service) {
+    auto q = async_resolver::current().submit_query(std::move(host),
+                                                    std::move(service));
+    auto list = co_await q;
+    auto rsp = dns_lookup_result{};
+    if (list) {
+      rsp.status = dns_lookup_result::ok;
+      rsp.ttl = UINT32_MAX;
+      for (auto &v : *list) {
+        rsp.addresses.push_back(v.to_address());
+        rsp.ttl = std::min(rsp.ttl, static_cast<uint32_t>(v.node->ai_ttl));
+        if (v.name)
+          rsp.ttl = std::min(rsp.ttl, static_cast<uint32_t>(v.name->ttl));
+      }
+    } else if (q.status == ARES_ENOTFOUND || q.status == ARES_ENODATA) {
+      rsp.status = dns_lookup_result::not_found;
+    }
+    co_return rsp;
+  }
+
+private:
+  dns_cache_options m_opts;
+  std::unordered_map<std::string, std::shared_ptr<entry>> m_entries{};
+  std::string m_key{}; // reused , no allocation per lookup
+  dns_cache_stats m_stats{};
+};
+
+} // namespace coio
+
+#endif
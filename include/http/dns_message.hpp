@@ -0,0 +1,200 @@
+#ifndef COIO_DNS_MESSAGE_HPP
+#define COIO_DNS_MESSAGE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/string_search.hpp"
+
+// the dns wire format (rfc 1035) , just what a stub resolver needs :
+// a query with one question , and the answer section of its response.
+namespace coio::dns {
+
+enum class rr_type : uint16_t {
+  a = 1,
+  cname = 5,
+  aaaa = 28,
+};
+
+enum class rcode : uint8_t {
+  no_error = 0,
+  format_error = 1,
+  server_failure = 2,
+  name_error = 3, // NXDOMAIN
+  not_implemented = 4,
+  refused = 5,
+};
+
+// without edns
+inline constexpr std::size_t max_udp_size = 512;
+inline constexpr std::size_t header_size = 12;
+
+namespace details {
+
+inline void put16(std::string &out, uint16_t v) {
+  out.push_back(static_cast<char>(v >> 8));
+  out.push_back(static_cast<char>(v & 0xff));
+}
+
+inline uint16_t get16(std::string_view msg, std::size_t pos) noexcept {
+  return static_cast<uint16_t>(static_cast<uint8_t>(msg[pos]) << 8 |
+                               static_cast<uint8_t>(msg[pos + 1]));
+}
+
+inline uint32_t get32(std::string_view msg, std::size_t pos) noexcept {
+  return uint32_t{get16(msg, pos)} << 16 | get16(msg, pos + 2);
+}
+
+} // namespace details
+
+// appends a recursive query for name , false if name is not a valid
+// domain name (empty label , label > 63 or name > 253 bytes).
+// a trailing dot is allowed.
+inline bool encode_query(std::string &out, uint16_t id, std::string_view name,
+                         rr_type type) {
+  if (name.ends_with('.'))
+    name.remove_suffix(1);
+  if (name.empty() || name.size() > 253)
+    return false;
+  details::put16(out, id);
+  details::put16(out, 0x0100); // rd
+  details::put16(out, 1);      // qdcount
+  out.append(6, '\0');         // an , ns , ar
+  while (!name.empty()) {
+    auto label = name.substr(0, name.find('.'));
+    if (label.empty() || label.size() > 63)
+      return false;
+    out.push_back(static_cast<char>(label.size()));
+    out.append(label);
+    name.remove_prefix(std::min(name.size(), label.size() + 1));
+  }
+  out.push_back('\0');
+  details::put16(out, static_cast<uint16_t>(type));
+  details::put16(out, 1); // class IN
+  return true;
+}
+
+// reads the possibly compressed name at pos into out (dotted , no trailing
+// dot). the position after the name , nullopt if malformed.
+inline std::optional<std::size_t> decode_name(std::string_view msg,
+                                              std::size_t pos,
+                                              std::string &out) {
+  out.clear();
+  auto next = std::optional<std::size_t>{};
+  for (int jumps = 0; pos < msg.size();) {
+    auto len = static_cast<uint8_t>(msg[pos]);
+    if (len == 0) {
+      return next ? next : pos + 1;
+    } else if ((len & 0xc0) == 0xc0) {
+      // a pointer , only backwards and a bounded number of times
+      if (pos + 1 >= msg.size() || ++jumps > 64)
+        return std::nullopt;
+      if (!next)
+        next = pos + 2;
+      auto target = details::get16(msg, pos) & 0x3fffu;
+      if (target >= pos)
+        return std::nullopt;
+      pos = target;
+    } else if (len > 63 || pos + 1 + len > msg.size()) {
+      return std::nullopt;
+    } else {
+      if (!out.empty())
+        out.push_back('.');
+      out.append(msg.substr(pos + 1, len));
+      if (out.size() > 253)
+        return std::nullopt;
+      pos += 1 + len;
+    }
+  }
+  return std::nullopt;
+}
+
+struct record {
+  std::string name;
+  rr_type type;
+  uint32_t ttl;
+  std::size_t data_off; // rdata , in the message
+  std::size_t data_len;
+};
+
+struct response {
+  uint16_t id;
+  rcode code;
+  bool truncated;
+  std::string question;
+  rr_type qtype;
+  std::vector<record> answers; // class IN only
+};
+
+// nullopt if msg is not a well formed response with one question
+inline std::optional<response> decode_response(std::string_view msg) {
+  using details::get16;
+  if (msg.size() < header_size)
+    return std::nullopt;
+  auto flags = get16(msg, 2);
+  if (!(flags & 0x8000) || get16(msg, 4) != 1)
+    return std::nullopt;
+  auto rsp = response{
+      .id = get16(msg, 0),
+      .code = static_cast<rcode>(flags & 0xf),
+      .truncated = (flags & 0x0200) != 0,
+  };
+  auto pos = decode_name(msg, header_size, rsp.question);
+  if (!pos || *pos + 4 > msg.size())
+    return std::nullopt;
+  rsp.qtype = static_cast<rr_type>(get16(msg, *pos));
+  *pos += 4;
+
+  auto ancount = get16(msg, 6);
+  rsp.answers.reserve(ancount);
+  for (uint16_t i = 0; i < ancount; ++i) {
+    auto rr = record{};
+    pos = decode_name(msg, *pos, rr.name);
+    if (!pos || *pos + 10 > msg.size())
+      return std::nullopt;
+    rr.type = static_cast<rr_type>(get16(msg, *pos));
+    auto cls = get16(msg, *pos + 2);
+    rr.ttl = details::get32(msg, *pos + 4);
+    rr.data_len = get16(msg, *pos + 8);
+    rr.data_off = *pos + 10;
+    if (rr.data_off + rr.data_len > msg.size())
+      return std::nullopt;
+    *pos = rr.data_off + rr.data_len;
+    if (cls == 1)
+      rsp.answers.push_back(std::move(rr));
+  }
+  return rsp;
+}
+
+// the address records answering the question , through its cname chain.
+// f(const record &) for each one of type t.
+template <class F>
+void for_each_address(std::string_view msg, const response &rsp, rr_type t,
+                      F &&f) {
+  auto owner = rsp.question;
+  auto target = std::string{};
+  // a chain is listed in order , but do not rely on it
+  for (std::size_t hops = 0; hops <= rsp.answers.size(); ++hops) {
+    auto followed = false;
+    for (auto &rr : rsp.answers) {
+      if (!ascii_iequals(rr.name, owner))
+        continue;
+      if (rr.type == t)
+        f(rr);
+      else if (rr.type == rr_type::cname && !followed &&
+               decode_name(msg, rr.data_off, target))
+        followed = true;
+    }
+    if (!followed)
+      return;
+    owner = target;
+  }
+}
+
+} // namespace coio::dns
+
+#endif
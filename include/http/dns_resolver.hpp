@@ -0,0 +1,427 @@
+#ifndef COIO_DNS_RESOLVER_HPP
+#define COIO_DNS_RESOLVER_HPP
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <netdb.h>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+#include "common/scope_guard.hpp"
+#include "common/string_search.hpp"
+#include "future.hpp"
+#include "http/dns_message.hpp"
+#include "io_context.hpp"
+#include "ioutils/protocol.hpp"
+#include "ioutils/udp.hpp"
+
+namespace coio {
+
+namespace details {
+
+inline std::string read_text_file(const char *path) {
+  auto in = std::ifstream{path};
+  auto ss = std::stringstream{};
+  ss << in.rdbuf();
+  return std::move(ss).str();
+}
+
+// calls f(word , word ...) for each line , comments dropped
+template <class F> void for_each_config_line(std::string_view text, F &&f) {
+  auto words = std::vector<std::string_view>{};
+  while (!text.empty()) {
+    auto line = text.substr(0, text.find('\n'));
+    text.remove_prefix(std::min(text.size(), line.size() + 1));
+    line = line.substr(0, line.find_first_of("#;"));
+    words.clear();
+    while (true) {
+      auto beg = line.find_first_not_of(" \t\r");
+      if (beg == std::string_view::npos)
+        break;
+      line.remove_prefix(beg);
+      auto word = line.substr(0, line.find_first_of(" \t\r"));
+      words.push_back(word);
+      line.remove_prefix(word.size());
+    }
+    if (!words.empty())
+      f(std::span<const std::string_view>{words});
+  }
+}
+
+inline std::optional<ipv4::address> parse_ipv4(std::string_view ip,
+                                               uint16_t port) {
+  char buf[INET_ADDRSTRLEN]{};
+  if (ip.size() >= sizeof(buf))
+    return std::nullopt;
+  ip.copy(buf, ip.size());
+  auto addr = ipv4::address{port};
+  if (::inet_pton(AF_INET, buf, &addr.addr.sin_addr) != 1)
+    return std::nullopt;
+  return addr;
+}
+
+} // namespace details
+
+// what the resolver of the c library reads from /etc/resolv.conf ,
+// ipv4 nameservers only
+struct resolv_conf {
+  std::vector<ipv4::address> nameservers{};
+  std::vector<std::string> search{};
+  int ndots = 1;
+  std::chrono::milliseconds timeout{5000}; // per try
+  int attempts = 2;
+
+  static resolv_conf parse(std::string_view text) {
+    auto conf = resolv_conf{};
+    auto number = [](std::string_view s, int &v) {
+      std::from_chars(s.data(), s.data() + s.size(), v);
+    };
+    details::for_each_config_line(text, [&](auto words) {
+      if (words[0] == "nameserver" && words.size() > 1) {
+        if (auto addr = details::parse_ipv4(words[1], 53))
+          conf.nameservers.push_back(*addr);
+      } else if (words[0] == "search" || words[0] == "domain") {
+        // the last one wins
+        conf.search.clear();
+        for (auto w : words.subspan(1))
+          conf.search.emplace_back(w);
+      } else if (words[0] == "options") {
+        for (auto w : words.subspan(1)) {
+          if (w.starts_with("ndots:")) {
+            number(w.substr(6), conf.ndots);
+          } else if (w.starts_with("attempts:")) {
+            number(w.substr(9), conf.attempts);
+          } else if (w.starts_with("timeout:")) {
+            auto secs = 5;
+            number(w.substr(8), secs);
+            conf.timeout = std::chrono::seconds{secs};
+          }
+        }
+      }
+    });
+    if (conf.nameservers.empty())
+      conf.nameservers.push_back(ipv4::address{53, "127.0.0.1"});
+    conf.attempts = std::max(conf.attempts, 1);
+    return conf;
+  }
+
+  static resolv_conf load(const char *path = "/etc/resolv.conf") {
+    return parse(details::read_text_file(path));
+  }
+};
+
+// the ipv4 entries of /etc/hosts
+class hosts_file {
+public:
+  static hosts_file parse(std::string_view text) {
+    auto hosts = hosts_file{};
+    details::for_each_config_line(text, [&](auto words) {
+      auto addr = details::parse_ipv4(words[0], 0);
+      if (!addr)
+        return;
+      for (auto name : words.subspan(1))
+        hosts.m_hosts[lower(name)].push_back(*addr);
+    });
+    return hosts;
+  }
+
+  static hosts_file load(const char *path = "/etc/hosts") {
+    return parse(details::read_text_file(path));
+  }
+
+  // port 0 , nullptr if not listed
+  const std::vector<ipv4::address> *find(std::string_view name) const {
+    if (name.ends_with('.'))
+      name.remove_suffix(1);
+    auto it = m_hosts.find(lower(name));
+    return it == m_hosts.end() ? nullptr : &it->second;
+  }
+
+private:
+  static std::string lower(std::string_view s) {
+    auto out = std::string{s};
+    for (auto &c : out)
+      c = details::search::ascii_lower(c);
+    return out;
+  }
+
+private:
+  std::unordered_map<std::string, std::vector<ipv4::address>> m_hosts{};
+};
+
+struct dns_lookup_result {
+  enum status_t {
+    ok,
+    not_found, // NXDOMAIN , or no address records , for every candidate
+    failed,    // no answer , or a server failure
+  };
+  status_t status{failed};
+  std::vector<ip::address> addresses{};
+  uint32_t ttl{}; // the smallest of the answer , 0 for numeric or hosts
+};
+
+// a stub resolver over udp_sock , the c-ares free backend of dns_cache.
+// every query in flight shares one socket and posts its own receive , linked
+// to a timeout (IORING_OP_LINK_TIMEOUT). a response is matched to its query
+// by id and question , whichever receive got it.
+// truncated responses are used as they are , there is no tcp fallback.
+class dns_resolver : non_copyable,
+                     public std::enable_shared_from_this<dns_resolver> {
+  struct private_tag {};
+
+  // lives in the frame of exchange() , until its last receive completed
+  struct pending_query {
+    uint16_t id;
+    std::string_view name;
+    dns::rr_type type;
+    bool answered{};
+    std::string answer{};
+    // the receive in flight
+    io_context::async_result recv{};
+    std::array<char, dns::max_udp_size> buf{};
+    ipv4::address peer{};
+    iovec iov{};
+    msghdr msg{};
+    __kernel_timespec timeout{};
+  };
+
+public:
+  dns_resolver(private_tag, io_context &ctx, resolv_conf conf,
+               hosts_file hosts)
+      : m_ctx_id(ctx.id()), m_conf(std::move(conf)),
+        m_hosts(std::move(hosts)), m_rand(std::random_device{}()) {}
+
+  // the resolver of the current context , created on first use from
+  // /etc/resolv.conf and /etc/hosts
+  static dns_resolver &current() {
+    auto &resolver = this_thread_resolver();
+    auto &ctx = *io_context::current_context();
+    if (!resolver || resolver->m_ctx_id != ctx.id())
+      resolver = std::make_shared<dns_resolver>(
+          private_tag{}, ctx, resolv_conf::load(), hosts_file::load());
+    return *resolver;
+  }
+
+  // replaces the resolver of the current context
+  static dns_resolver &configure(resolv_conf conf, hosts_file hosts = {}) {
+    auto &resolver = this_thread_resolver();
+    resolver = std::make_shared<dns_resolver>(
+        private_tag{}, *io_context::current_context(), std::move(conf),
+        std::move(hosts));
+    return *resolver;
+  }
+
+  const resolv_conf &conf() const noexcept { return m_conf; }
+
+public:
+  // A records of host : numeric , /etc/hosts , then the search list
+  future<dns_lookup_result> lookup(std::string host, std::string service) {
+    auto self = shared_from_this();
+    auto result = dns_lookup_result{};
+    auto port = service_port(service);
+    if (!port)
+      co_return result;
+    if (auto addr = details::parse_ipv4(host, *port)) {
+      result.status = dns_lookup_result::ok;
+      result.addresses.emplace_back(*addr);
+      co_return result;
+    }
+    if (auto *addrs = m_hosts.find(host)) {
+      result.status = dns_lookup_result::ok;
+      for (auto addr : *addrs) {
+        addr.addr.sin_port = host_to_net(*port);
+        result.addresses.emplace_back(addr);
+      }
+      co_return result;
+    }
+
+    auto failed = false;
+    for (auto &name : candidates(host)) {
+      auto answer = co_await exchange(name, dns::rr_type::a);
+      auto rsp = answer ? dns::decode_response(*answer) : std::nullopt;
+      if (!rsp || (rsp->code != dns::rcode::no_error &&
+                   rsp->code != dns::rcode::name_error)) {
+        failed = true;
+        continue;
+      }
+      result.ttl = UINT32_MAX;
+      dns::for_each_address(*answer, *rsp, dns::rr_type::a, [&](auto &rr) {
+        if (rr.data_len != 4)
+          return;
+        auto addr = ipv4::address{*port};
+        std::memcpy(&addr.addr.sin_addr, answer->data() + rr.data_off, 4);
+        result.addresses.emplace_back(addr);
+        result.ttl = std::min(result.ttl, rr.ttl);
+      });
+      if (!result.addresses.empty()) {
+        result.status = dns_lookup_result::ok;
+        co_return result;
+      }
+    }
+    result.ttl = 0;
+    result.status =
+        failed ? dns_lookup_result::failed : dns_lookup_result::not_found;
+    co_return result;
+  }
+
+  // one question , asked to each nameserver in turn until answered.
+  // the response datagram , nullopt after timeout * attempts per server.
+  future<std::optional<std::string>> exchange(std::string_view name,
+                                              dns::rr_type type) {
+    auto self = shared_from_this();
+    auto q = pending_query{.id = new_id(), .name = name, .type = type};
+    auto query = std::string{};
+    if (!dns::encode_query(query, q.id, name, type))
+      co_return std::nullopt;
+    if (q.name.ends_with('.'))
+      q.name.remove_suffix(1);
+    m_pending.emplace(q.id, &q);
+    auto guard = scope_guard{[&]() noexcept { m_pending.erase(q.id); }};
+
+    auto tries = m_conf.attempts * m_conf.nameservers.size();
+    for (std::size_t i = 0; i < tries && !q.answered; ++i) {
+      auto server = m_conf.nameservers[i % m_conf.nameservers.size()];
+      try {
+        co_await m_sock.sendto(server, std::as_bytes(std::span{query}));
+      } catch (const std::system_error &) {
+        continue; // unreachable network ... , the next server
+      }
+      auto deadline = std::chrono::steady_clock::now() + m_conf.timeout;
+      while (true) {
+        receive(q, deadline - std::chrono::steady_clock::now());
+        co_await io_context::wait_completion(q.recv);
+        if (q.recv.res > 0)
+          dispatch({q.buf.data(), std::size_t(q.recv.res)}, q.peer, q);
+        // timed out , or an error (port unreachable ...) : next try
+        if (q.answered || q.recv.res <= 0 ||
+            std::chrono::steady_clock::now() >= deadline)
+          break;
+        // a response for another query , or a stray one
+      }
+    }
+    if (!q.answered)
+      co_return std::nullopt;
+    co_return std::move(q.answer);
+  }
+
+private:
+  static std::shared_ptr<dns_resolver> &this_thread_resolver() {
+    thread_local std::shared_ptr<dns_resolver> resolver{};
+    return resolver;
+  }
+
+  static std::optional<uint16_t> service_port(const std::string &service) {
+    auto port = uint16_t{};
+    auto end = service.data() + service.size();
+    if (auto [p, ec] = std::from_chars(service.data(), end, port);
+        ec == std::errc{} && p == end)
+      return port;
+    auto ent = servent{};
+    auto *res = static_cast<servent *>(nullptr);
+    char buf[1024];
+    if (::getservbyname_r(service.c_str(), "tcp", &ent, buf, sizeof(buf),
+                          &res) != 0 ||
+        !res)
+      return std::nullopt;
+    return net_to_host(static_cast<uint16_t>(res->s_port));
+  }
+
+  // the names to ask for , in the order of the c library
+  std::vector<std::string> candidates(std::string_view host) const {
+    auto names = std::vector<std::string>{};
+    if (host.ends_with('.')) {
+      names.emplace_back(host);
+      return names;
+    }
+    auto dots = std::count(host.begin(), host.end(), '.');
+    if (dots >= m_conf.ndots)
+      names.emplace_back(host);
+    for (auto &domain : m_conf.search)
+      names.push_back(std::string{host}.append(".").append(domain));
+    if (dots < m_conf.ndots)
+      names.emplace_back(host);
+    return names;
+  }
+
+  uint16_t new_id() {
+    auto dist = std::uniform_int_distribution<uint16_t>{};
+    auto id = dist(m_rand);
+    while (m_pending.contains(id))
+      ++id;
+    return id;
+  }
+
+  template <class D> void receive(pending_query &q, D timeout) {
+    using namespace std::chrono;
+    auto ns = std::max(duration_cast<nanoseconds>(timeout), nanoseconds{0});
+    q.timeout = {.tv_sec = ns.count() / 1000000000,
+                 .tv_nsec = ns.count() % 1000000000};
+    q.iov = {.iov_base = q.buf.data(), .iov_len = q.buf.size()};
+    q.msg = {.msg_name = q.peer.ptr(),
+             .msg_namelen = q.peer.len(),
+             .msg_iov = &q.iov,
+             .msg_iovlen = 1};
+    auto *ctx = io_context::current_context();
+    // both in one submit , the link must not end at the recv
+    ctx->reserve_sqes(2);
+    ctx->submit_detached(&q.recv, [&](io_uring_sqe *sqe) {
+      ::io_uring_prep_recvmsg(sqe, m_sock.native_handle(), &q.msg, 0);
+      sqe->flags |= IOSQE_IO_LINK;
+    });
+    ctx->submit_detached(nullptr, [&](io_uring_sqe *sqe) {
+      ::io_uring_prep_link_timeout(sqe, &q.timeout, 0);
+    });
+  }
+
+  // hands a response to the query it answers , whichever received it
+  void dispatch(std::string_view datagram, const ipv4::address &peer,
+                pending_query &receiver) {
+    if (datagram.size() < dns::header_size)
+      return;
+    auto it = m_pending.find(dns::details::get16(datagram, 0));
+    if (it == m_pending.end() || it->second->answered)
+      return;
+    auto &q = *it->second;
+    auto from_server = std::find(m_conf.nameservers.begin(),
+                                 m_conf.nameservers.end(),
+                                 peer) != m_conf.nameservers.end();
+    auto rsp = dns::decode_response(datagram);
+    if (!from_server || !rsp || rsp->qtype != q.type ||
+        !ascii_iequals(rsp->question, q.name))
+      return;
+    q.answer.assign(datagram);
+    q.answered = true;
+    // its own receive is still in flight , end it
+    if (&q != &receiver)
+      io_context::current_context()->submit_detached(
+          nullptr, [&r = q.recv](io_uring_sqe *sqe) {
+            ::io_uring_prep_cancel(sqe, &r, 0);
+          });
+  }
+
+private:
+  uint64_t m_ctx_id;
+  resolv_conf m_conf;
+  hosts_file m_hosts;
+  udp_sock<> m_sock{};
+  std::mt19937 m_rand;
+  std::unordered_map<uint16_t, pending_query *> m_pending{};
+};
+
+} // namespace coio
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef COIO_HTTP_PARSER_HPP
 #define COIO_HTTP_PARSER_HPP
 
+#include "common/string_search.hpp"
 #include "picohttpparser.h"
 #include <algorithm>
 #include <array>
-#include <cctype>
+#include <charconv>
+#include <optional>
 #include <ranges>
 #include <string_view>
 #include <utility>
@@ -15,9 +17,7 @@ namespace coio {
 namespace details {
 
 static bool is_lower_equal(std::string_view a, std::string_view b) {
-  constexpr auto tolower = [](char c) { return std::tolower(c); };
-  return std::ranges::equal(a | std::views::transform(tolower),
-                            b | std::views::transform(tolower));
+  return ascii_iequals(a, b);
 }
 
 } // namespace details
@@ -60,25 +60,52 @@ struct http_parser {
   std::size_t body_len{};
   std::string_view message{};
   int status{};
+  int minor_version{};
+  bool has_content_length{};
+  bool chunked{};
 
+  // bytes of the head , -1 : invalid , -2 : incomplete.
+  // headers parsed so far are usable even if incomplete
   int parse_response(std::string_view str) {
-    int min_ver{};
     const char *msg{};
     std::size_t msg_len{};
     headers_cnt = num_headers;
+    body_len = 0;
+    has_content_length = chunked = false;
     auto len =
-        phr_parse_response(str.data(), str.size(), &min_ver, &status, &msg,
-                           &msg_len, headers.data(), &headers_cnt, 0);
-
+        phr_parse_response(str.data(), str.size(), &minor_version, &status,
+                           &msg, &msg_len, headers.data(), &headers_cnt, 0);
     message = {msg, msg_len};
     auto content_len = get_header_value("content-length");
-    if (!content_len.empty())
-      body_len = std::stoi(std::string(content_len));
+    if (!content_len.empty()) {
+      auto end = content_len.data() + content_len.size();
+      auto [p, ec] = std::from_chars(content_len.data(), end, body_len);
+      if (ec != std::errc{} || p != end)
+        return -1;
+      has_content_length = true;
+    }
+    // chunked is always the last coding , takes precedence over the length
+    auto coding = get_header_value("transfer-encoding");
+    if (coding.size() >= 7 &&
+        details::is_lower_equal(coding.substr(coding.size() - 7), "chunked"))
+      chunked = true, has_content_length = false, body_len = 0;
 
     return len;
   }
 
-  std::string_view get_header_value(std::string_view key) {
+  // the connection can carry another request after this response
+  bool keep_alive() const {
+    auto conn = get_header_value("connection");
+    return minor_version >= 1 ? !details::is_lower_equal(conn, "close")
+                              : details::is_lower_equal(conn, "keep-alive");
+  }
+
+  // response to HEAD , 1xx , 204 , 304 never has a body
+  bool has_body(bool head_request) const noexcept {
+    return !head_request && status >= 200 && status != 204 && status != 304;
+  }
+
+  std::string_view get_header_value(std::string_view key) const {
     for (auto &h : headers | std::views::take(headers_cnt)) {
       if (details::is_lower_equal(std::string_view{h.name, h.name_len}, key)) {
         return {h.value, h.value_len};
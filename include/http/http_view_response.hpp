@@ -0,0 +1,228 @@
+#ifndef COIO_HTTP_VIEW_RESPONSE_HPP
+#define COIO_HTTP_VIEW_RESPONSE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "chained_buffer.hpp"
+#include "common/non_copyable.hpp"
+#include "common/string_search.hpp"
+#include "http/http_parser.hpp"
+
+namespace coio {
+
+namespace details {
+
+// fnv-1a of the lowercase name
+inline uint32_t header_hash(std::string_view name) noexcept {
+  uint32_t h = 2166136261u;
+  for (auto c : name)
+    h = (h ^ static_cast<unsigned char>(search::ascii_lower(c))) * 16777619u;
+  return h;
+}
+
+// offsets into the response buffer
+struct header_entry {
+  uint32_t hash;
+  uint32_t name_off, name_len;
+  uint32_t value_off, value_len;
+};
+
+} // namespace details
+
+// a whole response in one buffer , laid out as
+//  [head][header entries][header table][body]
+// headers and body are views into it , valid while the response lives.
+// small responses take a segment of the per thread pool , no allocation.
+//
+// the header table is open addressing , keyed by the hash of the lowercase
+// name , at most half full. a repeated name finds its first value.
+class http_view_response {
+public:
+  class builder;
+
+public:
+  int status_code() const noexcept { return m_status; }
+
+  std::string_view reason() const noexcept {
+    return view(m_reason_off, m_reason_len);
+  }
+
+  std::string_view head() const noexcept { return view(0, m_head_len); }
+
+  std::string_view body() const noexcept {
+    return view(m_body_off, m_buffer.size() - m_body_off);
+  }
+
+  std::size_t header_count() const noexcept { return m_header_cnt; }
+
+  // in the order received
+  std::pair<std::string_view, std::string_view>
+  header_at(std::size_t i) const noexcept {
+    auto &e = entries()[i];
+    return {view(e.name_off, e.name_len), view(e.value_off, e.value_len)};
+  }
+
+  // nullopt if not contains this header , "" value is allowed
+  std::optional<std::string_view> header(std::string_view name) const noexcept {
+    if (m_header_cnt == 0)
+      return std::nullopt;
+    auto hash = details::header_hash(name);
+    auto mask = m_table_size - 1;
+    for (auto i = hash & mask;; i = (i + 1) & mask) {
+      auto slot = table()[i];
+      if (slot == 0)
+        return std::nullopt;
+      auto &e = entries()[slot - 1];
+      if (e.hash == hash && ascii_iequals(view(e.name_off, e.name_len), name))
+        return view(e.value_off, e.value_len);
+    }
+  }
+
+private:
+  std::string_view view(std::size_t off, std::size_t len) const noexcept {
+    return {reinterpret_cast<const char *>(m_buffer.data()) + off, len};
+  }
+
+  const details::header_entry *entries() const noexcept {
+    return std::launder(reinterpret_cast<const details::header_entry *>(
+        m_buffer.data() + m_index_off));
+  }
+
+  const uint16_t *table() const noexcept {
+    return std::launder(
+        reinterpret_cast<const uint16_t *>(entries() + m_header_cnt));
+  }
+
+private:
+  buffer_slice m_buffer{};
+  uint32_t m_head_len{};
+  uint32_t m_reason_off{}, m_reason_len{};
+  uint32_t m_index_off{};
+  uint32_t m_header_cnt{};
+  uint32_t m_table_size{}; // power of 2 , slot : entry index + 1 , 0 empty
+  std::size_t m_body_off{};
+  int m_status{};
+};
+
+// copies a parsed head into the buffer and indexes its headers ,
+// then takes the body as it arrives.
+//
+//  auto b = http_view_response::builder{head , parser , content_length};
+//  b.append_body(slice) ...
+//  auto rsp = std::move(b).finish();
+class http_view_response::builder : non_copyable {
+public:
+  // body bytes reserved up front at most , a peer announcing more gets its
+  // buffer grown as the body actually arrives
+  static constexpr std::size_t max_body_hint = 1 << 20;
+
+  // head : the bytes parser.parse_response accepted.
+  // body_hint : expected body size , the buffer grows past it if needed.
+  builder(std::string_view head, const http_parser &p,
+          std::size_t body_hint = 0) {
+    auto &rsp = m_response;
+    rsp.m_status = p.status;
+    rsp.m_head_len = static_cast<uint32_t>(head.size());
+    rsp.m_reason_off = offset_of(head, p.message.data());
+    rsp.m_reason_len = static_cast<uint32_t>(p.message.size());
+    rsp.m_header_cnt = static_cast<uint32_t>(p.headers_cnt);
+    rsp.m_table_size = 8;
+    while (rsp.m_table_size < 2 * rsp.m_header_cnt)
+      rsp.m_table_size *= 2;
+    rsp.m_index_off = (rsp.m_head_len + 3) & ~3u;
+    rsp.m_body_off = rsp.m_index_off +
+                     rsp.m_header_cnt * sizeof(details::header_entry) +
+                     rsp.m_table_size * sizeof(uint16_t);
+
+    reserve(rsp.m_body_off + std::min(body_hint, max_body_hint));
+    std::memcpy(m_segment->data(), head.data(), head.size());
+    m_used = rsp.m_body_off;
+    build_index(head, p);
+  }
+
+  ~builder() {
+    if (m_segment)
+      details::release(m_segment);
+  }
+
+public:
+  void append_body(std::string_view s) {
+    reserve(m_used + s.size());
+    std::memcpy(m_segment->data() + m_used, s.data(), s.size());
+    m_used += s.size();
+  }
+
+  http_view_response finish() && {
+    m_response.m_buffer =
+        buffer_slice{m_segment, m_segment->data(), m_used}; // a new reference
+    details::release(std::exchange(m_segment, nullptr));
+    return std::move(m_response);
+  }
+
+private:
+  static uint32_t offset_of(std::string_view head, const char *p) noexcept {
+    return p ? static_cast<uint32_t>(p - head.data()) : 0;
+  }
+
+  void reserve(std::size_t size) {
+    if (m_segment && size <= m_segment->capacity)
+      return;
+    // unknown body sizes grow by doubling
+    auto capacity =
+        std::max(size, m_segment ? 2 * std::size_t{m_segment->capacity} : 0);
+    auto *seg = details::segment_pool::this_thread().acquire(capacity);
+    if (m_segment) {
+      std::memcpy(seg->data(), m_segment->data(), m_used);
+      details::release(m_segment);
+    }
+    m_segment = seg;
+  }
+
+  void build_index(std::string_view head, const http_parser &p) {
+    auto &rsp = m_response;
+    auto *base = m_segment->data() + rsp.m_index_off;
+    auto *entries = reinterpret_cast<details::header_entry *>(base);
+    auto *table = reinterpret_cast<uint16_t *>(entries + rsp.m_header_cnt);
+    std::memset(table, 0, rsp.m_table_size * sizeof(uint16_t));
+    auto mask = rsp.m_table_size - 1;
+
+    for (uint32_t n = 0; n < rsp.m_header_cnt; ++n) {
+      auto &h = p.headers[n];
+      auto name = std::string_view{h.name, h.name_len};
+      auto *e = new (entries + n) details::header_entry{
+          .hash = details::header_hash(name),
+          .name_off = offset_of(head, h.name),
+          .name_len = static_cast<uint32_t>(h.name_len),
+          .value_off = offset_of(head, h.value),
+          .value_len = static_cast<uint32_t>(h.value_len),
+      };
+      // a folded line continues the previous value , not indexed
+      if (name.empty())
+        continue;
+      auto i = e->hash & mask;
+      for (; table[i] != 0; i = (i + 1) & mask) {
+        auto &other = entries[table[i] - 1];
+        if (other.hash == e->hash &&
+            ascii_iequals(head.substr(other.name_off, other.name_len), name))
+          break;
+      }
+      if (table[i] == 0)
+        table[i] = static_cast<uint16_t>(n + 1);
+    }
+  }
+
+private:
+  http_view_response m_response{};
+  details::buffer_segment *m_segment{};
+  std::size_t m_used{};
+};
+
+} // namespace coio
+
+#endif
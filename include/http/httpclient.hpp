@@ -1,18 +1,28 @@
 #ifndef COIO_HTTP_CLIENT_HPP
 #define COIO_HTTP_CLIENT_HPP
 
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string_view>
+#include <vector>
 
+#include "async_generator.hpp"
 #include "common/result_type.hpp"
 #include "common/scope_guard.hpp"
+#include "common/string_search.hpp"
 #include "future.hpp"
+#include "http/connection_pool.hpp"
+#include "http/dns_cache.hpp"
 #include "http/http_parser.hpp"
-#include "http/resolver.hpp"
+#include "http/http_view_response.hpp"
 #include "http/url.hpp"
+#include "ioutils/buffered_stream.hpp"
+#include "ioutils/happy_eyeballs.hpp"
 #include "ioutils/tcp.hpp"
-#include "stream_buffer.hpp"
 
 namespace coio {
 
@@ -45,11 +55,19 @@ struct http_response {
   int status_code;
 };
 
-// not thread safe
-// TODO : support trunk , keep-alive
+// see http_client::stream
+struct http_stream_response {
+  http_header header{};
+  std::optional<std::size_t> content_length{}; // none : chunked or until close
+  int status_code;
+  async_generator<std::string_view> body;
+};
+
+// not thread safe , concurrent requests on one client share its pool.
+// HTTP/1.1 , connections are kept alive per host (see http_pool_options).
 class http_client {
 public:
-  explicit http_client() : m_parser(std::make_unique<http_parser>()){};
+  explicit http_client(http_pool_options opts = {}) : m_pool(opts) {}
 
 public:
   auto get(std::string_view url) { return request(http_method::get, url, ""); }
@@ -60,192 +78,537 @@ public:
 
   auto request(http_method method, std::string_view url, std::string_view body)
       -> future<result<http_response, std::string>> {
+    // 1.parse uri
+    auto url_result = check_request(method, url, body);
+    if (url_result.is_error())
+      co_return error(std::move(url_result.get_error()));
+
+    // 2.request / response head
+    auto sent = co_await send_request(method, url_result.value(), body);
+    if (!sent.conn)
+      co_return std::move(sent.ex.response);
+
+    // 3.the whole body
+    sent.ex.response.value().header = copy_header(sent.conn->parser);
+    co_await read_body(*sent.conn, sent.ex);
+    auto keep_alive = sent.ex.keep_alive && sent.conn->reader.buffered() == 0;
+    m_pool.release(std::move(sent.conn), keep_alive);
+    co_return std::move(sent.ex.response);
+  }
 
-    if (method != http_method::post && !body.empty())
-      co_return error("method error");
+  // the body is read as the caller pulls it , in slices as they arrive.
+  // e.g. a large download written to a file without holding it in memory :
+  //
+  //  auto rsp = co_await client.stream(http_method::get , url);
+  //  while (auto *slice = co_await rsp.value().body.next())
+  //    co_await f.write(*slice);
+  //
+  // the connection goes back to the pool once the body is read to its end ,
+  // it is closed if the body is dropped before.
+  auto stream(http_method method, std::string_view url,
+              std::string_view body = "")
+      -> future<result<http_stream_response, std::string>> {
+    auto url_result = check_request(method, url, body);
+    if (url_result.is_error())
+      co_return error(std::move(url_result.get_error()));
+
+    auto sent = co_await send_request(method, url_result.value(), body);
+    if (!sent.conn)
+      co_return error(std::move(sent.ex.response.get_error()));
+
+    auto &head = sent.ex.response.value();
+    auto length = sent.ex.body == body_kind::length
+                      ? std::optional{head.body_length}
+                      : std::nullopt;
+    co_return http_stream_response{
+        .header = copy_header(sent.conn->parser),
+        .content_length = length,
+        .status_code = head.status_code,
+        .body = stream_body(std::move(sent.conn), sent.ex.body,
+                            head.body_length, sent.ex.keep_alive),
+    };
+  }
 
-    // 1.parse uri
-    auto url_result = url::parse(url);
+  auto get_view(std::string_view url) {
+    return request_view(http_method::get, url, "");
+  }
+
+  // like request() , but the response is a single buffer with headers and
+  // body as views into it : no per header strings , no body copy out of a
+  // string. one pooled segment for a response that fits it.
+  auto request_view(http_method method, std::string_view url,
+                    std::string_view body)
+      -> future<result<http_view_response, std::string>> {
+    auto url_result = check_request(method, url, body);
     if (url_result.is_error())
-      co_return error("invalid url");
-    auto &u = url_result.value();
-    if (u.proto != "http") {
-      // still not supported
-      co_return error("unsupport protocal");
+      co_return error(std::move(url_result.get_error()));
+
+    auto sent = co_await send_request(method, url_result.value(), body);
+    if (!sent.conn)
+      co_return error(std::move(sent.ex.response.get_error()));
+
+    auto &c = *sent.conn;
+    auto &ex = sent.ex;
+    auto err = ""s;
+    // built in the try , the connection goes back to the pool on any failure
+    auto builder = std::optional<http_view_response::builder>{};
+    try {
+      auto hint =
+          ex.body == body_kind::length ? ex.response.value().body_length : 0;
+      builder.emplace(ex.head, c.parser, hint);
+      auto slices =
+          body_slices(c.reader, ex.body, ex.response.value().body_length);
+      while (auto *slice = co_await slices.next())
+        builder->append_body(*slice);
+    } catch (const std::exception &e) {
+      err = e.what();
+    }
+    auto keep_alive =
+        err.empty() && ex.keep_alive && c.reader.buffered() == 0;
+    m_pool.release(std::move(sent.conn), keep_alive);
+    if (!err.empty())
+      co_return error(std::move(err));
+    co_return std::move(*builder).finish();
+  }
+
+  // HTTP/1.1 pipelining : a GET written on a keep-alive connection of the
+  // host without waiting for the responses before it. the request is queued
+  // right away , requests queued in the same loop turn go out in one send ,
+  // at most max_pipeline_depth of them unanswered. responses are read in
+  // order , requests a closing peer left unanswered are resent on another
+  // connection.
+  //
+  //  auto a = client.pipelined_get(url_a);
+  //  auto b = client.pipelined_get(url_b);
+  //  auto ra = co_await std::move(a);
+  //  auto rb = co_await std::move(b);
+  //
+  // a started future must be awaited to the end.
+  auto pipelined_get(std::string_view url)
+      -> future<result<http_response, std::string>> {
+    auto req = std::make_shared<pipelined_request>();
+    req->target = url;
+    auto url_result = url::parse(req->target);
+    if (url_result.is_error())
+      req->response = error("invalid url"s);
+    else if (url_result.value().proto != "http")
+      req->response = error("unsupport protocal"s);
+    else {
+      req->u = url_result.value();
+      auto key = host_key(req->u);
+      auto &queue = m_pipelines[key];
+      queue.pending.push_back(req);
+      if (!queue.running) {
+        queue.running = true;
+        // next loop turn , requests made until then share the first send
+        io_context::current_context()->post([this, key = std::move(key)] {
+          io_context::current_context()->co_spawn(run_pipeline(key));
+        });
+      }
     }
+    return wait_pipelined(std::move(req));
+  }
 
-    // 2.query dns
-    auto addr_list = co_await async_query(std::string(u.host).c_str(), "http");
-    if (!addr_list)
-      co_return error("invalid host name");
+  void add_header(std::string k, std::string v) { m_headers[k] = v; }
 
-    // 3.connect
-    if (!co_await connect(std::move(addr_list.value())))
-      co_return error("host connection failed");
+  http_connection_pool &pool() noexcept { return m_pool; }
 
-    // 7.close
-    auto _ = scope_guard{[this]() noexcept { m_tcp_client.socket().close(); }};
+private:
+  using connection = details::http_connection;
 
-    auto msg = build_msg(u, method, body);
-    // printf("[send request] : \n%s\n" , msg.c_str());
+  using connection_ptr = http_connection_pool::connection_ptr;
 
-    // 4.do request write
-    co_await m_tcp_client.socket().send(
-        std::as_bytes(std::span{msg.data(), msg.size()}));
+  enum class body_kind { none, length, chunked, until_close };
 
-    // 5.recv header
-    if (!(co_await read_headers()))
-      co_return error("http response parse error");
+  struct exchange_result {
+    result<http_response, std::string> response;
+    bool keep_alive{};
+    bool no_response{}; // failed before any byte of the response
+    body_kind body{};
+    std::string_view head{}; // in the reader , valid until the body is read
+  };
 
-    // puts("parse headers");
-    // 6.recv body
-    http_response response{
-        .header = http_header{m_parser->headers |
-                              std::views::take(m_parser->headers_cnt)},
-        .body_length = m_parser->body_len,
-        .status_code = m_parser->status,
-    };
+  struct pipelined_request {
+    std::string target{}; // u refers to it
+    url u{};
+    std::optional<result<http_response, std::string>> response{};
+    std::coroutine_handle<> waiter{};
+    int retries{};
+  };
+  using pipelined_ptr = std::shared_ptr<pipelined_request>;
 
-    if (m_parser->body_len == 0)
-      co_return response;
-    response.rsp = co_await read_body(m_parser->body_len);
+  struct pipeline_queue {
+    std::deque<pipelined_ptr> pending{};
+    bool running{}; // a run_pipeline owns the queue
+  };
 
-    co_return std::move(response);
+  static std::string host_key(const url &u) {
+    return std::string{u.host}.append(":").append(u.port.empty() ? "80"sv
+                                                                 : u.port);
   }
 
-  void add_header(std::string k, std::string v) { m_headers[k] = v; }
+  static auto wait_pipelined(pipelined_ptr req)
+      -> future<result<http_response, std::string>> {
+    struct awaiter {
+      pipelined_request &req;
+      bool await_ready() const noexcept { return req.response.has_value(); }
+      void await_suspend(std::coroutine_handle<> h) noexcept { req.waiter = h; }
+      void await_resume() const noexcept {}
+    };
+    co_await awaiter{*req};
+    co_return std::move(*req->response);
+  }
 
-private:
-  future<bool> connect(address_list list) {
-    for (auto &addr_view : list) {
-      try {
-        co_await m_tcp_client.connect(addr_view.to_address());
-        co_return true;
-      } catch (...) {
-        continue;
+  static void complete(pipelined_request &req,
+                       result<http_response, std::string> response) {
+    req.response = std::move(response);
+    if (req.waiter)
+      io_context::current_context()->post([h = req.waiter] { h.resume(); });
+  }
+
+  // drains the queue of one host , a connection at a time
+  future<void> run_pipeline(std::string key) {
+    auto &queue = m_pipelines.find(key)->second;
+    auto depth = std::max<std::size_t>(1, m_pool.options().max_pipeline_depth);
+    while (!queue.pending.empty()) {
+      auto conn = co_await m_pool.acquire(key);
+      auto reused = conn->connected;
+      if (!conn->connected) {
+        auto err = co_await connect(*conn, queue.pending.front()->u);
+        if (!err.empty()) {
+          m_pool.release(std::move(conn), false);
+          for (auto &req : std::exchange(queue.pending, {}))
+            complete(*req, error(err));
+          break;
+        }
       }
+      auto keep_alive = co_await pipeline_batch(*conn, queue, depth, reused);
+      m_pool.release(std::move(conn), keep_alive);
     }
-    co_return false;
+    queue.running = false;
   }
 
-  future<bool> read_headers() {
-    auto head = co_await read_until(DCRLF);
-    // read http head error
-    if (head.empty() || !head.ends_with(DCRLF))
-      co_return false;
-    // printf("[recv header] \n%s\n" , head.c_str());
+  // writes up to depth queued requests back to back and reads their
+  // responses , the unanswered ones go back to the front of the queue.
+  // true if the connection is clean for more requests.
+  future<bool> pipeline_batch(connection &c, pipeline_queue &queue,
+                              std::size_t depth, bool reused) {
+    auto batch = std::vector<pipelined_ptr>{};
+    while (batch.size() < depth && !queue.pending.empty()) {
+      batch.push_back(std::move(queue.pending.front()));
+      queue.pending.pop_front();
+    }
 
-    // parse head error if res < 0
-    co_return m_parser->parse_response(head);
+    auto keep_alive = true;
+    auto answered = std::size_t{};
+    auto closed = ""s; // why the peer stopped answering
+    try {
+      for (auto &req : batch)
+        write_request(c.writer, req->u, http_method::get, "");
+      co_await c.writer.flush();
+    } catch (const std::exception &e) {
+      closed = e.what();
+    }
+
+    while (closed.empty() && answered < batch.size()) {
+      auto ex = co_await read_response(c, http_method::get);
+      if (ex.no_response) {
+        closed = std::move(ex.response.get_error());
+        break;
+      }
+      // after an error the stream position is unknown
+      auto last = ex.response.is_error() || !ex.keep_alive;
+      complete(*batch[answered++], std::move(ex.response));
+      if (last) {
+        keep_alive = false;
+        break;
+      }
+    }
+
+    if (!closed.empty()) {
+      keep_alive = false;
+      // closed without a word , probably an idle timeout : the first
+      // unanswered one is retried once , unless a fresh connection never
+      // answered at all
+      auto &req = *batch[answered];
+      if ((!reused && answered == 0) || ++req.retries > 1) {
+        complete(req, error(std::move(closed)));
+        ++answered;
+      }
+    }
+    for (auto i = batch.size(); i > answered; --i)
+      queue.pending.push_front(std::move(batch[i - 1]));
+    co_return keep_alive && c.reader.buffered() == 0;
   }
 
-  future<std::string> read_body(std::size_t need_read) {
-    if (need_read == 0)
+  // empty on success
+  future<std::string> connect(connection &c, const url &u) {
+    auto service = u.port.empty() ? "http"s : std::string(u.port);
+    auto addrs = co_await dns_cache::current().lookup(u.host, service);
+    if (!addrs)
+      co_return "invalid host name"s;
+
+    try {
+      c.conn = co_await happy_eyeballs_connect(*addrs);
+      c.conn.set_no_delay();
+      c.connected = true;
       co_return ""s;
+    } catch (const std::system_error &) {
+    }
+    co_return "host connection failed"s;
+  }
+
+  struct sent_request {
+    connection_ptr conn; // null on error , the body is still unread
+    exchange_result ex;
+  };
 
-    constexpr std::size_t min_buf_sz = 64;
-    std::size_t n = 0;
-    std::string rsp{};
-    if (auto s = m_read_streambuf.try_get_data(need_read); s) {
-      rsp.append(*s);
-      m_read_streambuf.consume(s->size());
-      co_return rsp;
+  static http_header copy_header(const http_parser &p) {
+    return http_header{p.headers | std::views::take(p.headers_cnt)};
+  }
+
+  static auto check_request(http_method method, std::string_view url,
+                            std::string_view body)
+      -> result<coio::url, std::string> {
+    if (method != http_method::post && !body.empty())
+      return error("method error"s);
+    auto url_result = url::parse(url);
+    if (url_result.is_error())
+      return error("invalid url"s);
+    if (url_result.value().proto != "http") {
+      // still not supported
+      return error("unsupport protocal"s);
     }
+    return url_result.value();
+  }
 
-    rsp.append(m_read_streambuf.data());
-    m_read_streambuf.consume(rsp.size());
-    need_read -= rsp.size();
+  // sends the request on a pooled or new connection and reads the head
+  // of the response
+  future<sent_request> send_request(http_method method, const url &u,
+                                    std::string_view body) {
+    auto key = host_key(u);
+    for (int attempt = 0;; ++attempt) {
+      auto conn = co_await m_pool.acquire(key);
+      auto reused = conn->connected;
+      if (!conn->connected) {
+        if (auto err = co_await connect(*conn, u); !err.empty()) {
+          m_pool.release(std::move(conn), false);
+          co_return sent_request{
+              .ex = {.response = error(std::move(err))},
+          };
+        }
+      }
 
-    rsp.reserve(need_read);
-    try {
-      while (need_read > 0) {
-        n = co_await m_tcp_client.recv(
-            m_read_streambuf.prepare(std::max(need_read, min_buf_sz)));
-        if (n == 0)
-          break;
-        if (n >= need_read)
-          n = need_read;
-        need_read -= n;
-        m_read_streambuf.commit(n);
+      auto err = ""s;
+      try {
+        // head and body go out in one send
+        write_request(conn->writer, u, method, body);
+        co_await conn->writer.flush();
+      } catch (const std::exception &e) {
+        err = e.what();
       }
-    } catch (const std::exception &e) {
+      auto ex = exchange_result{.response = error(err), .no_response = true};
+      if (err.empty())
+        ex = co_await read_head(*conn, method);
+      if (!ex.response.is_error())
+        co_return sent_request{.conn = std::move(conn), .ex = std::move(ex)};
+      m_pool.release(std::move(conn), false);
+
+      // the peer may close an idle connection just as it is reused ,
+      // idempotent requests are retried once on a fresh one
+      if (ex.no_response && reused && attempt == 0 &&
+          method != http_method::post)
+        continue;
+      co_return sent_request{.ex = std::move(ex)};
     }
-    rsp.append(m_read_streambuf.data());
-    m_read_streambuf.consume(rsp.size());
-    co_return rsp;
-  }
-
-  future<std::string> read_until(std::string_view delim) {
-    auto buf = m_read_streambuf.prepare(512);
-    std::size_t n = 0;
-    std::size_t beg = 0;
-    std::string result{};
-
-    while (n = co_await m_tcp_client.recv(buf), n != 0) {
-      m_read_streambuf.commit(n);
-      auto str = m_read_streambuf.data();
-      auto pos = str.find(delim, beg);
-      if (pos != std::string_view::npos) {
-        pos += delim.size();
-        result = std::string(str.substr(0, pos));
-        m_read_streambuf.consume(pos);
-        break;
+  }
+
+  void write_request(buffered_writer<tcp_sock<ip>> &w, const url &u,
+                     http_method method, std::string_view body) {
+    write_head(w, u, method, body);
+    w.write(body);
+  }
+
+  // one response off the reader , bytes after it are left buffered
+  future<exchange_result> read_response(connection &c, http_method method) {
+    auto ex = co_await read_head(c, method);
+    if (!ex.response.is_error())
+      ex.response.value().header = copy_header(c.parser);
+    co_await read_body(c, ex);
+    co_return ex;
+  }
+
+  future<exchange_result> read_head(connection &c, http_method method) {
+    auto err = ""s;
+    auto no_response = true;
+    try {
+      // parsed headers point into the reader , valid until the body is read
+      auto head = co_await c.reader.read_until(DCRLF);
+      auto &p = c.parser;
+      no_response = head.empty();
+      if (head.empty()) {
+        err = "connection closed";
+      } else if (!head.ends_with(DCRLF) || p.parse_response(head) <= 0) {
+        err = "http response parse error";
       } else {
-        beg = str.size() > delim.size() ? str.size() - delim.size() : 0;
+        auto body = body_kind::none;
+        if (p.has_body(method == http_method::head))
+          body = p.chunked              ? body_kind::chunked
+                 : p.has_content_length ? body_kind::length
+                                        : body_kind::until_close;
+        co_return exchange_result{
+            .response = http_response{.body_length = p.body_len,
+                                      .status_code = p.status},
+            .keep_alive = p.keep_alive() && body != body_kind::until_close,
+            .body = body,
+            .head = head,
+        };
       }
-      buf = m_read_streambuf.prepare(256);
+    } catch (const std::exception &e) {
+      err = e.what();
     }
+    co_return exchange_result{.response = error(std::move(err)),
+                              .no_response = no_response};
+  }
 
-    if (result.empty()) {
-      result = m_read_streambuf.data();
-      m_read_streambuf.consume(result.size());
+  // the whole body into the response of ex
+  static future<void> read_body(connection &c, exchange_result &ex) {
+    if (ex.response.is_error())
+      co_return;
+    auto &rsp = ex.response.value();
+    auto err = ""s;
+    try {
+      if (ex.body == body_kind::length)
+        rsp.rsp.reserve(rsp.body_length);
+      auto slices = body_slices(c.reader, ex.body, rsp.body_length);
+      while (auto *slice = co_await slices.next())
+        rsp.rsp.append(*slice);
+      rsp.body_length = rsp.rsp.size();
+    } catch (const std::exception &e) {
+      err = e.what();
+    }
+    if (!err.empty()) {
+      ex.response = error(std::move(err));
+      ex.keep_alive = false;
     }
-    co_return result;
   }
 
-  std::string build_msg(const url &u, http_method method,
-                        std::string_view body) {
-    std::string write_msg{};
-    write_msg.reserve(128);
-    write_msg.append(to_str(method));
-    write_msg.append(" ").append(u.path);
-    if (!u.query.empty())
-      write_msg.append("?").append(u.query);
-    write_msg.append(" HTTP/1.0\r\nHost:").append(u.host).append(CRLF);
+  // body of the response whose head was just read , as it arrives.
+  // chunked bodies are decoded a read at a time , trailers are skipped.
+  static async_generator<std::string_view>
+  body_slices(buffered_reader<tcp_sock<ip>> &reader, body_kind kind,
+              std::size_t length) {
+    switch (kind) {
+    case body_kind::none:
+      break;
+    case body_kind::length:
+      while (length > 0) {
+        auto s = co_await reader.read_some(length);
+        if (s.empty())
+          throw std::runtime_error{"response body truncated"};
+        length -= s.size();
+        co_yield s;
+      }
+      break;
+    case body_kind::until_close:
+      while (true) {
+        auto s = co_await reader.read_some(SIZE_MAX);
+        if (s.empty())
+          break;
+        co_yield s;
+      }
+      break;
+    case body_kind::chunked: {
+      auto decoder = phr_chunked_decoder{.consume_trailer = 1};
+      auto decoded = std::string{}; // decoded in place , the reader's is const
+      while (true) {
+        auto s = co_await reader.read_some(SIZE_MAX);
+        if (s.empty())
+          throw std::runtime_error{"invalid chunked body"};
+        decoded.assign(s);
+        auto n = decoded.size();
+        auto ret = phr_decode_chunked(&decoder, decoded.data(), &n);
+        if (ret == -1)
+          throw std::runtime_error{"invalid chunked body"};
+        // bytes after the last chunk belong to the next response
+        if (ret >= 0)
+          reader.put_back(ret);
+        if (n > 0)
+          co_yield std::string_view{decoded.data(), n};
+        if (ret >= 0)
+          break;
+      }
+      break;
+    }
+    }
+  }
+
+  // owns the connection while the caller reads the body
+  async_generator<std::string_view> stream_body(connection_ptr conn,
+                                                body_kind kind,
+                                                std::size_t length,
+                                                bool keep_alive) {
+    auto done = false;
+    auto release = scope_guard{[&]() noexcept {
+      auto clean = done && keep_alive && conn->reader.buffered() == 0;
+      m_pool.release(std::move(conn), clean);
+    }};
+    auto slices = body_slices(conn->reader, kind, length);
+    while (auto *slice = co_await slices.next())
+      co_yield *slice;
+    done = true;
+  }
+
+  void write_head(buffered_writer<tcp_sock<ip>> &w, const url &u,
+                  http_method method, std::string_view body) {
+    w.write(to_str(method));
+    w.write(" ");
+    w.write(u.path);
+    if (!u.query.empty()) {
+      w.write("?");
+      w.write(u.query);
+    }
+    w.write(" HTTP/1.1\r\nHost:");
+    w.write(u.host);
+    if (!u.port.empty()) {
+      w.write(":");
+      w.write(u.port);
+    }
+    w.write(CRLF);
 
     for (auto &[k, v] : m_headers) {
-      write_msg.append(k).append(": ").append(v).append(CRLF);
+      w.write(k);
+      w.write(": ");
+      w.write(v);
+      w.write(CRLF);
     }
 
     if (!body.empty() || method == http_method::post) {
-      write_msg.append("Content-Length: ")
-          .append(std::to_string(body.size()))
-          .append(CRLF);
+      w.write("Content-Length: ");
+      w.write(std::to_string(body.size()));
+      w.write(CRLF);
     }
 
-    // default keep-alive
-    // if (!m_headers.contains("Connection")) {
-    //   write_msg.append("Connection: keep-alive\r\n");
-    // }
-
-    write_msg.append(CRLF);
-
-    if (!body.empty()) {
-      write_msg.append(body);
+    // keep-alive is the 1.1 default , say so unless the pool keeps nothing
+    auto has_connection = std::ranges::any_of(m_headers, [](auto &h) {
+      return ascii_iequals(h.first, "Connection");
+    });
+    if (!has_connection) {
+      w.write(m_pool.options().max_idle_per_host > 0
+                  ? "Connection: keep-alive\r\n"sv
+                  : "Connection: close\r\n"sv);
     }
 
-    return write_msg;
+    w.write(CRLF);
   }
 
 private:
   static inline constexpr auto CRLF = "\r\n"sv;
   static inline constexpr auto DCRLF = "\r\n\r\n"sv;
 
-  // ipv4
-  connector<> m_tcp_client;
-  stream_buffer m_read_streambuf;
-  std::unique_ptr<http_parser> m_parser;
+  http_connection_pool m_pool;
   std::map<std::string, std::string, std::less<>> m_headers;
+  std::map<std::string, pipeline_queue, std::less<>> m_pipelines;
 };
 
 } // namespace coio
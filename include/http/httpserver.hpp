@@ -0,0 +1,476 @@
+#ifndef COIO_HTTP_SERVER_HPP
+#define COIO_HTTP_SERVER_HPP
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+#include "common/string_search.hpp"
+#include "future.hpp"
+#include "http/http_parser.hpp"
+#include "io_context.hpp"
+#include "ioutils/tcp.hpp"
+#include "stream_buffer.hpp"
+#include "time_delay.hpp"
+
+namespace coio {
+
+using namespace std::literals;
+
+// a request parsed in place , every view points into the read buffer of
+// its connection and is valid while the handler runs.
+struct http_request {
+  std::string_view method{};
+  std::string_view target{}; // path?query as sent
+  std::string_view path{};
+  std::string_view query{};
+  std::string_view body{};
+  int minor_version{};
+  std::span<const phr_header> headers{};
+
+  // nullopt if not contains this header , "" value is allowed
+  std::optional<std::string_view>
+  header(std::string_view name) const noexcept {
+    for (auto &h : headers)
+      if (ascii_iequals({h.name, h.name_len}, name))
+        return std::string_view{h.value, h.value_len};
+    return std::nullopt;
+  }
+
+  // the connection can carry another request after this one
+  bool keep_alive() const noexcept {
+    auto conn = header("connection").value_or(""sv);
+    return minor_version >= 1 ? !ascii_iequals(conn, "close")
+                              : ascii_iequals(conn, "keep-alive");
+  }
+};
+
+namespace details {
+
+inline std::string_view status_reason(int status) noexcept {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 204:
+    return "No Content";
+  case 301:
+    return "Moved Permanently";
+  case 302:
+    return "Found";
+  case 304:
+    return "Not Modified";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 413:
+    return "Payload Too Large";
+  case 500:
+    return "Internal Server Error";
+  case 501:
+    return "Not Implemented";
+  case 503:
+    return "Service Unavailable";
+  default:
+    return "";
+  }
+}
+
+class response_batch;
+
+} // namespace details
+
+// the answer of a handler , 200 with an empty body unless set.
+// one reply is reused for every request of a connection.
+class http_reply : non_copyable {
+public:
+  void status(int code, std::string_view reason = {}) {
+    m_status = code;
+    m_reason = reason.empty() ? details::status_reason(code) : reason;
+  }
+
+  // Content-Length and Connection are added by the server
+  void header(std::string_view name, std::string_view value) {
+    m_headers.append(name).append(": ").append(value).append("\r\n");
+  }
+
+  // copied into the output of the connection
+  void body(std::string_view b) {
+    m_body.assign(b);
+    m_body_ref.reset();
+  }
+
+  void append_body(std::string_view b) {
+    m_body.append(b);
+    m_body_ref.reset();
+  }
+
+  // sent straight from b , no copy. b must stay valid until the reply is
+  // sent (static content , a cache entry ...) , so not the request memory.
+  void body_ref(std::string_view b) {
+    m_body.clear();
+    m_body_ref = b;
+  }
+
+  int status_code() const noexcept { return m_status; }
+
+private:
+  friend class details::response_batch;
+  friend class http_server;
+
+  std::string_view body_view() const noexcept {
+    return m_body_ref ? *m_body_ref : std::string_view{m_body};
+  }
+
+  // keeps the capacity of the strings
+  void reset() noexcept {
+    m_status = 200;
+    m_reason.clear();
+    m_headers.clear();
+    m_body.clear();
+    m_body_ref.reset();
+  }
+
+private:
+  int m_status{200};
+  std::string m_reason{};
+  std::string m_headers{};
+  std::string m_body{};
+  std::optional<std::string_view> m_body_ref{};
+};
+
+namespace details {
+
+// responses of one read , serialized back to back and sent by one sendmsg.
+// heads and copied bodies share one string , referenced bodies are
+// gathered in place.
+class response_batch : non_copyable {
+public:
+  static constexpr std::size_t max_pieces = 64;
+  static constexpr std::size_t max_bytes = 64 * 1024;
+
+  void add(const http_reply &r, bool head_request, bool close) {
+    // 1xx , 204 and 304 carry neither a body nor its length (rfc 9110 8.6)
+    auto bodiless = (r.m_status >= 100 && r.m_status < 200) ||
+                    r.m_status == 204 || r.m_status == 304;
+    auto body = r.body_view();
+    auto start = m_out.size();
+    m_out.append("HTTP/1.1 ");
+    append_number(r.m_status);
+    m_out.append(" ").append(r.m_reason.empty()
+                                 ? status_reason(r.m_status)
+                                 : std::string_view{r.m_reason});
+    if (!bodiless) {
+      m_out.append("\r\nContent-Length: ");
+      append_number(body.size());
+    }
+    m_out.append(close ? "\r\nConnection: close\r\n"sv : "\r\n"sv);
+    m_out.append(r.m_headers).append("\r\n");
+    if (head_request || bodiless) {
+      push_out(start);
+    } else if (r.m_body_ref) {
+      push_out(start);
+      m_pieces.push_back({.ptr = body.data(), .len = body.size()});
+      m_bytes += body.size();
+    } else {
+      m_out.append(body);
+      push_out(start);
+    }
+  }
+
+  bool empty() const noexcept { return m_pieces.empty(); }
+
+  // send before more responses are added
+  bool full() const noexcept {
+    return m_pieces.size() >= max_pieces || m_out.size() + m_bytes >= max_bytes;
+  }
+
+  future<void> send(tcp_sock<> &sock) {
+    m_iov.clear();
+    for (auto &p : m_pieces) {
+      auto *ptr = p.ptr ? p.ptr : m_out.data() + p.off;
+      m_iov.push_back(std::as_bytes(std::span{ptr, p.len}));
+    }
+    auto iov = std::span{m_iov};
+    while (!iov.empty()) {
+      auto n = co_await sock.sendmsg(iov);
+      while (n > 0 && n >= iov.front().size()) {
+        n -= iov.front().size();
+        iov = iov.subspan(1);
+      }
+      if (n > 0)
+        iov.front() = iov.front().subspan(n);
+    }
+    m_out.clear();
+    m_pieces.clear();
+    m_bytes = 0;
+  }
+
+private:
+  struct piece {
+    const char *ptr{}; // nullptr : at off in m_out
+    std::size_t off{};
+    std::size_t len{};
+  };
+
+  void append_number(std::size_t n) {
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), n);
+    m_out.append(buf, end);
+  }
+
+  // m_out from start on , merged with the previous piece if adjacent
+  void push_out(std::size_t start) {
+    if (!m_pieces.empty() && !m_pieces.back().ptr &&
+        m_pieces.back().off + m_pieces.back().len == start)
+      m_pieces.back().len = m_out.size() - m_pieces.back().off;
+    else
+      m_pieces.push_back({.off = start, .len = m_out.size() - start});
+  }
+
+private:
+  std::string m_out{};
+  std::vector<piece> m_pieces{};
+  std::vector<std::span<const std::byte>> m_iov{};
+  std::size_t m_bytes{}; // referenced body bytes
+};
+
+} // namespace details
+
+struct http_server_options {
+  // head + body of one request , larger ones are answered 413
+  std::size_t max_request_size = 1024 * 1024;
+  // accepting pauses this long while out of fds or memory
+  std::chrono::milliseconds accept_backoff{10};
+};
+
+// HTTP/1.1 server , single threaded like its io_context.
+// requests are parsed in place by phr_parse_request and routed by exact
+// path then method. pipelined requests read together are answered by one
+// gathered sendmsg , connections are kept alive unless asked otherwise.
+//
+//  auto server = http_server{};
+//  server.get("/hello" , [](const http_request &req , http_reply &rep) {
+//    rep.header("Content-Type" , "text/plain");
+//    rep.body_ref("hello");
+//  });
+//  ctx.co_spawn(server.serve(acceptor));
+//
+// request bodies need a Content-Length , chunked ones are answered 501.
+// the server must outlive its connections.
+class http_server : non_copyable {
+public:
+  using handler = std::function<void(const http_request &, http_reply &)>;
+
+  explicit http_server(http_server_options opts = {}) : m_opts(opts) {}
+
+public:
+  http_server &route(std::string_view method, std::string_view path,
+                     handler h) {
+    auto &methods = m_routes[std::string{path}];
+    methods.emplace_back(std::string{method}, std::move(h));
+    return *this;
+  }
+
+  http_server &get(std::string_view path, handler h) {
+    return route("GET", path, std::move(h));
+  }
+
+  http_server &post(std::string_view path, handler h) {
+    return route("POST", path, std::move(h));
+  }
+
+  // paths without a route , 404 if not set
+  http_server &fallback(handler h) {
+    m_fallback = std::move(h);
+    return *this;
+  }
+
+  // accepts with one multishot accept , the acceptor must be listening
+  future<void> serve(acceptor<> &acceptor) {
+    auto accepts = acceptor.accept_multishot();
+    while (true) {
+      auto exhausted = false;
+      try {
+        auto sock = co_await accepts.next();
+        sock.set_no_delay();
+        io_context::current_context()->co_spawn(
+            serve_connection(std::move(sock)));
+      } catch (const std::system_error &e) {
+        // out of fds , an aborted handshake ... keep accepting
+        auto err = e.code().value();
+        if (err == EBADF || err == EINVAL || err == ENOTSOCK)
+          throw;
+        exhausted = err == EMFILE || err == ENFILE || err == ENOBUFS ||
+                    err == ENOMEM;
+      }
+      // the next accept would fail right away , give fds time to close
+      if (exhausted) {
+        auto backoff = m_opts.accept_backoff;
+        co_await time_delay(std::move(backoff));
+      }
+    }
+  }
+
+  future<void> serve_connection(tcp_sock<> sock) {
+    static constexpr std::size_t read_size = 16 * 1024;
+    auto in = stream_buffer{m_opts.max_request_size};
+    auto headers = std::array<phr_header, max_headers>{};
+    auto reply = http_reply{};
+    auto batch = details::response_batch{};
+    auto close = false;
+    try {
+      while (!close) {
+        // every complete request read so far , answered together
+        while (!close && in.size() > 0) {
+          auto data = in.data();
+          auto req = http_request{};
+          const char *method{}, *path{};
+          std::size_t method_len{}, path_len{}, headers_cnt = headers.size();
+          auto head_len = phr_parse_request(
+              data.data(), data.size(), &method, &method_len, &path,
+              &path_len, &req.minor_version, headers.data(), &headers_cnt, 0);
+          if (head_len == -2)
+            break;
+          req.method = {method, method_len};
+          req.target = {path, path_len};
+          req.headers = {headers.data(), headers_cnt};
+
+          auto body_len = std::size_t{};
+          auto status = head_len == -1 ? 400 : 0;
+          if (status == 0 && req.header("transfer-encoding"))
+            status = 501;
+          if (status == 0) {
+            auto len = content_length(req);
+            status = len ? 0 : 400;
+            body_len = len.value_or(0);
+          }
+          // no head_len + body_len , a length near SIZE_MAX wraps the sum
+          if (status == 0 &&
+              body_len > m_opts.max_request_size - std::size_t(head_len))
+            status = 413;
+          if (status != 0) {
+            reply.reset();
+            reply.status(status);
+            batch.add(reply, false, close = true);
+            break;
+          }
+          if (data.size() < head_len + body_len)
+            break; // the body is not all here
+
+          auto q = req.target.find('?');
+          req.path = req.target.substr(0, q);
+          req.query = q == std::string_view::npos ? ""sv
+                                                   : req.target.substr(q + 1);
+          req.body = data.substr(head_len, body_len);
+          close = !req.keep_alive();
+          dispatch(req, reply);
+          batch.add(reply, req.method == "HEAD", close);
+          in.consume(head_len + body_len);
+          if (batch.full())
+            co_await batch.send(sock);
+        }
+        if (!batch.empty())
+          co_await batch.send(sock);
+        if (close)
+          break;
+
+        if (in.available() == 0) {
+          // a head longer than max_request_size
+          reply.reset();
+          reply.status(413);
+          batch.add(reply, false, true);
+          co_await batch.send(sock);
+          break;
+        }
+        if (in.size() == 0)
+          in.shrink(); // idle keep-alive , give memory back
+        auto n = co_await sock.recv(
+            in.prepare(std::min(read_size, in.available())));
+        if (n == 0)
+          break;
+        in.commit(n);
+      }
+    } catch (const std::exception &) {
+      // reset by peer ...
+    }
+  }
+
+private:
+  static constexpr std::size_t max_headers = 64;
+
+  // 0 without a Content-Length , nullopt for a malformed or a repeated one :
+  // a proxy in front may have framed the request by another length
+  static std::optional<std::size_t>
+  content_length(const http_request &req) noexcept {
+    auto len = std::size_t{};
+    auto seen = false;
+    for (auto &h : req.headers) {
+      if (!ascii_iequals({h.name, h.name_len}, "content-length"))
+        continue;
+      auto end = h.value + h.value_len;
+      auto [p, ec] = std::from_chars(h.value, end, len);
+      if (seen || ec != std::errc{} || p != end)
+        return std::nullopt;
+      seen = true;
+    }
+    return len;
+  }
+
+  void dispatch(const http_request &req, http_reply &reply) {
+    reply.reset();
+    try {
+      auto it = m_routes.find(req.path);
+      if (it == m_routes.end()) {
+        if (m_fallback)
+          m_fallback(req, reply);
+        else
+          reply.status(404);
+        return;
+      }
+      // HEAD falls back to the GET handler , its body is not sent
+      auto *get = static_cast<handler *>(nullptr);
+      for (auto &[method, h] : it->second) {
+        if (method == req.method) {
+          h(req, reply);
+          return;
+        }
+        if (method == "GET")
+          get = &h;
+      }
+      if (req.method == "HEAD" && get)
+        (*get)(req, reply);
+      else
+        reply.status(405);
+    } catch (...) {
+      reply.reset();
+      reply.status(500);
+    }
+  }
+
+private:
+  http_server_options m_opts;
+  std::map<std::string, std::vector<std::pair<std::string, handler>>,
+           std::less<>>
+      m_routes{};
+  handler m_fallback{};
+};
+
+} // namespace coio
+
+#endif
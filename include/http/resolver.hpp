@@ -1,39 +1,42 @@
 #ifndef COIO_RESOLVER_HPP
 #define COIO_RESOLVER_HPP
 
+#include <chrono>
 #include <coroutine>
-#include <mutex>
+#include <map>
+#include <memory>
 #include <optional>
-#include <thread>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
-#ifndef __cpp_lib_atomic_wait
-// disable content_t usage to keep this lib header only
-#define __NO_TABLE
-// https://github.com/ogiroux/atomic_wait
-#include "common/atomic_wait.hpp"
-#endif
 #include "awaitable.hpp"
+#include "common/non_copyable.hpp"
+#include "future.hpp"
 #include "io_context.hpp"
+#include "ioutils/happy_eyeballs.hpp"
 #include "ioutils/protocol.hpp"
+#include "time_delay.hpp"
 #include <ares.h>
+#include <poll.h>
 
 namespace coio {
 
-// TODO : wrap c-ares in io_uring
-// TODO : support both ipv4 and ipv6
-
 struct address_view {
   ares_addrinfo_cname *name;
   ares_addrinfo_node *node;
 
   std::string_view get_name() const noexcept { return name ? name->name : ""; }
   bool is_v4() const noexcept { return node->ai_family == AF_INET; }
-  auto to_address() const {
-    if (node->ai_addrlen != sizeof(sockaddr_in))
-      throw std::logic_error("incorrect address.");
-    auto paddr = reinterpret_cast<sockaddr_in *>(node->ai_addr);
-    return ipv4::address::from_raw_address(*paddr);
+  bool is_v6() const noexcept { return node->ai_family == AF_INET6; }
+  ip::address to_address() const {
+    if (is_v4() && node->ai_addrlen == sizeof(sockaddr_in))
+      return ip::address{ipv4::address::from_raw_address(
+          *reinterpret_cast<sockaddr_in *>(node->ai_addr))};
+    if (is_v6() && node->ai_addrlen == sizeof(sockaddr_in6))
+      return ip::address{ipv6::address::from_raw_address(
+          *reinterpret_cast<sockaddr_in6 *>(node->ai_addr))};
+    throw std::logic_error("incorrect address.");
   }
 };
 
@@ -69,55 +72,94 @@ struct address_list {
   auto end() const noexcept { return iterator_type{nullptr, nullptr}; }
 };
 
-// currently usage : poll in a single thread
+// one c-ares channel per io_context. its sockets are watched by multishot
+// poll sqes and its timeouts run on the context timer , so answers resume
+// the querying coroutine on the context thread , no helper thread.
+class async_resolver : non_copyable,
+                       public std::enable_shared_from_this<async_resolver> {
+  struct private_tag {};
+
+  // a c-ares socket and the poll completing into result ,
+  // shared with its pump until the last completion is reaped
+  struct socket_watch {
+    ares_socket_t fd;
+    unsigned events;
+    io_context::async_result result{};
+    bool closed{};
+    bool single_shot{};
+  };
 
-class async_resolver {
-private:
-  async_resolver() {
-    ares_library_init(ARES_LIB_INIT_ALL);
-    if (auto ret = ares_init(&m_channel); ret != ARES_SUCCESS) {
+  // a query in flight sleeps at most this long on the timer ,
+  // one submitted meanwhile may have an earlier timeout
+  static constexpr auto max_timer_wait = std::chrono::milliseconds{100};
+
+  // ares_library_init() is not thread safe , contexts on several threads
+  // share one init for the process , cleaned up at exit
+  struct library {
+    library() {
+      if (ares_library_init(ARES_LIB_INIT_ALL) != ARES_SUCCESS)
+        throw std::runtime_error{"c-ares library init failed."};
+    }
+    ~library() { ares_library_cleanup(); }
+
+    static void init() { static library lib{}; }
+  };
+
+public:
+  async_resolver(private_tag, io_context &ctx) : m_ctx_id(ctx.id()) {
+    library::init();
+    auto opts = ares_options{};
+    opts.sock_state_cb = &async_resolver::sock_state_callback;
+    opts.sock_state_cb_data = this;
+    if (auto ret = ares_init_options(&m_channel, &opts, ARES_OPT_SOCK_STATE_CB);
+        ret != ARES_SUCCESS) {
       throw std::runtime_error{"async_resolver init failed."};
     }
-    init();
   }
 
   ~async_resolver() {
-    m_thread.request_stop();
-    try_wakeup();
-
+    // pending queries are failed with ARES_EDESTRUCTION , their context is
+    // gone , sqes must not be submitted
+    m_destroying = true;
     ares_destroy(m_channel);
-    ares_library_cleanup();
   }
 
-  struct query_info {
-    const char *host, *service;
-    void *arg;
-  };
-
 public:
-  static async_resolver &instance() {
-    static async_resolver resolver{};
-    return resolver;
+  // the resolver of the current context , created on first use
+  static async_resolver &current() {
+    thread_local std::shared_ptr<async_resolver> resolver{};
+    auto &ctx = *io_context::current_context();
+    if (!resolver || resolver->m_ctx_id != ctx.id())
+      resolver = std::make_shared<async_resolver>(private_tag{}, ctx);
+    return *resolver;
+  }
+
+  // "host[:port],..." , instead of the servers of /etc/resolv.conf
+  void set_servers(const char *servers) {
+    if (ares_set_servers_ports_csv(m_channel, servers) != ARES_SUCCESS)
+      throw std::invalid_argument{"invalid dns servers."};
   }
 
 public:
-  struct async_query_awaiter : std::suspend_always {
+  struct async_query_awaiter {
     async_resolver &resolver;
-    std::coroutine_handle<> handle{};
     std::string host{};
     std::string service{};
-    coio::io_context *ctx;
+    int family{};
+    std::coroutine_handle<> handle{};
     ares_addrinfo *result{};
-    int status;
+    int status{};
+    bool done{};
+
+    bool await_ready() const noexcept { return false; }
 
-    void await_suspend(std::coroutine_handle<> h) {
+    // numeric hosts and /etc/hosts answer before ares_getaddrinfo returns
+    bool await_suspend(std::coroutine_handle<> h) {
+      resolver.start_query(*this);
+      if (done)
+        return false;
       handle = h;
-      {
-        auto guard = std::lock_guard{resolver.m_mut};
-        resolver.m_query_list.push_back(
-            query_info{host.c_str(), service.c_str(), this});
-      }
-      resolver.try_wakeup();
+      return true;
     }
 
     std::optional<address_list> await_resume() noexcept {
@@ -128,86 +170,158 @@ public:
     }
   };
 
+  // A and AAAA records by default , AF_INET or AF_INET6 for one of them
+  auto submit_query(std::string hostname, std::string service,
+                    int family = AF_UNSPEC) {
+    return async_query_awaiter{.resolver = *this,
+                               .host = std::move(hostname),
+                               .service = std::move(service),
+                               .family = family};
+  }
+
+private:
+  void start_query(async_query_awaiter &q) {
+    auto hints = ares_addrinfo_hints{.ai_family = q.family};
+    // c-ares answers a numeric host at once for its family only
+    if (q.family == AF_UNSPEC)
+      hints.ai_family = numeric_family(q.host.c_str());
+    ++m_pending;
+    ares_getaddrinfo(m_channel, q.host.c_str(), q.service.c_str(), &hints,
+                     query_callback, &q);
+    if (m_pending > 0 && !m_timer_running) {
+      m_timer_running = true;
+      io_context::current_context()->co_spawn(run_timeouts(shared_from_this()));
+    }
+  }
+
+  static int numeric_family(const char *host) noexcept {
+    unsigned char buf[sizeof(in6_addr)];
+    if (::inet_pton(AF_INET, host, buf) == 1)
+      return AF_INET;
+    if (::inet_pton(AF_INET6, host, buf) == 1)
+      return AF_INET6;
+    return AF_UNSPEC;
+  }
+
   static void query_callback(void *arg, int status, int timeouts,
                              ares_addrinfo *res) {
-    auto awaiter = reinterpret_cast<async_query_awaiter *>(arg);
-    awaiter->ctx->post([=]() {
-      awaiter->status = status;
-      awaiter->result = res;
-      if (awaiter->handle) [[likely]] {
-        awaiter->handle.resume();
-      }
-    });
-    instance().m_pending_cnt.fetch_sub(1, std::memory_order_relaxed);
+    auto &q = *reinterpret_cast<async_query_awaiter *>(arg);
+    q.status = status;
+    q.result = res;
+    q.done = true;
+    if (status == ARES_EDESTRUCTION)
+      return;
+    --q.resolver.m_pending;
+    // called inside ares_process_fd , resume out of c-ares
+    if (auto h = q.handle)
+      io_context::current_context()->post([h] { h.resume(); });
   }
 
-protected:
-  void init() {
-    m_thread = std::jthread([this](std::stop_token token) {
-      int nfds;
-      // int count;
-      fd_set readers, writers;
-      timeval tv, *tvp;
-      std::vector<query_info> qlist;
-      const auto def_hints = ares_addrinfo_hints{
-          .ai_family = AF_INET,
-      };
-
-      while (!token.stop_requested()) {
-        if (!m_query_list.empty()) {
-          auto guard = std::lock_guard{m_mut};
-          std::swap(qlist, m_query_list);
-        }
-
-        for (auto &q : qlist) {
-          ares_getaddrinfo(m_channel, q.host, q.service, &def_hints,
-                           query_callback, q.arg);
-        }
-        qlist.resize(0);
+  static void sock_state_callback(void *data, ares_socket_t fd, int readable,
+                                  int writable) {
+    auto &self = *static_cast<async_resolver *>(data);
+    if (self.m_destroying)
+      return;
+    auto events = (readable ? POLLIN : 0u) | (writable ? POLLOUT : 0u);
+    if (auto it = self.m_watches.find(fd); it != self.m_watches.end()) {
+      if (it->second->events == events)
+        return;
+      unwatch(*it->second);
+      self.m_watches.erase(it);
+    }
+    if (events == 0)
+      return;
+    auto w = std::make_shared<socket_watch>(fd, events);
+    self.m_watches.emplace(fd, w);
+    io_context::current_context()->co_spawn(
+        watch_socket(self.shared_from_this(), std::move(w)));
+  }
 
-        FD_ZERO(&readers);
-        FD_ZERO(&writers);
+  static void arm(socket_watch &w) {
+    io_context::current_context()->submit_detached(
+        &w.result, [&w](io_uring_sqe *sqe) {
+          if (w.single_shot)
+            ::io_uring_prep_poll_add(sqe, w.fd, w.events);
+          else
+            ::io_uring_prep_poll_multishot(sqe, w.fd, w.events);
+        });
+  }
 
-        nfds = ares_fds(m_channel, &readers, &writers);
-        if (nfds == 0)
-          break;
-        tvp = ares_timeout(m_channel, NULL, &tv);
-        select(nfds, &readers, &writers, NULL, tvp);
-        ares_process(m_channel, &readers, &writers);
+  static void unwatch(socket_watch &w) {
+    w.closed = true;
+    io_context::current_context()->submit_detached(
+        nullptr, [&r = w.result](io_uring_sqe *sqe) {
+          ::io_uring_prep_cancel(sqe, &r, 0);
+        });
+  }
 
-        // try blocking if finish all query
-        if (m_pending_cnt.load(std::memory_order_relaxed) == 0) {
-          std::atomic_wait(&m_pending_cnt, 0);
+  // the continuation of every poll completion of one socket
+  static future<void> watch_socket(std::shared_ptr<async_resolver> self,
+                                   std::shared_ptr<socket_watch> w) {
+    arm(*w);
+    while (true) {
+      co_await io_context::wait_completion(w->result);
+      auto res = w->result.res;
+      auto more = (w->result.flag & IORING_CQE_F_MORE) != 0;
+      if (!w->closed) {
+        if (res == -EINVAL && !w->single_shot && !more) {
+          w->single_shot = true; // multishot poll not supported
+          arm(*w);
+          continue;
         }
+        // an error is left to c-ares , its read or write fails
+        auto revents = res < 0 ? POLLERR : static_cast<unsigned>(res);
+        auto rfd = revents & (POLLIN | POLLERR | POLLHUP) ? w->fd
+                                                          : ARES_SOCKET_BAD;
+        auto wfd = revents & (POLLOUT | POLLERR) ? w->fd : ARES_SOCKET_BAD;
+        ares_process_fd(self->m_channel, rfd, wfd);
       }
-    });
-  }
-
-  void try_wakeup() {
-    m_pending_cnt.fetch_add(1, std::memory_order_relaxed);
-    std::atomic_notify_one(&m_pending_cnt);
+      if (more)
+        continue;
+      if (w->closed || res < 0)
+        break; // a failed socket is dropped by c-ares or its timeout
+      arm(*w);
+    }
   }
 
-public:
-  auto submit_query(std::string hostname, std::string service) {
-    return async_query_awaiter{.resolver = *this,
-                               .host = std::move(hostname),
-                               .service = std::move(service),
-                               .ctx = io_context::current_context()};
+  // fires the timeouts of queries in flight , ends when none is left
+  static future<void> run_timeouts(std::shared_ptr<async_resolver> self) {
+    using namespace std::chrono;
+    while (self->m_pending > 0) {
+      auto max = timeval{
+          .tv_sec = 0,
+          .tv_usec = duration_cast<microseconds>(max_timer_wait).count()};
+      auto tv = timeval{};
+      auto *wait = ares_timeout(self->m_channel, &max, &tv);
+      co_await time_delay(seconds{wait->tv_sec} + microseconds{wait->tv_usec});
+      ares_process_fd(self->m_channel, ARES_SOCKET_BAD, ARES_SOCKET_BAD);
+    }
+    self->m_timer_running = false;
   }
 
 private:
-  ares_channel m_channel;
-  std::jthread m_thread;
-  std::mutex m_mut;
-  std::vector<query_info> m_query_list;
-  std::atomic<uint64_t> m_pending_cnt{0};
+  uint64_t m_ctx_id;
+  ares_channel m_channel{};
+  std::map<ares_socket_t, std::shared_ptr<socket_watch>> m_watches{};
+  std::size_t m_pending{};
+  bool m_timer_running{};
+  bool m_destroying{};
 };
 
-auto async_query(std::string hostname, std::string service)
+inline auto async_query(std::string hostname, std::string service,
+                        int family = AF_UNSPEC)
     -> concepts::awaiter_of<std::optional<address_list>> auto {
-  return async_resolver::instance().submit_query(std::move(hostname),
-                                                 std::move(service));
+  return async_resolver::current().submit_query(
+      std::move(hostname), std::move(service), family);
+}
+
+inline future<tcp_sock<ip>>
+happy_eyeballs_connect(const address_list &list,
+                       happy_eyeballs_options opts = {}) {
+  auto addrs = std::vector<ip::address>{};
+  for (auto &v : list)
+    addrs.push_back(v.to_address());
+  return happy_eyeballs_connect(std::move(addrs), opts);
 }
 
 } // namespace coio
@@ -12,6 +12,7 @@ struct url {
   std::string_view host;
   std::string_view path;
   std::string_view query;
+  std::string_view port{}; // empty : default port of proto
 
   enum url_err {
     invalid_proto,
@@ -53,16 +54,24 @@ struct url {
     }
     auto host = url_str.substr(0, pos);
     url_str.remove_prefix(host.size());
+    auto port = ""sv;
+    // host:port , skip ':' inside [ipv6]
+    if (auto colon = host.rfind(':');
+        colon != std::string_view::npos &&
+        host.find(']', colon) == std::string_view::npos) {
+      port = host.substr(colon + 1);
+      host = host.substr(0, colon);
+    }
 
     pos = url_str.find('?');
     if (pos == std::string_view::npos)
-      return url{proto, host, url_str, ""sv};
+      return url{proto, host, url_str, ""sv, port};
 
     auto path = url_str.substr(0, pos);
     url_str.remove_prefix(path.size() + 1);
     auto query = url_str;
 
-    return url{proto, host, path, query};
+    return url{proto, host, path, query, port};
   }
 };
 
@@ -17,6 +17,10 @@
 #include "system_error.hpp"
 #include <liburing.h>
 
+#ifdef COIO_IO_TRACING
+#include "details/io_trace.hpp"
+#endif
+
 namespace coio {
 
 class io_context;
@@ -77,6 +81,9 @@ public:
 
   bool is_in_local_thread() noexcept { return this_thread_context == this; }
 
+  // unique in the process , unlike the address of a destroyed context
+  uint64_t id() const noexcept { return m_id; }
+
   bool is_enable_sqpoll() const noexcept {
     return m_ring.flags & IORING_SETUP_SQPOLL;
   }
@@ -109,7 +116,7 @@ public:
   // it will be executed later.
   template <concepts::task F> void post(F &&f) {
     if (!is_in_local_thread()) {
-      std::lock_guard{m_mutex};
+      std::lock_guard guard{m_mutex};
       m_remote_tasks.emplace_back(std::forward<F>(f));
     } else
       m_local_tasks.emplace_back(std::forward<F>(f));
@@ -119,7 +126,7 @@ public:
   // or run immediately
   template <concepts::task F> void dispatch(F &&f) {
     if (!is_in_local_thread()) {
-      std::lock_guard{m_mutex};
+      std::lock_guard guard{m_mutex};
       m_remote_tasks.emplace_back(std::move(f));
       // m_remote_tasks.emplace_back(std::forward<F>(f));
     } else
@@ -154,6 +161,13 @@ public:
     }
   }
 
+#ifdef COIO_IO_TRACING
+  // per opcode latency histograms of io operations completed on this context
+  const io_trace_stats &trace_stats() const noexcept { return m_trace_stats; }
+
+  void reset_trace_stats() noexcept { m_trace_stats.reset(); }
+#endif
+
   // TODO:execute an coroutine on current context.
 
   //
@@ -165,6 +179,10 @@ public:
     int res;
     int flag;
     std::coroutine_handle<> continuation;
+#ifdef COIO_IO_TRACING
+    uint64_t submit_ns;
+    uint8_t opcode;
+#endif
     constexpr void set_result(int res, int flag) noexcept {
       this->res = res;
       this->flag = flag;
@@ -184,14 +202,15 @@ public:
     [[no_unique_address]] F io_operation;
     [[no_unique_address]] R get_result;
 
-    void await_suspend(std::coroutine_handle<> handle) noexcept(
-        noexcept(io_operation(nullptr))) {
+    void await_suspend(std::coroutine_handle<> handle) {
       auto ctx = io_context::current_context();
-      auto *sqe = ::io_uring_get_sqe(&ctx->m_ring);
-      // TODO:process full sqe uring
-      assert(sqe);
+      auto *sqe = ctx->get_sqe();
       // fill io info into sqe
       (void)io_operation(sqe);
+#ifdef COIO_IO_TRACING
+      opcode = sqe->opcode;
+      submit_ns = details::trace_now_ns();
+#endif
       set_continuation(handle);
       ::io_uring_sqe_set_data(sqe, static_cast<async_result *>(this));
     }
@@ -208,7 +227,75 @@ public:
         .get_result = std::forward<FResult>(fget)};
   }
 
+  // an sqe completing into r without suspending on it , r == nullptr drops
+  // the completion. for multishot operations , whose one sqe completes many
+  // times into the same r (IORING_CQE_F_MORE) , and for cancellations.
+  template <std::invocable<io_uring_sqe *> F>
+  void submit_detached(async_result *r, F &&prep) {
+    auto *sqe = get_sqe();
+    (void)std::forward<F>(prep)(sqe);
+#ifdef COIO_IO_TRACING
+    if (r) {
+      r->opcode = sqe->opcode;
+      r->submit_ns = details::trace_now_ns();
+    }
+#endif
+    ::io_uring_sqe_set_data(sqe, r);
+  }
+
+  // room for n sqes prepared back to back without a submit in between ,
+  // which would cut an IOSQE_IO_LINK chain
+  void reserve_sqes(unsigned n) {
+    while (::io_uring_sq_space_left(&m_ring) < n)
+      submit_pending();
+  }
+
+  // a ring of buffers the kernel picks from when a receive completes
+  // (IORING_REGISTER_PBUF_RING) , group ids are unique in this context.
+  // see provided_buffers
+  io_uring_buf_ring *setup_buf_ring(unsigned entries, uint16_t &group) {
+    int ret{};
+    group = m_next_buf_group++;
+    auto *br = ::io_uring_setup_buf_ring(&m_ring, entries, group, 0, &ret);
+    if (!br)
+      throw make_system_error(-ret);
+    return br;
+  }
+
+  void free_buf_ring(io_uring_buf_ring *br, unsigned entries,
+                     uint16_t group) noexcept {
+    ::io_uring_free_buf_ring(&m_ring, br, entries, group);
+  }
+
+  // suspends until the next completion into r , see submit_detached
+  static auto wait_completion(async_result &r) noexcept {
+    struct awaiter {
+      async_result &r;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) noexcept {
+        r.set_continuation(h);
+      }
+      void await_resume() const noexcept {}
+    };
+    return awaiter{r};
+  }
+
 private:
+  // a full sq is submitted to make room , instead of a null sqe
+  io_uring_sqe *get_sqe() {
+    auto *sqe = ::io_uring_get_sqe(&m_ring);
+    while (!sqe) {
+      submit_pending();
+      sqe = ::io_uring_get_sqe(&m_ring);
+    }
+    return sqe;
+  }
+
+  void submit_pending() {
+    if (auto ret = ::io_uring_submit(&m_ring); ret < 0)
+      throw make_system_error(-ret);
+  }
+
   template <concepts::awaitable A> spawn_task co_spawn_entry_point(A a) {
     // GCC BUG TRACK : https://gcc.gnu.org/bugzilla/show_bug.cgi?id=99575
     // https://godbolt.org/z/anWWjb4j4
@@ -253,12 +340,22 @@ private:
 
     // process IO complete
     cnt += ::io_uring_cq_ready(&m_ring);
-    for_each_cqe([this](io_uring_cqe *cqe) noexcept {
+#ifdef COIO_IO_TRACING
+    auto reap_ns = details::trace_now_ns();
+#endif
+    for_each_cqe([&](io_uring_cqe *cqe) noexcept {
       auto result =
           reinterpret_cast<async_result *>(::io_uring_cqe_get_data(cqe));
       // assert(result);
       if (result) {
         result->set_result(cqe->res, cqe->flags);
+#ifdef COIO_IO_TRACING
+        // record before resume , the awaiter may be destroyed by then.
+        trace(*result, reap_ns);
+        // a multishot op completes again , timed from this completion
+        if (cqe->flags & IORING_CQE_F_MORE)
+          result->submit_ns = reap_ns;
+#endif
         result->resume();
       }
     });
@@ -288,9 +385,14 @@ private:
   }
 
   void nonpoll_submit(std::size_t cnt [[maybe_unused]]) {
+    // tasks posted by the last turn run right away , do not wait for io
+    if (!m_local_tasks.empty()) {
+      ::io_uring_submit(&m_ring);
+      return;
+    }
     static auto _1ms = __kernel_timespec{.tv_sec = 0, .tv_nsec = 1000 * 1000};
     // TODO : use eventfd to notice encounting remote task, instead of timer
-    auto sqe = ::io_uring_get_sqe(&m_ring);
+    auto sqe = get_sqe();
     ::io_uring_prep_timeout(sqe, &_1ms, 0, 0);
     ::io_uring_sqe_set_data(sqe, nullptr);
     ::io_uring_submit_and_wait(&m_ring, 1);
@@ -348,6 +450,18 @@ private:
       return 0;
   }
 
+#ifdef COIO_IO_TRACING
+  void trace(const async_result &result, uint64_t reap_ns) noexcept {
+    auto event = io_trace_event{.submit_ns = result.submit_ns,
+                                .reap_ns = reap_ns,
+                                .resume_ns = details::trace_now_ns(),
+                                .res = result.res,
+                                .op = to_io_op(result.opcode)};
+    m_trace_stats.record(event);
+    details::this_thread_trace_ring().push(event);
+  }
+#endif
+
   template <class F>
     requires std::is_nothrow_invocable_v<F, io_uring_cqe *>
   void for_each_cqe(F &&f) noexcept {
@@ -362,6 +476,7 @@ private:
 
 private:
   io_uring m_ring{};
+  uint16_t m_next_buf_group{};
 
   std::mutex m_mutex;
   task_list m_remote_tasks;
@@ -370,6 +485,11 @@ private:
   task_list m_local_tasks;
   std::atomic<bool> m_is_stopped{false};
   std::thread::id m_thid;
+  inline static std::atomic<uint64_t> next_id{0};
+  const uint64_t m_id{next_id.fetch_add(1, std::memory_order_relaxed)};
+#ifdef COIO_IO_TRACING
+  io_trace_stats m_trace_stats{};
+#endif
 };
 
 } // namespace coio
@@ -0,0 +1,140 @@
+#ifndef COIO_ANCILLARY_DATA_HPP
+#define COIO_ANCILLARY_DATA_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+
+namespace coio {
+
+// control messages of a unix domain socket sendmsg / recvmsg : file
+// descriptors (SCM_RIGHTS) and the credentials of the sender
+// (SCM_CREDENTIALS , the receiver needs set_pass_credentials()).
+//
+//  auto out = ancillary_data{};
+//  out.add_fds(std::array{pipe_fd});
+//  co_await sock.sendmsg(out, coio::to_bytes(msg));
+//
+//  auto in = ancillary_data{};
+//  co_await peer.recvmsg(in, coio::to_bytes(buf));
+//  auto fds = in.take_fds(); // owned by the caller now
+//
+// kept alive until the sendmsg / recvmsg completes. received descriptors
+// which are not taken are closed with it.
+class ancillary_data : non_copyable {
+public:
+  // the descriptors of one message , the kernel closes the ones beyond
+  static constexpr std::size_t max_fds = 16;
+
+  ancillary_data() = default;
+  ~ancillary_data() {
+    for (auto fd : fds())
+      ::close(fd);
+  }
+
+public:
+  // to send , at most max_fds in total
+  void add_fds(std::span<const int> fds) {
+    if (fds.size() > max_fds - m_nfds)
+      throw std::length_error{"too many file descriptors."};
+    auto *cm = append(SCM_RIGHTS, fds.size_bytes());
+    std::memcpy(CMSG_DATA(cm), fds.data(), fds.size_bytes());
+    m_nfds += fds.size();
+  }
+
+  // to send , this process (the kernel checks them)
+  void add_credentials() {
+    auto cred = ucred{.pid = ::getpid(), .uid = ::getuid(), .gid = ::getgid()};
+    auto *cm = append(SCM_CREDENTIALS, sizeof(cred));
+    std::memcpy(CMSG_DATA(cm), &cred, sizeof(cred));
+  }
+
+  // received , still owned by this
+  std::span<const int> fds() const noexcept {
+    return std::span{m_fds}.first(m_received ? m_nfds : 0);
+  }
+
+  // received , owned by the caller from now on
+  std::vector<int> take_fds() {
+    auto out = std::vector<int>(fds().begin(), fds().end());
+    m_nfds = 0;
+    return out;
+  }
+
+  // received , if the sender added them or the receiver passes them
+  std::optional<ucred> credentials() const noexcept { return m_cred; }
+
+public:
+  // for tcp_sock::sendmsg / recvmsg , the kernel writes the control
+  // messages of a recvmsg into the buffer , parsed by received()
+  msghdr make_send_msghdr() noexcept {
+    return {.msg_control = m_used ? m_buf.data() : nullptr,
+            .msg_controllen = m_used};
+  }
+
+  msghdr make_recv_msghdr() noexcept {
+    m_buf.fill(0);
+    m_used = 0;
+    m_nfds = 0;
+    m_cred.reset();
+    m_received = true;
+    return {.msg_control = m_buf.data(), .msg_controllen = m_buf.size()};
+  }
+
+  // after the recvmsg completed , the unused tail of the buffer is still 0
+  void received() noexcept {
+    auto msg = msghdr{.msg_control = m_buf.data(),
+                      .msg_controllen = m_buf.size()};
+    for (auto *cm = CMSG_FIRSTHDR(&msg); cm && cm->cmsg_len;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+      if (cm->cmsg_level != SOL_SOCKET)
+        continue;
+      auto data_len = cm->cmsg_len - CMSG_LEN(0);
+      if (cm->cmsg_type == SCM_RIGHTS) {
+        auto n = std::min(data_len / sizeof(int), max_fds - m_nfds);
+        std::memcpy(m_fds.data() + m_nfds, CMSG_DATA(cm), n * sizeof(int));
+        m_nfds += n;
+      } else if (cm->cmsg_type == SCM_CREDENTIALS &&
+                 data_len >= sizeof(ucred)) {
+        auto cred = ucred{};
+        std::memcpy(&cred, CMSG_DATA(cm), sizeof(cred));
+        m_cred = cred;
+      }
+    }
+  }
+
+private:
+  cmsghdr *append(int type, std::size_t len) {
+    if (m_received)
+      throw std::logic_error{"ancillary data already used to receive."};
+    if (m_used + CMSG_SPACE(len) > m_buf.size())
+      throw std::length_error{"ancillary data buffer is full."};
+    auto *cm = reinterpret_cast<cmsghdr *>(m_buf.data() + m_used);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = type;
+    cm->cmsg_len = CMSG_LEN(len);
+    m_used += CMSG_SPACE(len);
+    return cm;
+  }
+
+private:
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int) * max_fds) +
+                                        CMSG_SPACE(sizeof(ucred))> m_buf{};
+  std::size_t m_used{};
+  std::array<int, max_fds> m_fds{};
+  std::size_t m_nfds{};
+  std::optional<ucred> m_cred{};
+  bool m_received{};
+};
+
+} // namespace coio
+
+#endif
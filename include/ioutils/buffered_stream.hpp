@@ -0,0 +1,254 @@
+#ifndef COIO_BUFFERED_STREAM_HPP
+#define COIO_BUFFERED_STREAM_HPP
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "awaitable.hpp"
+#include "buffer.hpp"
+#include "common/non_copyable.hpp"
+#include "common/string_search.hpp"
+#include "future.hpp"
+#include "io_context.hpp"
+#include "stream_buffer.hpp"
+
+namespace coio {
+
+namespace concepts {
+
+template <class S>
+concept async_read_stream = requires(S &s, std::span<std::byte> b) {
+  { s.recv(b) } -> awaiter_of<std::size_t>;
+};
+
+template <class S>
+concept async_write_stream = requires(S &s, std::span<const std::byte> b) {
+  { s.send(b) } -> awaiter_of<std::size_t>;
+};
+
+} // namespace concepts
+
+// buffered reads over a stream (tcp_sock ...) , the stream is not owned.
+// views returned by read_xxx() point into the buffer and stay valid until
+// the next read_xxx() call.
+template <concepts::async_read_stream Stream>
+class buffered_reader : non_copyable {
+public:
+  static constexpr std::size_t default_max_buffer = 1024 * 1024;
+  static constexpr std::size_t min_read = 4096;
+
+  // a line / message longer than max_buffer throws std::length_error
+  explicit buffered_reader(Stream &stream,
+                           std::size_t max_buffer = default_max_buffer)
+      : m_stream(stream), m_buf(max_buffer) {}
+
+public:
+  // up to and including delim , without delim only on eof
+  future<std::string_view> read_until(std::string_view delim) {
+    release_last();
+    std::size_t from = 0;
+    while (true) {
+      auto data = m_buf.data();
+      if (auto pos = find_delimiter(data, delim, from);
+          pos != std::string_view::npos)
+        co_return take(pos + delim.size());
+      // only bytes that could start a match are searched again
+      from = data.size() >= delim.size() ? data.size() - delim.size() + 1 : 0;
+      if (co_await fill(0) == 0)
+        co_return take(m_buf.size());
+    }
+  }
+
+  // without "\n" or "\r\n"
+  future<std::string_view> read_line() {
+    auto line = co_await read_until("\n");
+    if (line.ends_with('\n'))
+      line.remove_suffix(1);
+    if (line.ends_with('\r'))
+      line.remove_suffix(1);
+    co_return line;
+  }
+
+  // exactly n bytes , shorter only on eof
+  future<std::string_view> read_exact(std::size_t n) {
+    release_last();
+    while (m_buf.size() < n)
+      if (co_await fill(n - m_buf.size()) == 0)
+        break;
+    co_return take(std::min(n, m_buf.size()));
+  }
+
+  // buffered bytes , or one recv if there is none. empty on eof
+  future<std::string_view> read_some(std::size_t max) {
+    release_last();
+    if (m_buf.size() == 0)
+      co_await fill(0);
+    co_return take(std::min(max, m_buf.size()));
+  }
+
+  // bytes received but not returned by a read yet
+  std::size_t buffered() const noexcept { return m_buf.size() - m_taken; }
+
+  // give the last n bytes of the previous read back , the next read starts
+  // with them. e.g. bytes past the end of a message
+  void put_back(std::size_t n) noexcept { m_taken -= std::min(n, m_taken); }
+
+  // drop everything buffered , e.g. before reusing the stream
+  void reset() noexcept {
+    m_taken = 0;
+    m_buf.consume(m_buf.size());
+  }
+
+  Stream &stream() noexcept { return m_stream; }
+
+private:
+  // one recv , returns 0 on eof
+  auto fill(std::size_t hint) {
+    auto avail = m_buf.available();
+    if (avail == 0)
+      throw std::length_error{"buffered_reader exceeds max buffer."};
+    struct awaiter {
+      decltype(std::declval<Stream &>().recv(std::span<std::byte>{})) recv;
+      stream_buffer &buf;
+      bool await_ready() { return recv.await_ready(); }
+      auto await_suspend(std::coroutine_handle<> h) {
+        return recv.await_suspend(h);
+      }
+      std::size_t await_resume() {
+        auto n = recv.await_resume();
+        buf.commit(n);
+        return n;
+      }
+    };
+    auto n = std::min(std::max(hint, min_read), avail);
+    return awaiter{m_stream.recv(m_buf.prepare(n)), m_buf};
+  }
+
+  std::string_view take(std::size_t n) noexcept {
+    m_taken = n;
+    return m_buf.data().substr(0, n);
+  }
+
+  void release_last() noexcept { m_buf.consume(std::exchange(m_taken, 0)); }
+
+private:
+  Stream &m_stream;
+  stream_buffer m_buf;
+  std::size_t m_taken{}; // returned by the last read , consumed lazily
+};
+
+// coalescing writes over a stream , the stream is not owned.
+// write() only copies into the pending batch , the batch goes out as one
+// send at the end of the current loop turn (a posted task runs after all
+// completions of run_once) , or at once when it grows over the threshold.
+// while a send is in flight , new writes gather into the next batch.
+//
+// co_await flush() before destroying the writer.
+template <concepts::async_write_stream Stream>
+class buffered_writer : non_copyable {
+public:
+  static constexpr std::size_t default_flush_threshold = 64 * 1024;
+
+  explicit buffered_writer(
+      Stream &stream, std::size_t flush_threshold = default_flush_threshold)
+      : m_stream(stream), m_flush_threshold(flush_threshold) {}
+
+  ~buffered_writer() { assert(m_state == state::idle); }
+
+public:
+  template <concepts::buffer... T> void write(T &&...buff) {
+    (append(buff.data(), buff.size()), ...);
+    schedule();
+  }
+
+  void write(std::string_view s) {
+    append(s.data(), s.size());
+    schedule();
+  }
+
+  // wait until every written byte is handed to the kernel ,
+  // rethrows the error of a failed background send.
+  future<void> flush() {
+    start();
+    if (m_state == state::running)
+      co_await wait_idle{this};
+    if (m_error)
+      std::rethrow_exception(std::exchange(m_error, nullptr));
+  }
+
+  // bytes not sent yet
+  std::size_t pending() const noexcept {
+    return m_pending.size() + m_inflight.size();
+  }
+
+private:
+  enum class state { idle, scheduled, running };
+
+  struct wait_idle {
+    buffered_writer *self;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+      self->m_waiters.push_back(h);
+    }
+    void await_resume() const noexcept {}
+  };
+
+  void append(const void *p, std::size_t n) {
+    m_pending.append(static_cast<const char *>(p), n);
+  }
+
+  void schedule() {
+    if (m_state == state::idle && !m_pending.empty()) {
+      m_state = state::scheduled;
+      io_context::current_context()->post([this] { start(); });
+    }
+    if (m_pending.size() >= m_flush_threshold)
+      start();
+  }
+
+  void start() {
+    if (m_state != state::scheduled)
+      return;
+    m_state = state::running;
+    io_context::current_context()->co_spawn(send_loop());
+  }
+
+  future<void> send_loop() {
+    try {
+      while (!m_pending.empty()) {
+        std::swap(m_pending, m_inflight); // keeps both capacities
+        auto bytes = std::as_bytes(std::span{m_inflight});
+        for (std::size_t sent = 0; sent < bytes.size();)
+          sent += co_await m_stream.send(bytes.subspan(sent));
+        m_inflight.clear();
+      }
+    } catch (...) {
+      m_error = std::current_exception();
+      m_pending.clear();
+      m_inflight.clear();
+    }
+    m_state = state::idle;
+    // a waiter may destroy the writer , do not touch this afterwards
+    auto waiters = std::move(m_waiters);
+    for (auto h : waiters)
+      h.resume();
+  }
+
+private:
+  Stream &m_stream;
+  std::size_t m_flush_threshold;
+  std::string m_pending{};
+  std::string m_inflight{};
+  state m_state{state::idle};
+  std::vector<std::coroutine_handle<>> m_waiters{};
+  std::exception_ptr m_error{};
+};
+
+} // namespace coio
+
+#endif
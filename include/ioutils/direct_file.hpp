@@ -0,0 +1,91 @@
+#ifndef COIO_DIRECT_FILE_HPP
+#define COIO_DIRECT_FILE_HPP
+
+#include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "file.hpp"
+#include "future.hpp"
+
+namespace coio {
+
+// a file opened with O_DIRECT , the page cache bypassed. the buffer address ,
+// the offset and the length of every read / write must be multiples of the
+// alignment the file system reports (statx STATX_DIOALIGN) , checked before
+// anything is submitted instead of an EINVAL from the kernel. buffers from an
+// aligned_buffer_pool fit.
+//
+//  auto f = co_await direct_file::openat(path, O_RDONLY);
+//  auto pool = aligned_buffer_pool{64 * 1024, f.offset_alignment()};
+//  auto buf = pool.acquire();
+//  auto n = co_await f.read(buf, 0);
+class direct_file {
+public:
+  // the alignment where the file system does not report it
+  static constexpr std::size_t default_alignment = 4096;
+
+  // (path , flag , mode_t) -> future<direct_file> , O_DIRECT is added
+  static future<direct_file> openat(const char *path, int flag,
+                                    mode_t mode = mode_t{}) {
+    auto f = co_await file::openat(path, flag | O_DIRECT, mode);
+    auto stx = statx_t{};
+    auto mem = default_alignment, off = default_alignment;
+    // the file opened , not whatever the path names by now
+    auto fd = f.native_handle();
+    if (::statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+        (stx.stx_mask & STATX_DIOALIGN) && stx.stx_dio_offset_align != 0) {
+      mem = stx.stx_dio_mem_align;
+      off = stx.stx_dio_offset_align;
+    }
+    co_return direct_file{std::move(f), mem, off};
+  }
+
+public:
+  // buffer addresses are multiples of it
+  std::size_t memory_alignment() const noexcept { return m_mem_align; }
+  // offsets and lengths are multiples of it , the logical block size
+  std::size_t offset_alignment() const noexcept { return m_off_align; }
+
+  // the file underneath , for what needs no alignment
+  coio::file &base() noexcept { return m_file; }
+
+  // throws std::invalid_argument when misaligned , see file::read()
+  template <concepts::writeable_buffer T>
+  auto read(T &&buff, off_t off) -> awaiter_of<std::size_t> auto {
+    check(buff.data(), buff.size(), off);
+    return m_file.read(std::forward<T>(buff), off);
+  }
+
+  // throws std::invalid_argument when misaligned , see file::write()
+  template <concepts::buffer T>
+  auto write(T &&buff, off_t off) -> awaiter_of<std::size_t> auto {
+    check(buff.data(), buff.size(), off);
+    return m_file.write(std::forward<T>(buff), off);
+  }
+
+private:
+  using statx_t = struct ::statx;
+
+  direct_file(coio::file f, std::size_t mem, std::size_t off) noexcept
+      : m_file(std::move(f)), m_mem_align(mem), m_off_align(off) {}
+
+  void check(const void *data, std::size_t len, off_t off) const {
+    if (reinterpret_cast<std::uintptr_t>(data) % m_mem_align != 0)
+      throw std::invalid_argument{"misaligned direct io buffer."};
+    if (off < 0 || static_cast<std::size_t>(off) % m_off_align != 0)
+      throw std::invalid_argument{"misaligned direct io offset."};
+    if (len % m_off_align != 0)
+      throw std::invalid_argument{"misaligned direct io length."};
+  }
+
+private:
+  coio::file m_file;
+  std::size_t m_mem_align;
+  std::size_t m_off_align;
+};
+
+} // namespace coio
+
+#endif
@@ -16,6 +16,8 @@ private:
   explicit file(int fd) noexcept : file_descriptor_base(fd) {}
 
 public:
+  using file_descriptor_base::native_handle;
+
   // open a file
   //(path , flag , mode_t) -> awaitable <file>
   static auto openat(const char *path, int flag, mode_t mode = mode_t{})
@@ -70,6 +72,22 @@ public:
         });
   }
 
+  template <concepts::writeable_buffer_sequence S>
+  auto readv(off_t off, S &&buffs) -> awaiter_of<std::size_t> auto {
+    auto ctx = io_context::current_context();
+    return ctx->submit_io_task(
+        [iovecs = make_iovecs(buffs), this, off](io_uring_sqe *sqe) {
+          ::io_uring_prep_readv(sqe, this->fd, iovecs.data(), iovecs.size(),
+                                off);
+        },
+        [](int res, int flag [[maybe_unused]]) -> std::size_t {
+          if (res < 0)
+            throw make_system_error(-res);
+          else
+            return res;
+        });
+  }
+
   // write
   // buffer -> off_t -> awaitable<size_t>
   // return : count of write bytes
@@ -104,6 +122,28 @@ public:
         });
   }
 
+  template <concepts::buffer_sequence S>
+  auto writev(off_t off, S &&buffs) -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [iovecs = make_iovecs(buffs), this, off](io_uring_sqe *sqe) {
+          ::io_uring_prep_writev(sqe, this->fd, iovecs.data(), iovecs.size(),
+                                 off);
+        },
+        [](int res, int flag [[maybe_unused]]) -> std::size_t {
+          if (res < 0)
+            throw make_system_error(-res);
+          else
+            return res;
+        });
+  }
+
+  // moves up to len bytes at off into the write end of a pipe , without
+  // copying them to user space. see file_descriptor_base::splice()
+  auto splice_to(file_descriptor_base &pipe_in, std::size_t len, off_t off)
+      -> awaiter_of<std::size_t> auto {
+    return file_descriptor_base::splice(*this, pipe_in, len, off);
+  }
+
 private:
 };
 
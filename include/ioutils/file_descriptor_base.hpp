@@ -62,6 +62,36 @@ public:
 
   int native_handle() { return fd; }
 
+public:
+  // moves up to len bytes from one descriptor to another inside the kernel ,
+  // one of them a pipe. off_from / off_to : the offset in a file , -1 for
+  // a pipe , a socket or the current file position.
+  // return : bytes moved , 0 at the end of from
+  static auto splice(file_descriptor_base &from, file_descriptor_base &to,
+                     std::size_t len, int64_t off_from = -1,
+                     int64_t off_to = -1) -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [&, len, off_from, off_to](io_uring_sqe *sqe) {
+          ::io_uring_prep_splice(sqe, from.fd, off_from, to.fd, off_to, len,
+                                 SPLICE_F_MOVE);
+        },
+        [](int res, int flag [[maybe_unused]]) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
+  // copies up to len bytes from one pipe to another , leaving them in from
+  static auto tee(file_descriptor_base &from, file_descriptor_base &to,
+                  std::size_t len) -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [&, len](io_uring_sqe *sqe) {
+          ::io_uring_prep_tee(sqe, from.fd, to.fd, len, 0);
+        },
+        [](int res, int flag [[maybe_unused]]) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
 protected:
   int fd{-1};
 };
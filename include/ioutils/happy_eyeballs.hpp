@@ -0,0 +1,203 @@
+#ifndef COIO_HAPPY_EYEBALLS_HPP
+#define COIO_HAPPY_EYEBALLS_HPP
+
+#include <chrono>
+#include <climits>
+#include <coroutine>
+#include <span>
+#include <vector>
+
+#include "future.hpp"
+#include "io_context.hpp"
+#include "protocol.hpp"
+#include "tcp.hpp"
+#include "time_delay.hpp"
+
+namespace coio {
+
+struct happy_eyeballs_options {
+  // the next address is tried once the last attempt neither connected nor
+  // failed for this long , rfc 8305 recommends 250 ms
+  std::chrono::milliseconds attempt_delay{250};
+};
+
+namespace details {
+
+// the race of happy_eyeballs_connect() , every sqe it submits completes into
+// one of its results and resumes the racing coroutine , which returns only
+// after the last one completed.
+class happy_eyeballs {
+  using clock = std::chrono::steady_clock;
+
+  // the res of an sqe until it completes
+  static constexpr int in_flight = INT_MIN;
+
+  struct attempt {
+    ip::address addr;
+    int fd{-1};
+    bool done{};
+    io_context::async_result result{.res = in_flight};
+  };
+
+  // resumes on the next completion into any of them
+  struct next_completion {
+    std::span<attempt> attempts;
+    io_context::async_result &timer;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+      for (auto &a : attempts)
+        a.result.set_continuation(h);
+      timer.set_continuation(h);
+    }
+    void await_resume() const noexcept {}
+  };
+
+public:
+  static future<tcp_sock<ip>> connect(std::vector<ip::address> addrs,
+                                      happy_eyeballs_options opts) {
+    auto attempts = interleave(addrs);
+    auto *ctx = io_context::current_context();
+    auto started = std::size_t{};
+    auto running = std::size_t{};
+    auto *winner = static_cast<attempt *>(nullptr);
+    auto error = EHOSTUNREACH;
+    auto last_start = clock::now();
+
+    auto timer = io_context::async_result{.res = in_flight};
+    auto timer_armed = false;
+    auto spec = __kernel_timespec{};
+    auto arm_timer = [&](clock::duration d) {
+      spec = to_kernel_timespec(d);
+      timer.res = in_flight;
+      timer_armed = true;
+      ctx->submit_detached(&timer, [&](io_uring_sqe *sqe) {
+        ::io_uring_prep_timeout(sqe, &spec, 0, 0);
+      });
+    };
+
+    // the next address that gets a socket , if any left
+    auto start_next = [&] {
+      while (started < attempts.size()) {
+        auto &a = attempts[started++];
+        a.fd = ::socket(a.addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (a.fd < 0) {
+          error = errno; // no ipv6 on this host ...
+          a.done = true;
+          continue;
+        }
+        ++running;
+        last_start = clock::now();
+        ctx->submit_detached(&a.result, [&a](io_uring_sqe *sqe) {
+          ::io_uring_prep_connect(sqe, a.fd, a.addr.ptr(), a.addr.len());
+        });
+        return;
+      }
+    };
+
+    start_next();
+    if (started < attempts.size())
+      arm_timer(opts.attempt_delay);
+    while (!winner && running > 0) {
+      co_await next_completion{attempts, timer};
+      for (auto &a : std::span{attempts}.first(started)) {
+        if (a.done || a.result.res == in_flight)
+          continue;
+        a.done = true;
+        --running;
+        if (a.result.res == 0) {
+          winner = &a;
+          break;
+        }
+        error = -a.result.res;
+        ::close(std::exchange(a.fd, -1));
+        // a failure does not wait for the timer
+        start_next();
+      }
+      if (!winner && timer_armed && timer.res != in_flight) {
+        timer_armed = false;
+        if (clock::now() - last_start >= opts.attempt_delay)
+          start_next();
+        if (started < attempts.size())
+          arm_timer(opts.attempt_delay - (clock::now() - last_start));
+      }
+    }
+
+    // cancel the losers , and wait for them
+    auto cancel = [&](io_context::async_result &r) {
+      ctx->submit_detached(nullptr, [&r](io_uring_sqe *sqe) {
+        ::io_uring_prep_cancel(sqe, &r, 0);
+      });
+    };
+    for (auto &a : std::span{attempts}.first(started))
+      if (!a.done && a.result.res == in_flight)
+        cancel(a.result);
+    if (timer_armed && timer.res == in_flight)
+      cancel(timer);
+    while (true) {
+      for (auto &a : std::span{attempts}.first(started)) {
+        if (!a.done && a.result.res != in_flight) {
+          a.done = true;
+          --running;
+          ::close(std::exchange(a.fd, -1));
+        }
+      }
+      if (timer_armed && timer.res != in_flight)
+        timer_armed = false;
+      if (running == 0 && !timer_armed)
+        break;
+      co_await next_completion{attempts, timer};
+    }
+
+    if (!winner)
+      throw make_system_error(error);
+    co_return tcp_sock<ip>{std::exchange(winner->fd, -1)};
+  }
+
+private:
+  // alternating families , the family of the first address first
+  static std::vector<attempt> interleave(std::span<const ip::address> addrs) {
+    auto out = std::vector<attempt>{};
+    out.reserve(addrs.size());
+    if (addrs.empty())
+      return out;
+    auto first = addrs.front().family();
+    auto next_of = [&](auto it, bool first_family) {
+      while (it != addrs.end() && (it->family() == first) != first_family)
+        ++it;
+      return it;
+    };
+    auto same = next_of(addrs.begin(), true);
+    auto other = next_of(addrs.begin(), false);
+    while (same != addrs.end() || other != addrs.end()) {
+      if (same != addrs.end()) {
+        out.push_back({.addr = *same});
+        same = next_of(same + 1, true);
+      }
+      if (other != addrs.end()) {
+        out.push_back({.addr = *other});
+        other = next_of(other + 1, false);
+      }
+    }
+    return out;
+  }
+};
+
+} // namespace details
+
+// connects to whichever of addrs answers first (happy eyeballs , rfc 8305).
+// attempts start attempt_delay apart , or as soon as the previous one
+// failed , alternating address families , and run concurrently. the losers
+// are cancelled. throws the error of the last failed attempt.
+//
+//  auto addrs = co_await dns_cache::current().lookup("example.com" , "http");
+//  auto sock = co_await happy_eyeballs_connect(*addrs);
+inline future<tcp_sock<ip>>
+happy_eyeballs_connect(std::vector<ip::address> addrs,
+                       happy_eyeballs_options opts = {}) {
+  return details::happy_eyeballs::connect(std::move(addrs), opts);
+}
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef COIO_PIPE_HPP
+#define COIO_PIPE_HPP
+
+#include <array>
+#include <fcntl.h>
+#include <memory>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+#include "file_descriptor_base.hpp"
+#include "io_context.hpp"
+#include "system_error.hpp"
+
+namespace coio {
+
+// the kernel buffer in the middle of a splice , see
+// file_descriptor_base::splice()
+class pipe {
+public:
+  pipe() : pipe(make_fds()) {}
+
+public:
+  file_descriptor_base &read_end() noexcept { return m_read; }
+  file_descriptor_base &write_end() noexcept { return m_write; }
+
+  // bytes it holds before a splice into it waits , 64 KiB by default
+  std::size_t capacity() {
+    int size = ::fcntl(m_write.native_handle(), F_GETPIPE_SZ);
+    if (size < 0)
+      throw make_system_error(errno);
+    return size;
+  }
+
+  // rounded up to pages , limited by /proc/sys/fs/pipe-max-size
+  void set_capacity(std::size_t size) {
+    auto fd = m_write.native_handle();
+    if (::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(size)) < 0)
+      throw make_system_error(errno);
+  }
+
+  // bytes written , not read yet
+  std::size_t size() {
+    int n{};
+    if (::ioctl(m_read.native_handle(), FIONREAD, &n) != 0)
+      throw make_system_error(errno);
+    return n;
+  }
+
+private:
+  explicit pipe(std::array<int, 2> fds) noexcept
+      : m_read(fds[0]), m_write(fds[1]) {}
+
+  static std::array<int, 2> make_fds() {
+    auto fds = std::array<int, 2>{};
+    if (::pipe2(fds.data(), O_CLOEXEC) != 0)
+      throw make_system_error(errno);
+    return fds;
+  }
+
+private:
+  file_descriptor_base m_read;
+  file_descriptor_base m_write;
+};
+
+// idle pipes of the current context , reused by splice transfers instead of a
+// pipe2() and two close() each. a pipe comes back only if it was drained.
+//
+//  auto p = pipe_pool::current().acquire();
+//  co_await file_descriptor_base::splice(sock , p->write_end() , len);
+//  ...
+//  // p goes back to the pool
+class pipe_pool : non_copyable {
+public:
+  // at most max_idle pipes are kept
+  explicit pipe_pool(std::size_t max_idle = 64) : m_max_idle(max_idle) {}
+
+  // the pool of the current context , created on first use
+  static pipe_pool &current() {
+    thread_local std::unique_ptr<pipe_pool> pool{};
+    thread_local uint64_t ctx_id{};
+    auto id = io_context::current_context()->id();
+    if (!pool || ctx_id != id) {
+      pool = std::make_unique<pipe_pool>();
+      ctx_id = id;
+    }
+    return *pool;
+  }
+
+  // a pipe back in the pool when destroyed
+  class handle : non_copyable {
+  public:
+    handle(pipe_pool &pool, pipe p) noexcept
+        : m_pool(&pool), m_pipe(std::move(p)) {}
+    handle(handle &&other) noexcept
+        : m_pool(std::exchange(other.m_pool, nullptr)),
+          m_pipe(std::move(other.m_pipe)) {}
+    ~handle() {
+      if (m_pool)
+        m_pool->release(std::move(m_pipe));
+    }
+
+    pipe &operator*() noexcept { return m_pipe; }
+    pipe *operator->() noexcept { return &m_pipe; }
+
+  private:
+    pipe_pool *m_pool;
+    pipe m_pipe;
+  };
+
+public:
+  handle acquire() {
+    if (m_idle.empty())
+      return handle{*this, pipe{}};
+    auto p = std::move(m_idle.back());
+    m_idle.pop_back();
+    return handle{*this, std::move(p)};
+  }
+
+  std::size_t idle() const noexcept { return m_idle.size(); }
+
+private:
+  // a pipe still holding bytes of an interrupted transfer is closed
+  void release(pipe p) noexcept {
+    try {
+      if (m_idle.size() < m_max_idle && p.size() == 0)
+        m_idle.push_back(std::move(p));
+    } catch (...) {
+    }
+  }
+
+private:
+  std::size_t m_max_idle;
+  std::vector<pipe> m_idle{};
+};
+
+} // namespace coio
+
+#endif
@@ -1,7 +1,12 @@
 #ifndef COIO_NET_PROTOCOL_HPP
 #define COIO_NET_PROTOCOL_HPP
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
 #include <sys/un.h>
 
 #include "endian.hpp"
@@ -35,6 +40,10 @@ struct udp_type {
   constexpr auto type() const { return SOCK_DGRAM; }
 };
 
+struct seqpacket_type {
+  constexpr auto type() const { return SOCK_SEQPACKET; }
+};
+
 // network to host
 
 // host to network
@@ -126,6 +135,12 @@ struct ipv6 {
       return std::string{buf}.append(":") +
              std::to_string(net_to_host(addr.sin6_port));
     }
+
+    static constexpr auto from_raw_address(const sockaddr_in6 &addr) {
+      address a{};
+      a.addr = addr;
+      return a;
+    }
   };
 
   struct tcp : ip_domain, details::tcp_type {
@@ -138,28 +153,130 @@ struct ipv6 {
 
 }; // namespace ipv6
 
+// ipv4 or ipv6 , known at run time : the answers of a dual stack lookup.
+// sockets of this domain open as ipv4 , happy_eyeballs_connect() opens them
+// by the family of the address.
+struct ip {
+
+  struct ip_domain {
+    constexpr auto domain() const { return AF_INET; }
+  };
+
+  struct address {
+    union {
+      sockaddr_in v4;
+      sockaddr_in6 v6;
+    } addr{};
+
+    explicit address() noexcept = default;
+    explicit address(const ipv4::address &a) noexcept { addr.v4 = a.addr; }
+    explicit address(const ipv6::address &a) noexcept { addr.v6 = a.addr; }
+
+    // AF_INET , AF_INET6 , or AF_UNSPEC if default constructed
+    constexpr sa_family_t family() const noexcept { return addr.v4.sin_family; }
+    constexpr bool is_v4() const noexcept { return family() == AF_INET; }
+    constexpr bool is_v6() const noexcept { return family() == AF_INET6; }
+
+    sockaddr *ptr() { return reinterpret_cast<sockaddr *>(&addr); }
+    const sockaddr *ptr() const {
+      return reinterpret_cast<const sockaddr *>(&addr);
+    }
+    // large enough for either when unspecified (getpeername ...)
+    constexpr socklen_t len() const {
+      return is_v4() ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+    }
+
+    bool operator==(const address &other) const noexcept {
+      if (family() != other.family())
+        return false;
+      if (is_v4())
+        return ipv4::address::from_raw_address(addr.v4) ==
+               ipv4::address::from_raw_address(other.addr.v4);
+      return std::memcmp(&addr, &other.addr, sizeof(addr)) == 0;
+    }
+
+    std::string to_string() const {
+      return is_v4() ? ipv4::address::from_raw_address(addr.v4).to_string()
+                     : ipv6::address::from_raw_address(addr.v6).to_string();
+    }
+  };
+
+  struct tcp : ip_domain, details::tcp_type {
+    using address_type = address;
+  };
+
+  struct udp : ip_domain, details::udp_type {
+    using address_type = address;
+  };
+
+}; // namespace ip
+
 struct iplocal {
 
   struct ip_domain {
     constexpr auto domain() const { return AF_LOCAL; }
   };
 
+  // a path , or a name in the abstract namespace (no file , gone with the
+  // last socket bound to it)
   struct address {
-    sockaddr_un addr{.sun_family = AF_LOCAL}; // TODO : too large on stack
+    // only the first len() bytes , the family and the name , are passed
+    // to the kernel
+    sockaddr_un addr{.sun_family = AF_LOCAL};
+    socklen_t size{sizeof(sockaddr_un)};
+
     explicit address() noexcept = default;
     explicit address(const char *path) noexcept {
-      strncpy(addr.sun_path, path, sizeof(addr.sun_path));
+      auto n = ::strnlen(path, sizeof(addr.sun_path));
+      std::memcpy(addr.sun_path, path, n);
+      // the nul , unless the path fills sun_path
+      size = std::min(offsetof(sockaddr_un, sun_path) + n + 1,
+                      sizeof(sockaddr_un));
+    }
+
+    // at most sizeof(sun_path) - 2 bytes , to_string() shows it as "@name"
+    static address abstract(std::string_view name) noexcept {
+      auto a = address{};
+      name = name.substr(0, sizeof(a.addr.sun_path) - 2);
+      std::memcpy(a.addr.sun_path + 1, name.data(), name.size());
+      a.size = offsetof(sockaddr_un, sun_path) + 1 + name.size();
+      return a;
     }
+
     sockaddr *ptr() { return reinterpret_cast<sockaddr *>(&addr); }
     const sockaddr *ptr() const {
       return reinterpret_cast<const sockaddr *>(&addr);
     }
-    constexpr socklen_t len() const { return sizeof(sockaddr_in); }
+    // the family and the name , large enough for any name when unspecified
+    // (recvfrom , getpeername ...)
+    socklen_t len() const { return size; }
+    // the length the kernel filled in (getpeername , accept ...)
+    void resize(socklen_t n) noexcept {
+      size = std::min<socklen_t>(n, sizeof(sockaddr_un));
+    }
 
-    constexpr bool operator==(const address &other) const noexcept {
-      return strcmp(addr.sun_path, other.addr.sun_path) == 0;
+    bool is_abstract() const noexcept {
+      return addr.sun_path[0] == '\0' &&
+             size > offsetof(sockaddr_un, sun_path) + 1 &&
+             size < sizeof(sockaddr_un);
+    }
+
+    // the path , or the abstract name without its leading nul
+    std::string_view name() const noexcept {
+      if (is_abstract())
+        return {addr.sun_path + 1,
+                size - offsetof(sockaddr_un, sun_path) - 1};
+      // sun_path may fill the whole array without a nul
+      return {addr.sun_path, ::strnlen(addr.sun_path, sizeof(addr.sun_path))};
+    }
+
+    bool operator==(const address &other) const noexcept {
+      return is_abstract() == other.is_abstract() && name() == other.name();
+    }
+    std::string to_string() const {
+      return is_abstract() ? std::string{"@"}.append(name())
+                           : std::string{name()};
     }
-    std::string to_string() const { return std::string{addr.sun_path}; }
   };
 
   struct tcp : ip_domain, details::tcp_type {
@@ -170,6 +287,15 @@ struct iplocal {
     using address_type = address;
   };
 
+  // SOCK_SEQPACKET : connected like a stream , keeps message boundaries like
+  // datagrams. a domain of its own for the connection oriented sockets :
+  // acceptor<iplocal::seqpacket> , connector<iplocal::seqpacket> ...
+  struct seqpacket {
+    struct tcp : ip_domain, details::seqpacket_type {
+      using address_type = address;
+    };
+  };
+
 }; // namespace iplocal
 
 } // namespace coio
@@ -0,0 +1,76 @@
+#ifndef COIO_PROVIDED_BUFFERS_HPP
+#define COIO_PROVIDED_BUFFERS_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+#include "common/non_copyable.hpp"
+#include "io_context.hpp"
+
+namespace coio {
+
+// count buffers of size bytes , handed to the kernel as a buffer ring of the
+// current context : a receive submitted with IOSQE_BUFFER_SELECT on group()
+// picks one when it completes , and the buffer belongs to the receiver until
+// it is recycled. shared by the multishot receives using it , which may
+// complete after their stream is gone.
+//
+//  auto pool = std::make_shared<provided_buffers>(256 , 2048);
+//  auto datagrams = sock.recvmsg_multishot(pool);
+//
+// destroyed on the thread of its context , before the context.
+class provided_buffers : non_copyable {
+public:
+  // count : a power of 2 , at most 32768
+  provided_buffers(uint16_t count, uint32_t size)
+      : m_ctx(io_context::current_context()), m_count(count), m_size(size),
+        m_mask(count - 1u), m_memory(new std::byte[std::size_t{count} * size]) {
+    if (!std::has_single_bit(count) || count > 32768)
+      throw std::invalid_argument{"buffer count must be a power of 2."};
+    m_ring = m_ctx->setup_buf_ring(count, m_group);
+    for (uint16_t bid = 0; bid < count; ++bid)
+      ::io_uring_buf_ring_add(m_ring, buffer(bid).data(), m_size, bid, m_mask,
+                              bid);
+    ::io_uring_buf_ring_advance(m_ring, count);
+  }
+
+  ~provided_buffers() { m_ctx->free_buf_ring(m_ring, m_count, m_group); }
+
+public:
+  uint16_t group() const noexcept { return m_group; }
+  uint16_t count() const noexcept { return m_count; }
+  uint32_t buffer_size() const noexcept { return m_size; }
+
+  // the buffer a completion picked , IORING_CQE_F_BUFFER in its flags
+  static uint16_t buffer_id(uint32_t cqe_flags) noexcept {
+    return static_cast<uint16_t>(cqe_flags >> IORING_CQE_BUFFER_SHIFT);
+  }
+
+  std::span<std::byte> buffer(uint16_t bid) noexcept {
+    return {m_memory.get() + std::size_t{bid} * m_size, m_size};
+  }
+
+  // hands the buffer back to the kernel
+  void recycle(uint16_t bid) noexcept {
+    ::io_uring_buf_ring_add(m_ring, buffer(bid).data(), m_size, bid, m_mask,
+                            0);
+    ::io_uring_buf_ring_advance(m_ring, 1);
+  }
+
+private:
+  io_context *m_ctx;
+  uint16_t m_count;
+  uint32_t m_size;
+  int m_mask;
+  std::unique_ptr<std::byte[]> m_memory;
+  io_uring_buf_ring *m_ring{};
+  uint16_t m_group{};
+};
+
+} // namespace coio
+
+#endif
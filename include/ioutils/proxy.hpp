@@ -0,0 +1,74 @@
+#ifndef COIO_PROXY_HPP
+#define COIO_PROXY_HPP
+
+#include <exception>
+#include <sys/socket.h>
+
+#include "future.hpp"
+#include "pipe.hpp"
+#include "tcp.hpp"
+#include "when_all.hpp"
+
+namespace coio {
+
+struct proxy_result {
+  std::size_t a_to_b;
+  std::size_t b_to_a;
+};
+
+namespace details {
+
+// from -> pipe -> to until from ends , then half closes to. an error shuts
+// both down , which ends the other direction too.
+template <class From, class To>
+future<std::size_t> splice_forward(From &from, To &to,
+                                   std::exception_ptr &error) {
+  auto total = std::size_t{};
+  try {
+    auto p = pipe_pool::current().acquire();
+    auto chunk = p->capacity();
+    while (true) {
+      auto n = co_await file_descriptor_base::splice(from, p->write_end(),
+                                                     chunk);
+      if (n == 0)
+        break;
+      for (std::size_t moved = 0; moved < n;)
+        moved += co_await file_descriptor_base::splice(p->read_end(), to,
+                                                       n - moved);
+      total += n;
+    }
+    ::shutdown(to.native_handle(), SHUT_WR);
+  } catch (...) {
+    if (!error)
+      error = std::current_exception();
+    ::shutdown(from.native_handle(), SHUT_RDWR);
+    ::shutdown(to.native_handle(), SHUT_RDWR);
+  }
+  co_return total;
+}
+
+} // namespace details
+
+// forwards both directions between a and b with splice through pooled
+// pipes , the bytes never reach user space. a direction ends at the end of
+// its source and half closes its destination , returns once both ended.
+// an error ends both and is thrown.
+//
+//  auto client = co_await front.accept();
+//  auto backend = connector{};
+//  co_await backend.connect(addr);
+//  auto [up , down] = co_await proxy(client , backend.socket());
+template <class A, class B>
+future<proxy_result> proxy(tcp_sock<A> &a, tcp_sock<B> &b) {
+  auto error = std::exception_ptr{};
+  auto both = when_all(details::splice_forward(a, b, error),
+                       details::splice_forward(b, a, error));
+  auto [a_to_b, b_to_a] = co_await std::move(both);
+  if (error)
+    std::rethrow_exception(error);
+  co_return proxy_result{a_to_b, b_to_a};
+}
+
+} // namespace coio
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef COIO_SEND_FILE_HPP
+#define COIO_SEND_FILE_HPP
+
+#include <cerrno>
+#include <sys/types.h>
+#include <system_error>
+#include <vector>
+
+#include "file.hpp"
+#include "future.hpp"
+#include "pipe.hpp"
+#include "tcp.hpp"
+
+namespace coio {
+
+struct send_file_options {
+  // file -> pipe -> socket , the bytes never reach user space. false , or a
+  // file which can not be spliced , reads into a buffer and sends it with
+  // send_zc() (a plain send() where the socket has no zero copy).
+  bool splice = true;
+  // the buffer of the read path
+  std::size_t buffer_size = 64 * 1024;
+};
+
+namespace details {
+
+inline bool is_unsupported(const std::system_error &e) noexcept {
+  auto err = e.code().value();
+  return err == EINVAL || err == EOPNOTSUPP || err == ENOSYS;
+}
+
+template <class Domain>
+future<std::size_t> send_file_spliced(tcp_sock<Domain> &sock, file &f,
+                                      off_t offset, std::size_t len,
+                                      bool &unsupported) {
+  auto p = pipe_pool::current().acquire();
+  auto chunk = p->capacity();
+  auto sent = std::size_t{};
+  while (sent < len) {
+    auto n = std::size_t{};
+    try {
+      n = co_await f.splice_to(p->write_end(), std::min(chunk, len - sent),
+                               offset + sent);
+    } catch (const std::system_error &e) {
+      if (sent != 0 || !is_unsupported(e))
+        throw;
+      unsupported = true;
+    }
+    if (unsupported || n == 0)
+      break;
+    for (std::size_t moved = 0; moved < n;)
+      moved += co_await file_descriptor_base::splice(p->read_end(), sock,
+                                                     n - moved);
+    sent += n;
+  }
+  co_return sent;
+}
+
+template <class Domain>
+future<std::size_t> send_file_buffered(tcp_sock<Domain> &sock, file &f,
+                                       off_t offset, std::size_t len,
+                                       std::size_t buffer_size) {
+  auto buff = std::vector<std::byte>(std::min(buffer_size, len));
+  auto sent = std::size_t{};
+  auto zero_copy = true;
+  while (sent < len) {
+    auto n = co_await f.read(
+        std::span{buff.data(), std::min(buff.size(), len - sent)},
+        offset + sent);
+    if (n == 0)
+      break;
+    for (std::size_t out = 0; out < n;) {
+      auto rest = std::span<const std::byte>{buff.data() + out, n - out};
+      if (!zero_copy) {
+        out += co_await sock.send(rest);
+        continue;
+      }
+      try {
+        out += co_await sock.send_zc(rest);
+      } catch (const std::system_error &e) {
+        if (!is_unsupported(e))
+          throw;
+        zero_copy = false;
+      }
+    }
+    sent += n;
+  }
+  co_return sent;
+}
+
+} // namespace details
+
+// sends len bytes of f from offset over sock , the sendfile() of io_uring.
+// returns the bytes sent , less than len if the file ends before.
+//
+//  auto f = co_await file::openat(path, O_RDONLY);
+//  auto n = co_await send_file(sock, f, 0, size);
+template <class Domain>
+future<std::size_t> send_file(tcp_sock<Domain> &sock, file &f, off_t offset,
+                              std::size_t len, send_file_options opt = {}) {
+  auto unsupported = !opt.splice;
+  auto sent = std::size_t{};
+  if (opt.splice)
+    sent = co_await details::send_file_spliced(sock, f, offset, len,
+                                               unsupported);
+  if (unsupported)
+    sent = co_await details::send_file_buffered(sock, f, offset, len,
+                                                opt.buffer_size);
+  co_return sent;
+}
+
+} // namespace coio
+
+#endif
@@ -2,7 +2,9 @@
 #define COIO_SOCKET_BASE_HPP
 
 #include <arpa/inet.h>
+#include <linux/filter.h>
 #include <liburing.h>
+#include <stdexcept>
 #include <string_view>
 
 #include "buffer.hpp"
@@ -55,6 +57,39 @@ public:
       throw make_system_error(errno);
   }
 
+  // steer incoming connections of a SO_REUSEPORT group by the cpu handling
+  // the packet : socket index = (cpu - cpu_base) mod group_size , so with
+  // thread i pinned to cpu_base + i , cpu_base + i reaches socket i .
+  // index is the bind order in the group , attach on any one of them.
+  void set_reuse_port_cpu_steering(uint32_t group_size, uint32_t cpu_base = 0) {
+    if (group_size == 0)
+      throw std::invalid_argument{"empty reuse port group."};
+    // cpu + group_size - cpu_base % group_size , never below 0
+    auto shift = group_size - cpu_base % group_size;
+    sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+         static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_ADD | BPF_K, 0, 0, shift},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, group_size},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    sock_fprog prog{.len = std::size(code), .filter = code};
+    int ret = ::setsockopt(file_descriptor_base::fd, SOL_SOCKET,
+                           SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+    if (ret != 0)
+      throw make_system_error(errno);
+  }
+
+  // unix domain sockets : receive the credentials of the sender with every
+  // message (SCM_CREDENTIALS) , see ancillary_data
+  void set_pass_credentials() {
+    int pass = 1;
+    int ret = ::setsockopt(file_descriptor_base::fd, SOL_SOCKET, SO_PASSCRED,
+                           &pass, sizeof(int));
+    if (ret != 0)
+      throw make_system_error(errno);
+  }
+
   void bind(address_t addr) {
     if (::bind(fd, addr.ptr(), addr.len()) != 0)
       throw make_system_error(errno);
@@ -65,14 +100,15 @@ public:
 
 protected:
   // recvmsg
-  template <class F, concepts::writeable_buffer... T>
+  // iovecs : array or inline_iovecs from make_iovecs() , kept in the awaiter
+  template <class F, class Iovecs>
     requires requires(F f) {
       { f() } -> std::same_as<msghdr>;
     }
-  auto recvmsg_impl(F &&make_msghdr, T &&...buff)
+  auto recvmsg_impl(F &&make_msghdr, Iovecs iovecs)
       -> awaiter_of<std::size_t> auto {
     return io_context::current_context()->submit_io_task(
-        [iovecs = make_iovecs(std::forward<T>(buff)...), msg = make_msghdr(),
+        [iovecs = std::move(iovecs), msg = make_msghdr(),
          this](io_uring_sqe *sqe) mutable {
           msg.msg_iov = iovecs.data();
           msg.msg_iovlen = iovecs.size();
@@ -87,14 +123,14 @@ protected:
   }
 
   // sendmsg
-  template <class F, concepts::buffer... T>
+  template <class F, class Iovecs>
     requires requires(F f) {
       { f() } -> std::same_as<msghdr>;
     }
-  auto sendmsg_impl(F &&make_msghdr, T &&...buff)
+  auto sendmsg_impl(F &&make_msghdr, Iovecs iovecs)
       -> awaiter_of<std::size_t> auto {
     return io_context::current_context()->submit_io_task(
-        [iovecs = make_iovecs(std::forward<T>(buff)...), msg = make_msghdr(),
+        [iovecs = std::move(iovecs), msg = make_msghdr(),
          this](io_uring_sqe *sqe) mutable {
           msg.msg_iov = iovecs.data();
           msg.msg_iovlen = iovecs.size();
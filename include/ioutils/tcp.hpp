@@ -1,35 +1,50 @@
 #ifndef COIO_TCP_HPP
 #define COIO_TCP_HPP
 
+#include "ancillary_data.hpp"
+#include "future.hpp"
 #include "socket_base.hpp"
+#include <deque>
+#include <memory>
 #include <netinet/tcp.h>
 
 namespace coio {
 
 namespace details {
-static constexpr inline msghdr default_maker(iovec *iov_ptr,
-                                             std::size_t iov_len) {
-  return {};
-}
+static constexpr inline msghdr default_maker() { return {}; }
+class happy_eyeballs;
 } // namespace details
 
 template <class Domain>
   requires concepts::protocal<typename Domain::tcp>
 class acceptor;
 
+template <class Domain>
+  requires concepts::protocal<typename Domain::tcp>
+class accept_stream;
+
 template <class Domain = ipv4>
   requires concepts::protocal<typename Domain::tcp>
 class tcp_sock : public socket_base<typename Domain::tcp> {
 public:
   using address_t = Domain::tcp::address_type;
 
+  // a unix domain socket , stream or seqpacket
+  static constexpr bool is_local =
+      typename Domain::tcp{}.domain() == AF_LOCAL;
+
 public:
   tcp_sock() = default;
   tcp_sock(tcp_sock &&) noexcept = default;
   tcp_sock &operator=(tcp_sock &&) noexcept = default;
 
+  // no socket (fd -1) , until a connected one is assigned
+  static tcp_sock invalid() noexcept { return tcp_sock{-1}; }
+
 protected:
   friend class acceptor<Domain>;
+  friend class accept_stream<Domain>;
+  friend class details::happy_eyeballs;
   explicit tcp_sock(int fd, address_t addr = address_t{}) noexcept
       : socket_base<typename Domain::tcp>(fd, addr) {}
 
@@ -39,6 +54,8 @@ public:
     socklen_t len = addr.len();
     if (::getpeername(this->fd, addr.ptr(), &len) != 0)
       throw make_system_error(errno);
+    if constexpr (requires { addr.resize(len); })
+      addr.resize(len); // unix domain names are as long as the kernel says
     return addr;
   }
 
@@ -81,14 +98,88 @@ public:
         });
   }
 
+  // zero copy send (IORING_OP_SEND_ZC , linux 6.0) : the pages of buff go
+  // to the nic without a copy , and are pinned until the kernel notifies it
+  // let go of them , which is when this completes. costs more than a copy
+  // for small buffers , loopback copies anyway.
+  future<std::size_t> send_zc(std::span<const std::byte> buff) {
+    auto r = io_context::async_result{};
+    io_context::current_context()->submit_detached(
+        &r, [&](io_uring_sqe *sqe) {
+          ::io_uring_prep_send_zc(sqe, this->fd, buff.data(), buff.size(),
+                                  MSG_NOSIGNAL, 0);
+        });
+    auto res = 0;
+    while (true) {
+      co_await io_context::wait_completion(r);
+      if (r.flag & IORING_CQE_F_NOTIF)
+        break;
+      res = r.res;
+      // no notification after a failure
+      if (!(r.flag & IORING_CQE_F_MORE))
+        break;
+    }
+    if (res < 0)
+      throw make_system_error(-res);
+    co_return res;
+  }
+
   template <concepts::writeable_buffer... T>
   auto recvmsg(T &&...buff) -> awaiter_of<std::size_t> auto {
-    return recvmsg_impl(details::default_maker, std::forward<T>(buff)...);
+    return this->recvmsg_impl(details::default_maker, make_iovecs(buff...));
+  }
+
+  template <concepts::writeable_buffer_sequence S>
+  auto recvmsg(S &&buffs) -> awaiter_of<std::size_t> auto {
+    return this->recvmsg_impl(details::default_maker, make_iovecs(buffs));
   }
 
   template <concepts::buffer... T>
   auto sendmsg(T &&...buff) -> awaiter_of<std::size_t> auto {
-    return sendmsg_impl(details::default_maker, std::forward<T>(buff)...);
+    return this->sendmsg_impl(details::default_maker, make_iovecs(buff...));
+  }
+
+  template <concepts::buffer_sequence S>
+  auto sendmsg(S &&buffs) -> awaiter_of<std::size_t> auto {
+    return this->sendmsg_impl(details::default_maker, make_iovecs(buffs));
+  }
+
+  // with control messages , see ancillary_data
+  template <concepts::buffer... T>
+    requires is_local
+  auto sendmsg(ancillary_data &control, T &&...buff)
+      -> awaiter_of<std::size_t> auto {
+    return this->sendmsg_impl([&] { return control.make_send_msghdr(); },
+                              make_iovecs(buff...));
+  }
+
+  template <concepts::writeable_buffer... T>
+    requires is_local
+  auto recvmsg(ancillary_data &control, T &&...buff)
+      -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [iovecs = make_iovecs(buff...), msg = control.make_recv_msghdr(),
+         this](io_uring_sqe *sqe) mutable {
+          msg.msg_iov = iovecs.data();
+          msg.msg_iovlen = iovecs.size();
+          ::io_uring_prep_recvmsg(sqe, this->fd, &msg, MSG_CMSG_CLOEXEC);
+        },
+        [&control](int res, int flag) -> std::size_t {
+          control.received();
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
+  // the process which connected (SO_PEERCRED) , no set_pass_credentials()
+  // needed
+  ucred get_peer_credentials() const
+    requires is_local
+  {
+    auto cred = ucred{};
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(this->fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+      throw make_system_error(errno);
+    return cred;
   }
 
   enum close_how : int {
@@ -146,6 +237,128 @@ public:
           return tcp_socket_t{res};
         });
   }
+
+  // one multishot accept keeps accepting , see accept_stream.
+  // the acceptor must outlive the stream.
+  auto accept_multishot() { return accept_stream<Domain>{this->fd}; }
+};
+
+// sockets accepted by one multishot accept submission , queued until taken.
+// falls back to an accept per socket on kernels without multishot accept.
+//
+//  auto accepts = acceptor.accept_multishot();
+//  while (true) {
+//    tcp_sock sock = co_await accepts.next();
+//    ...
+//  }
+//
+// accepting stops after an error , next() throws it once and rearms.
+template <class Domain>
+  requires concepts::protocal<typename Domain::tcp>
+class accept_stream : non_copyable {
+  using tcp_socket_t = tcp_sock<Domain>;
+
+  // shared with the pump , the kernel writes completions into result
+  // until the last one (without IORING_CQE_F_MORE) is reaped
+  struct state {
+    int listen_fd;
+    io_context::async_result result{};
+    std::deque<int> ready{}; // fd , or -errno
+    std::coroutine_handle<> waiter{};
+    bool running{};
+    bool single_shot{};
+    bool abandoned{};
+  };
+
+public:
+  explicit accept_stream(int listen_fd)
+      : m_state(std::make_shared<state>(listen_fd)) {}
+
+  accept_stream(accept_stream &&) noexcept = default;
+
+  ~accept_stream() {
+    if (!m_state)
+      return;
+    m_state->abandoned = true;
+    for (auto fd : m_state->ready)
+      if (fd >= 0)
+        ::close(fd);
+    m_state->ready.clear();
+    if (m_state->running)
+      io_context::current_context()->submit_detached(
+          nullptr, [&r = m_state->result](io_uring_sqe *sqe) {
+            ::io_uring_prep_cancel(sqe, &r, 0);
+          });
+  }
+
+public:
+  auto next() {
+    if (!m_state->running && m_state->ready.empty()) {
+      m_state->running = true;
+      io_context::current_context()->co_spawn(pump(m_state));
+    }
+
+    struct awaiter {
+      state &st;
+      bool await_ready() const noexcept { return !st.ready.empty(); }
+      void await_suspend(std::coroutine_handle<> h) noexcept { st.waiter = h; }
+      tcp_socket_t await_resume() {
+        auto res = st.ready.front();
+        st.ready.pop_front();
+        if (res < 0)
+          throw make_system_error(-res);
+        return tcp_socket_t{res};
+      }
+    };
+    return awaiter{*m_state};
+  }
+
+private:
+  static void arm(state &st) {
+    io_context::current_context()->submit_detached(
+        &st.result, [&st](io_uring_sqe *sqe) {
+          if (st.single_shot)
+            ::io_uring_prep_accept(sqe, st.listen_fd, nullptr, nullptr, 0);
+          else
+            ::io_uring_prep_multishot_accept(sqe, st.listen_fd, nullptr,
+                                             nullptr, 0);
+        });
+  }
+
+  // the continuation of every accept completion , never suspends elsewhere
+  static future<void> pump(std::shared_ptr<state> st) {
+    arm(*st);
+    while (true) {
+      co_await io_context::wait_completion(st->result);
+      auto res = st->result.res;
+      auto more = (st->result.flag & IORING_CQE_F_MORE) != 0;
+      if (st->abandoned) {
+        if (res >= 0)
+          ::close(res);
+        if (more)
+          continue;
+        break;
+      }
+
+      if (res == -EINVAL && !st->single_shot && !more) {
+        st->single_shot = true; // not supported by this kernel
+        arm(*st);
+        continue;
+      }
+      st->ready.push_back(res);
+      if (auto h = std::exchange(st->waiter, nullptr))
+        io_context::current_context()->post([h] { h.resume(); });
+      if (more)
+        continue;
+      if (res < 0)
+        break;
+      arm(*st); // multishot ended , or single shot
+    }
+    st->running = false;
+  }
+
+private:
+  std::shared_ptr<state> m_state;
 };
 
 // connector
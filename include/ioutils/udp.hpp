@@ -1,10 +1,23 @@
 #ifndef COIO_UDP_HPP
 #define COIO_UDP_HPP
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <netinet/udp.h>
+#include <utility>
+
+#include "future.hpp"
+#include "provided_buffers.hpp"
 #include "socket_base.hpp"
 
 namespace coio {
 
+template <class Domain>
+  requires concepts::protocal<typename Domain::udp>
+class datagram_stream;
+
 template <class Domain = ipv4>
   requires concepts::protocal<typename Domain::udp>
 class udp_sock : public socket_base<typename Domain::udp> {
@@ -16,17 +29,141 @@ public:
 public:
   template <concepts::writeable_buffer T>
   auto recvfrom(address_t &addr, T &&buff) -> awaiter_of<std::size_t> auto {
-    return this->recvmsg_impl(get_udp_msghdr_maker(addr),
-                              std::forward<T>(buff));
+    if constexpr (requires { addr.resize(socklen_t{}); })
+      return recvfrom_resized(addr, make_iovecs(buff));
+    else
+      return this->recvmsg_impl(get_udp_msghdr_maker(addr),
+                                make_iovecs(buff));
   }
 
   template <concepts::buffer T>
-  auto sendto(address_t &addr, T &&buff) -> awaiter_of<std::size_t> auto {
-    return this->sendmsg_impl(get_udp_msghdr_maker(addr),
-                              std::forward<T>(buff));
+  auto sendto(const address_t &addr, T &&buff)
+      -> awaiter_of<std::size_t> auto {
+    return this->sendmsg_impl(get_udp_msghdr_maker(addr), make_iovecs(buff));
+  }
+
+public:
+  // connected udp : the peer is fixed , send() and recv() skip the msghdr
+  // and the per datagram route lookup , recv() only sees datagrams from it
+  void connect(const address_t &peer) {
+    if (::connect(this->fd, peer.ptr(), peer.len()) != 0)
+      throw make_system_error(errno);
+  }
+
+  address_t get_peer_address() const {
+    address_t addr{};
+    socklen_t len = addr.len();
+    if (::getpeername(this->fd, addr.ptr(), &len) != 0)
+      throw make_system_error(errno);
+    if constexpr (requires { addr.resize(len); })
+      addr.resize(len); // unix domain names are as long as the kernel says
+    return addr;
+  }
+
+  template <concepts::writeable_buffer T>
+  auto recv(T &&buff) -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [ptr = buff.data(), len = buff.size(), this](io_uring_sqe *sqe) {
+          ::io_uring_prep_recv(sqe, this->fd, ptr, len, 0);
+        },
+        [](int res, int flag) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
+  template <concepts::buffer T>
+  auto send(T &&buff) -> awaiter_of<std::size_t> auto {
+    return io_context::current_context()->submit_io_task(
+        [ptr = buff.data(), len = buff.size(), this](io_uring_sqe *sqe) {
+          ::io_uring_prep_send(sqe, this->fd, ptr, len, 0);
+        },
+        [](int res, int flag) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
+public:
+  // one sendmsg for many datagrams (UDP_SEGMENT , gso) : the kernel splits
+  // buff into datagrams of segment_size bytes , the last one may be
+  // shorter. at most 64 segments , each one fitting the path mtu.
+  template <concepts::buffer T>
+  auto sendto_segmented(const address_t &addr, T &&buff,
+                        uint16_t segment_size)
+      -> awaiter_of<std::size_t> auto {
+    struct control_t {
+      alignas(cmsghdr) char buf[CMSG_SPACE(sizeof(uint16_t))];
+    };
+    return io_context::current_context()->submit_io_task(
+        [iov = iovec{const_cast<void *>(
+                         static_cast<const void *>(std::data(buff))),
+                     std::size(buff)},
+         msg = get_udp_msghdr_maker(addr)(), control = control_t{},
+         segment_size, this](io_uring_sqe *sqe) mutable {
+          msg.msg_iov = &iov;
+          msg.msg_iovlen = 1;
+          msg.msg_control = control.buf;
+          msg.msg_controllen = sizeof(control.buf);
+          auto *cm = CMSG_FIRSTHDR(&msg);
+          cm->cmsg_level = SOL_UDP;
+          cm->cmsg_type = UDP_SEGMENT;
+          cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+          std::memcpy(CMSG_DATA(cm), &segment_size, sizeof(uint16_t));
+          ::io_uring_prep_sendmsg(sqe, this->fd, &msg, 0);
+        },
+        [](int res, int flag) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+  }
+
+  // datagrams of one flow may be coalesced on receive (UDP_GRO) , see
+  // udp_datagram::segment_size()
+  void set_gro(bool enable = true) {
+    int on = enable;
+    if (::setsockopt(this->fd, SOL_UDP, UDP_GRO, &on, sizeof(on)) != 0)
+      throw make_system_error(errno);
+  }
+
+  // one multishot recvmsg keeps receiving into buffers of pool , see
+  // datagram_stream. the socket must outlive the stream.
+  auto recvmsg_multishot(std::shared_ptr<provided_buffers> pool) {
+    return datagram_stream<Domain>{this->fd, std::move(pool)};
   }
 
 private:
+  // a unix domain name is as long as the kernel says , the msghdr it writes
+  // msg_namelen into is kept in the awaiter
+  template <class Iovecs>
+  auto recvfrom_resized(address_t &addr, Iovecs iovecs) {
+    struct operation {
+      Iovecs iovecs;
+      msghdr msg;
+      int fd;
+      void operator()(io_uring_sqe *sqe) noexcept {
+        msg.msg_iov = iovecs.data();
+        msg.msg_iovlen = iovecs.size();
+        ::io_uring_prep_recvmsg(sqe, fd, &msg, 0);
+      }
+    };
+    addr = address_t{}; // room for any name
+    auto recv = io_context::current_context()->submit_io_task(
+        operation{std::move(iovecs), get_udp_msghdr_maker(addr)(), this->fd},
+        [](int res, int flag) -> std::size_t {
+          return res < 0 ? throw make_system_error(-res) : res;
+        });
+    struct awaiter {
+      decltype(recv) io;
+      address_t &addr;
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) { io.await_suspend(h); }
+      std::size_t await_resume() {
+        auto n = io.await_resume();
+        addr.resize(io.io_operation.msg.msg_namelen);
+        return n;
+      }
+    };
+    return awaiter{std::move(recv), addr};
+  }
+
   static constexpr auto get_udp_msghdr_maker(address_t &addr) {
     return [&] {
       return msghdr{
@@ -35,8 +172,225 @@ private:
       };
     };
   }
+
+  // for sendmsg , which only reads msg_name
+  static constexpr auto get_udp_msghdr_maker(const address_t &addr) {
+    return [&] {
+      return msghdr{
+          .msg_name = const_cast<sockaddr *>(addr.ptr()),
+          .msg_namelen = addr.len(),
+      };
+    };
+  }
+};
+
+// a datagram received into a provided buffer , the buffer is recycled when
+// it is destroyed. it must not outlive its pool.
+template <class Domain = ipv4>
+  requires concepts::protocal<typename Domain::udp>
+class udp_datagram : non_copyable {
+  using address_t = Domain::udp::address_type;
+
+public:
+  udp_datagram(provided_buffers &pool, uint16_t bid, const msghdr &msg,
+               std::size_t len) noexcept
+      : m_pool(&pool), m_bid(bid) {
+    auto hdr = msg;
+    auto *out =
+        ::io_uring_recvmsg_validate(pool.buffer(bid).data(), len, &hdr);
+    if (!out)
+      return;
+    auto namelen = std::min(out->namelen, hdr.msg_namelen);
+    std::memcpy(m_peer.ptr(), ::io_uring_recvmsg_name(out), namelen);
+    if constexpr (requires { m_peer.resize(namelen); })
+      m_peer.resize(namelen);
+    m_payload = {
+        static_cast<const std::byte *>(::io_uring_recvmsg_payload(out, &hdr)),
+        ::io_uring_recvmsg_payload_length(out, len, &hdr)};
+    m_truncated = out->flags & MSG_TRUNC;
+    for (auto *cm = ::io_uring_recvmsg_cmsg_firsthdr(out, &hdr); cm;
+         cm = ::io_uring_recvmsg_cmsg_nexthdr(out, &hdr, cm)) {
+      if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+        int size{};
+        std::memcpy(&size, CMSG_DATA(cm), sizeof(size));
+        m_segment_size = size;
+      }
+    }
+  }
+
+  udp_datagram(udp_datagram &&other) noexcept
+      : m_pool(std::exchange(other.m_pool, nullptr)), m_bid(other.m_bid),
+        m_peer(other.m_peer), m_payload(other.m_payload),
+        m_segment_size(other.m_segment_size), m_truncated(other.m_truncated) {
+  }
+
+  ~udp_datagram() {
+    if (m_pool)
+      m_pool->recycle(m_bid);
+  }
+
+public:
+  const address_t &peer() const noexcept { return m_peer; }
+
+  // every segment , coalesced
+  std::span<const std::byte> payload() const noexcept { return m_payload; }
+
+  // cut to the buffer size
+  bool truncated() const noexcept { return m_truncated; }
+
+  // the size of each coalesced datagram (UDP_GRO) , the last one may be
+  // shorter. 0 if not coalesced
+  std::size_t segment_size() const noexcept { return m_segment_size; }
+
+  std::size_t segment_count() const noexcept {
+    if (m_segment_size == 0)
+      return 1;
+    return (m_payload.size() + m_segment_size - 1) / m_segment_size;
+  }
+
+  std::span<const std::byte> segment(std::size_t i) const noexcept {
+    if (m_segment_size == 0)
+      return m_payload;
+    return m_payload.subspan(i * m_segment_size).first(std::min(
+        m_segment_size, m_payload.size() - i * m_segment_size));
+  }
+
+private:
+  provided_buffers *m_pool;
+  uint16_t m_bid;
+  address_t m_peer{};
+  std::span<const std::byte> m_payload{};
+  std::size_t m_segment_size{};
+  bool m_truncated{};
+};
+
+// datagrams received by one multishot recvmsg submission , each into a
+// buffer of the pool , queued until taken. needs linux 6.0.
+//
+//  auto pool = std::make_shared<provided_buffers>(256 , 2048);
+//  auto datagrams = sock.recvmsg_multishot(pool);
+//  while (true) {
+//    auto d = co_await datagrams.next();
+//    ... d.peer() , d.payload()
+//  } // the buffer of d is recycled
+//
+// receiving stops while every buffer is taken , and resumes on the next
+// next() once the queue is drained. next() throws an error once and rearms.
+template <class Domain>
+  requires concepts::protocal<typename Domain::udp>
+class datagram_stream : non_copyable {
+  using address_t = Domain::udp::address_type;
+  using datagram_t = udp_datagram<Domain>;
+
+  // room for the UDP_GRO segment size
+  static constexpr std::size_t control_size = CMSG_SPACE(sizeof(int));
+
+  // shared with the pump , the kernel writes completions into result
+  // until the last one (without IORING_CQE_F_MORE) is reaped
+  struct state {
+    int fd;
+    std::shared_ptr<provided_buffers> pool;
+    msghdr msg{.msg_namelen = address_t{}.len(),
+               .msg_controllen = control_size};
+    io_context::async_result result{};
+    std::deque<std::pair<int, uint32_t>> ready{}; // res , cqe flags
+    std::coroutine_handle<> waiter{};
+    bool running{};
+    bool abandoned{};
+  };
+
+public:
+  datagram_stream(int fd, std::shared_ptr<provided_buffers> pool)
+      : m_state(std::make_shared<state>(fd, std::move(pool))) {}
+
+  datagram_stream(datagram_stream &&) noexcept = default;
+
+  ~datagram_stream() {
+    if (!m_state)
+      return;
+    m_state->abandoned = true;
+    for (auto [res, flags] : m_state->ready)
+      if (flags & IORING_CQE_F_BUFFER)
+        m_state->pool->recycle(provided_buffers::buffer_id(flags));
+    m_state->ready.clear();
+    if (m_state->running)
+      io_context::current_context()->submit_detached(
+          nullptr, [&r = m_state->result](io_uring_sqe *sqe) {
+            ::io_uring_prep_cancel(sqe, &r, 0);
+          });
+  }
+
+public:
+  auto next() {
+    if (!m_state->running && m_state->ready.empty()) {
+      m_state->running = true;
+      io_context::current_context()->co_spawn(pump(m_state));
+    }
+
+    struct awaiter {
+      state &st;
+      bool await_ready() const noexcept { return !st.ready.empty(); }
+      void await_suspend(std::coroutine_handle<> h) noexcept { st.waiter = h; }
+      datagram_t await_resume() {
+        auto [res, flags] = st.ready.front();
+        st.ready.pop_front();
+        if (res < 0)
+          throw make_system_error(-res);
+        return datagram_t{*st.pool, provided_buffers::buffer_id(flags), st.msg,
+                          static_cast<std::size_t>(res)};
+      }
+    };
+    return awaiter{*m_state};
+  }
+
+  // received , not taken yet
+  std::size_t queued() const noexcept { return m_state->ready.size(); }
+
+private:
+  static void arm(state &st) {
+    io_context::current_context()->submit_detached(
+        &st.result, [&st](io_uring_sqe *sqe) {
+          ::io_uring_prep_recvmsg_multishot(sqe, st.fd, &st.msg, 0);
+          sqe->flags |= IOSQE_BUFFER_SELECT;
+          sqe->buf_group = st.pool->group();
+        });
+  }
+
+  // the continuation of every receive completion , never suspends elsewhere
+  static future<void> pump(std::shared_ptr<state> st) {
+    arm(*st);
+    while (true) {
+      co_await io_context::wait_completion(st->result);
+      auto res = st->result.res;
+      auto flags = static_cast<uint32_t>(st->result.flag);
+      auto more = (flags & IORING_CQE_F_MORE) != 0;
+      if (st->abandoned) {
+        if (flags & IORING_CQE_F_BUFFER)
+          st->pool->recycle(provided_buffers::buffer_id(flags));
+        if (more)
+          continue;
+        break;
+      }
+
+      // every buffer is taken , next() rearms once they are back
+      if (res == -ENOBUFS && !st->ready.empty())
+        break;
+      st->ready.emplace_back(res, flags);
+      if (auto h = std::exchange(st->waiter, nullptr))
+        io_context::current_context()->post([h] { h.resume(); });
+      if (more)
+        continue;
+      if (res < 0)
+        break;
+      arm(*st); // ended by the kernel
+    }
+    st->running = false;
+  }
+
+private:
+  std::shared_ptr<state> m_state;
 };
 
 } // namespace coio
 
-#endif
\ No newline at end of file
+#endif
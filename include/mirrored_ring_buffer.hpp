@@ -0,0 +1,123 @@
+#ifndef COIO_MIRRORED_RING_BUFFER_HPP
+#define COIO_MIRRORED_RING_BUFFER_HPP
+
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+#include "buffer.hpp"
+#include "common/non_copyable.hpp"
+#include "system_error.hpp"
+
+namespace coio {
+
+// ring buffer whose memory is mapped twice back to back :
+//  [ memfd pages | same memfd pages ]
+// so both the readable and the writeable region are always contiguous ,
+// recv into the tail and parse from the head never wrap nor memmove.
+//
+//  auto n = co_await sock.recv(ring.prepare(ring.available()));
+//  ring.commit(n);
+//  parse(ring.data()) ... ring.consume(used);
+class mirrored_ring_buffer : non_copyable {
+public:
+  // capacity is rounded up to whole pages
+  explicit mirrored_ring_buffer(std::size_t capacity = 64 * 1024) {
+    auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    m_capacity = (std::max<std::size_t>(capacity, 1) + page - 1) / page * page;
+
+    int fd = ::memfd_create("coio_ring_buffer", MFD_CLOEXEC);
+    if (fd < 0)
+      throw make_system_error(errno);
+    // the mappings keep the memory alive , fd is not needed afterwards
+    auto err = map_twice(fd);
+    ::close(fd);
+    if (err != 0)
+      throw make_system_error(err);
+  }
+
+  mirrored_ring_buffer(mirrored_ring_buffer &&other) noexcept
+      : m_base(std::exchange(other.m_base, nullptr)),
+        m_capacity(std::exchange(other.m_capacity, 0)),
+        m_head(std::exchange(other.m_head, 0)),
+        m_size(std::exchange(other.m_size, 0)) {}
+
+  mirrored_ring_buffer &operator=(mirrored_ring_buffer &&other) noexcept {
+    std::swap(m_base, other.m_base);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_head, other.m_head);
+    std::swap(m_size, other.m_size);
+    return *this;
+  }
+
+  ~mirrored_ring_buffer() {
+    if (m_base)
+      ::munmap(m_base, m_capacity * 2);
+  }
+
+public:
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+  std::size_t capacity() const noexcept { return m_capacity; }
+  // bytes that can still be prepared , 0 : backpressure
+  std::size_t available() const noexcept { return m_capacity - m_size; }
+
+  // readable bytes , contiguous even across the wrap point
+  std::string_view data() const noexcept {
+    return {reinterpret_cast<const char *>(m_base + m_head), m_size};
+  }
+
+  [[nodiscard]] auto prepare(std::size_t n) -> concepts::writeable_buffer auto {
+    if (n > available())
+      throw std::length_error{"mirrored_ring_buffer is full."};
+    return std::span{m_base + m_head + m_size, n};
+  }
+
+  void commit(std::size_t n) noexcept { m_size += std::min(n, available()); }
+
+  void consume(std::size_t n) noexcept {
+    n = std::min(n, m_size);
+    m_size -= n;
+    m_head += n;
+    if (m_head >= m_capacity)
+      m_head -= m_capacity;
+    if (m_size == 0)
+      m_head = 0; // keep small reads away from the wrap point
+  }
+
+private:
+  int map_twice(int fd) noexcept {
+    if (::ftruncate(fd, m_capacity) != 0)
+      return errno;
+    // reserve address space for both views , then overlay them
+    auto *base = ::mmap(nullptr, m_capacity * 2, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+      return errno;
+    m_base = static_cast<std::byte *>(base);
+    for (auto *view : {m_base, m_base + m_capacity}) {
+      if (::mmap(view, m_capacity, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        auto err = errno;
+        ::munmap(m_base, m_capacity * 2);
+        m_base = nullptr;
+        return err;
+      }
+    }
+    return 0;
+  }
+
+private:
+  std::byte *m_base{};
+  std::size_t m_capacity{};
+  std::size_t m_head{}; // offset of the first readable byte , < capacity
+  std::size_t m_size{};
+};
+
+} // namespace coio
+
+#endif
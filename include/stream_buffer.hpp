@@ -2,24 +2,59 @@
 #define COIO_STREAMBUF_HPP
 
 #include "buffer.hpp"
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
 #include <streambuf>
+#include <string_view>
 #include <vector>
 
 namespace coio {
 
+// memory policy :
+//  compaction : unread bytes are moved to the front when the put area is
+//               short but the consumed prefix can hold the request , the
+//               buffer only grows (x2) when unread + n does not fit.
+//  max_capacity : unread + prepared bytes never exceed it , prepare() throws
+//                 std::length_error beyond. available() == 0 tells the
+//                 producer to stop reading until the consumer catches up.
+//  shrink() : give memory back down to a low water mark , for idle
+//             keep-alive connections.
 class stream_buffer : public std::streambuf {
+public:
+  static constexpr std::size_t initial_capacity = 128;
+  static constexpr std::size_t default_low_water_mark = 4096;
 
 public:
-  explicit stream_buffer() : m_buf(128) {
+  explicit stream_buffer(
+      std::size_t max_capacity = std::numeric_limits<std::size_t>::max())
+      : m_buf(std::min(initial_capacity, max_capacity)),
+        m_max_capacity(max_capacity) {
     auto p = m_buf.data();
     setp(p, p + m_buf.size());
     setg(p, p, p);
   }
 
   stream_buffer(stream_buffer &&) noexcept = default;
-  stream_buffer(const stream_buffer &) = default;
   stream_buffer &operator=(stream_buffer &&) noexcept = default;
-  stream_buffer &operator=(const stream_buffer &) = default;
+
+  // streambuf pointers must point into our own copy
+  stream_buffer(const stream_buffer &other)
+      : std::streambuf(other), m_buf(other.m_buf),
+        m_max_capacity(other.m_max_capacity) {
+    auto base = m_buf.data();
+    auto old = other.m_buf.data();
+    setg(base + (other.eback() - old), base + (other.gptr() - old),
+         base + (other.egptr() - old));
+    setp(base + (other.pbase() - old), base + (other.epptr() - old));
+    pbump(static_cast<int>(other.pptr() - other.pbase()));
+  }
+  stream_buffer &operator=(const stream_buffer &other) {
+    if (this != &other)
+      *this = stream_buffer{other};
+    return *this;
+  }
 
   // streambuf structure :
   // [in:get area] eback , gptr , egptr <= [out:put area] pbase , pptr , epptr
@@ -45,6 +80,10 @@ public:
   }
 
   std::size_t size() const noexcept { return pptr() - gptr(); }
+  std::size_t capacity() const noexcept { return m_buf.size(); }
+  std::size_t max_capacity() const noexcept { return m_max_capacity; }
+  // bytes that can still be prepared , 0 : backpressure
+  std::size_t available() const noexcept { return m_max_capacity - size(); }
 
   std::string_view data() const noexcept {
     return {gptr(), static_cast<std::size_t>(pptr() - gptr())};
@@ -61,14 +100,21 @@ public:
     if (std::size_t res_n = epptr() - pptr(); res_n >= n)
       return;
 
-    auto get_cur_pos = gptr() - m_buf.data();
-    auto put_cur_pos = pptr() - m_buf.data();
-    auto put_end_pos = put_cur_pos + n; // new end pos
+    auto unread = size();
+    if (n > available())
+      throw std::length_error{"stream_buffer exceeds max capacity."};
 
-    m_buf.resize(put_cur_pos + n);
-    auto base = m_buf.data();
-    setg(base, base + get_cur_pos, base + put_cur_pos);
-    setp(base + put_cur_pos, base + put_end_pos);
+    if (unread + n <= capacity())
+      relocate(capacity()); // compact , cheaper than growing
+    else
+      relocate(std::min(m_max_capacity, std::max(unread + n, capacity() * 2)));
+  }
+
+  // release memory above max(size() , low_water_mark)
+  void shrink(std::size_t low_water_mark = default_low_water_mark) {
+    auto cap = std::max(size(), low_water_mark);
+    if (cap < capacity())
+      relocate(cap);
   }
 
 protected:
@@ -93,8 +139,26 @@ protected:
     return ch;
   }
 
+private:
+  // move unread bytes to the front of a buffer of cap bytes ,
+  // put area becomes the rest of it.
+  void relocate(std::size_t cap) {
+    auto unread = size();
+    if (cap == capacity()) {
+      std::memmove(m_buf.data(), gptr(), unread);
+    } else {
+      auto buf = std::vector<char>(cap);
+      std::memcpy(buf.data(), gptr(), unread);
+      m_buf.swap(buf);
+    }
+    auto base = m_buf.data();
+    setg(base, base, base + unread);
+    setp(base + unread, base + cap);
+  }
+
 private:
   std::vector<char> m_buf;
+  std::size_t m_max_capacity;
 };
 
 } // namespace coio
@@ -1,7 +1,15 @@
 #include <gtest/gtest.h>
+#include <random>
+#include <sstream>
 #include <string>
 
+#include "buffer.hpp"
+#include "chained_buffer.hpp"
+#include "common/latency_histogram.hpp"
 #include "common/result_type.hpp"
+#include "common/string_search.hpp"
+#include "details/io_trace.hpp"
+#include "mirrored_ring_buffer.hpp"
 #include "stream_buffer.hpp"
 
 using namespace std::literals;
@@ -37,4 +45,277 @@ TEST(test_common, test_stream_buffer) {
   EXPECT_EQ(hello, s);
   buffer.consume(s.size());
   EXPECT_EQ(buffer.data(), ""sv);
-}
\ No newline at end of file
+}
+TEST(test_common, test_inline_iovecs) {
+  char a[4]{}, b[8]{};
+  auto fixed = make_iovecs(to_bytes(a), to_bytes(b), to_bytes(a));
+  static_assert(std::is_same_v<decltype(fixed), std::array<::iovec, 3>>);
+
+  std::vector<std::span<std::byte>> seq(3, to_bytes(b));
+  auto small = make_iovecs<4>(seq);
+  auto moved = std::move(small);
+  EXPECT_EQ(moved.size(), 3);
+  EXPECT_EQ(moved.data()[2].iov_base, b);
+  EXPECT_EQ(moved.data()[2].iov_len, 8);
+
+  seq.resize(5, to_bytes(a)); // spill to heap
+  auto large = make_iovecs<4>(seq);
+  EXPECT_EQ(large.size(), 5);
+  EXPECT_EQ(large.data()[4].iov_len, 4);
+
+  seq.resize(IOV_MAX + 1, to_bytes(a));
+  EXPECT_THROW(make_iovecs(seq), std::length_error);
+}
+
+TEST(test_common, test_stream_buffer_bounded) {
+  auto write = [](stream_buffer &buf, std::size_t n, char c) {
+    auto wb = buf.prepare(n);
+    memset(wb.data(), c, n);
+    buf.commit(n);
+  };
+
+  // compaction reuses the consumed prefix instead of growing
+  auto buffer = stream_buffer{};
+  write(buffer, 100, 'a');
+  buffer.consume(90);
+  auto cap = buffer.capacity();
+  write(buffer, cap - 20, 'b');
+  EXPECT_EQ(buffer.capacity(), cap);
+  EXPECT_EQ(buffer.data().substr(0, 11), "aaaaaaaaaab"sv);
+
+  // copy owns its bytes
+  auto copied = buffer;
+  buffer.consume(buffer.size());
+  EXPECT_EQ(copied.data().substr(0, 11), "aaaaaaaaaab"sv);
+
+  // hard limit with backpressure
+  auto bounded = stream_buffer{1024};
+  write(bounded, 1000, 'x');
+  EXPECT_EQ(bounded.available(), 24);
+  EXPECT_THROW(write(bounded, 100, 'y'), std::length_error);
+  bounded.consume(500);
+  write(bounded, 100, 'y');
+  EXPECT_LE(bounded.capacity(), 1024);
+  EXPECT_EQ(bounded.size(), 600);
+}
+
+// a keep-alive connection : messages of random size arrive in recv sized
+// pieces and are consumed once complete. memory must stay flat.
+TEST(test_common, test_stream_buffer_steady_state) {
+  constexpr std::size_t max_msg = 2000, recv_size = 512;
+  auto buffer = stream_buffer{};
+  auto rng = std::mt19937{7};
+  auto msg_len = std::uniform_int_distribution<std::size_t>{1, max_msg};
+
+  std::size_t pending = msg_len(rng), max_cap{};
+  for (int i = 0; i < 200000; ++i) {
+    auto wb = buffer.prepare(recv_size);
+    buffer.commit(wb.size());
+    while (buffer.size() >= pending) {
+      buffer.consume(pending);
+      pending = msg_len(rng);
+    }
+    max_cap = std::max(max_cap, buffer.capacity());
+  }
+  // unread < max_msg , plus one recv , rounded up by doubling
+  EXPECT_LE(max_cap, 2 * (max_msg + recv_size));
+
+  // idle : give memory back
+  buffer.consume(buffer.size());
+  buffer.shrink();
+  EXPECT_EQ(buffer.capacity(), stream_buffer::default_low_water_mark);
+}
+
+TEST(test_common, test_mirrored_ring_buffer) {
+  auto ring = mirrored_ring_buffer{100};
+  auto cap = ring.capacity();
+  EXPECT_EQ(cap % ::sysconf(_SC_PAGESIZE), 0);
+
+  auto write = [&](std::size_t n, char c) {
+    auto wb = ring.prepare(n);
+    static_assert(concepts::writeable_buffer<decltype(wb)>);
+    memset(wb.data(), c, n);
+    ring.commit(n);
+  };
+
+  write(cap - 100, 'a');
+  ring.consume(cap - 150);
+  write(cap - 100, 'b'); // crosses the wrap point
+  EXPECT_EQ(ring.size(), cap - 50);
+  EXPECT_EQ(ring.available(), 50);
+
+  // still one contiguous view
+  auto s = ring.data();
+  EXPECT_EQ(s.size(), cap - 50);
+  EXPECT_EQ(s.find_first_not_of('a'), 50);
+  EXPECT_EQ(s.find_last_not_of('b'), 49);
+
+  EXPECT_THROW(write(51, 'c'), std::length_error);
+  ring.consume(ring.size());
+  EXPECT_TRUE(ring.empty());
+  write(cap, 'd');
+  EXPECT_EQ(ring.data().find_first_not_of('d'), std::string_view::npos);
+}
+
+static_assert(concepts::buffer_sequence<
+              decltype(std::declval<chained_buffer &>().slices())>);
+static_assert(concepts::writeable_buffer_sequence<
+              decltype(std::declval<chained_buffer &>().prepare(0))>);
+
+TEST(test_common, test_chained_buffer) {
+  auto write = [](chained_buffer &buf, std::string_view s) {
+    auto spans = buf.prepare(s.size());
+    std::size_t n{};
+    for (auto span : spans) {
+      auto k = std::min(span.size(), s.size() - n);
+      memcpy(span.data(), s.data() + n, k);
+      n += k;
+    }
+    buf.commit(s.size());
+  };
+
+  auto buf = chained_buffer{};
+  write(buf, "GET / HTTP/1.1\r\n");
+  write(buf, "Host: a\r\n\r\n");
+  EXPECT_EQ(buf.size(), 27);
+  EXPECT_EQ(buf.slices().size(), 1); // contiguous writes share one slice
+  EXPECT_EQ(buf.find('\n'), 15);
+
+  // zero copy hand off , survives consuming the source
+  auto line = buf.split(16);
+  EXPECT_EQ(line.to_string(), "GET / HTTP/1.1\r\n");
+  EXPECT_EQ(line.slices().front().data(), buf.slices().front().data() - 16);
+  buf.consume(buf.size());
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(line.to_string(), "GET / HTTP/1.1\r\n");
+
+  // a write larger than one segment spans a chain of segments
+  auto big = std::string(details::segment_pool::segment_size * 2 + 10, 'x');
+  big.back() = 'y';
+  write(buf, big);
+  EXPECT_EQ(buf.size(), big.size());
+  EXPECT_GE(buf.slices().size(), 3);
+  EXPECT_EQ(buf.find('y'), big.size() - 1);
+  auto head = buf.split(details::segment_pool::segment_size + 1);
+  EXPECT_EQ(head.size() + buf.size(), big.size());
+  EXPECT_EQ(head.to_string() + buf.to_string(), big);
+
+  auto moved = std::move(head);
+  EXPECT_TRUE(head.empty());
+  moved.append(std::move(buf));
+  EXPECT_EQ(moved.to_string(), big);
+}
+
+TEST(test_common, test_latency_histogram) {
+  latency_histogram h{};
+  EXPECT_EQ(h.count(), 0);
+  EXPECT_EQ(h.percentile(99), 0);
+
+  for (uint64_t v = 1; v <= 10000; ++v)
+    h.record(v * 1000);
+  EXPECT_EQ(h.count(), 10000);
+  EXPECT_EQ(h.min(), 1000);
+  EXPECT_EQ(h.max(), 10000 * 1000);
+
+  // relative error of bucket is less than 1/32
+  auto near = [](uint64_t v, uint64_t expect) {
+    return v >= expect && v <= expect + expect / 32;
+  };
+  EXPECT_TRUE(near(h.percentile(50), 5000 * 1000));
+  EXPECT_TRUE(near(h.percentile(99), 9900 * 1000));
+  EXPECT_EQ(h.percentile(100), h.max());
+
+  latency_histogram other{};
+  other.record(1ull << 50); // clamp into last bucket
+  h.merge(other);
+  EXPECT_EQ(h.count(), 10001);
+  EXPECT_EQ(h.max(), 1ull << 50);
+  EXPECT_EQ(h.percentile(100), 1ull << 50);
+}
+
+TEST(test_common, test_trace_ring_dump) {
+  auto &ring = details::this_thread_trace_ring();
+  for (int i = 0; i < 3; ++i)
+    ring.push(io_trace_event{.submit_ns = 1000,
+                             .reap_ns = 3500,
+                             .resume_ns = 4000,
+                             .res = i,
+                             .op = to_io_op(IORING_OP_RECV)});
+  int cnt = 0;
+  ring.for_each([&](const io_trace_event &e) {
+    EXPECT_EQ(e.op, io_op::recv);
+    ++cnt;
+  });
+  EXPECT_GE(cnt, 3);
+
+  std::stringstream ss{};
+  dump_chrome_trace(ss);
+  auto json = ss.str();
+  EXPECT_TRUE(json.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+  EXPECT_NE(json.find(R"("name":"recv","cat":"kernel")"), std::string::npos);
+  EXPECT_NE(json.find(R"("ts":1.000,"dur":2.500)"), std::string::npos);
+  EXPECT_NE(json.find(R"("ts":3.500,"dur":0.500)"), std::string::npos);
+}
+
+TEST(test_common, test_string_search) {
+  namespace search = coio::details::search;
+  using find_fn = search::find_fn;
+  std::vector<std::pair<const char *, find_fn>> impls{
+      {"scalar", search::find_scalar}};
+#ifdef COIO_SEARCH_X86
+  impls.emplace_back("sse2", search::find_sse2);
+  if (search::has_avx2())
+    impls.emplace_back("avx2", search::find_avx2);
+#endif
+
+  auto rng = std::mt19937{42};
+  auto alphabet = "ab\r\n"sv; // dense partial matches
+  for (auto needle : {"\r\n\r\n"sv, "\r\n"sv, "abba"sv, "--bound--"sv}) {
+    for (std::size_t n : {0, 1, 3, 15, 16, 17, 31, 32, 33, 47, 64, 100, 1000}) {
+      auto hay = std::string(n, 'x');
+      for (auto &c : hay)
+        c = alphabet[rng() % alphabet.size()];
+      // and one planted needle at a random spot
+      if (n >= needle.size())
+        hay.replace(rng() % (n - needle.size() + 1), needle.size(), needle);
+
+      for (std::size_t from : {std::size_t{0}, n / 2}) {
+        auto expect = std::string_view{hay}.find(needle, from);
+        EXPECT_EQ(coio::find_delimiter(hay, needle, from), expect)
+            << needle << " in " << n << " bytes";
+        if (from + needle.size() > n)
+          continue;
+        for (auto [name, fn] : impls) {
+          auto r =
+              fn(hay.data() + from, n - from, needle.data(), needle.size());
+          EXPECT_EQ(r == search::npos ? r : r + from, expect) << name;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(coio::find_delimiter("abc", "c", 1), 2);
+  EXPECT_EQ(coio::find_delimiter("abc", "", 1), 1);
+  EXPECT_EQ(coio::find_delimiter("abc", "c", 4), search::npos);
+
+  // every byte value , both cases , across the vector widths
+  for (std::size_t n : {0, 5, 16, 31, 32, 40, 100}) {
+    auto a = std::string(n, '\0');
+    for (std::size_t i = 0; i < n; ++i)
+      a[i] = static_cast<char>(rng());
+    auto b = a;
+    for (auto &c : b)
+      if (c >= 'a' && c <= 'z')
+        c -= 0x20;
+    EXPECT_TRUE(coio::ascii_iequals(a, b)) << n;
+    if (n == 0)
+      continue;
+    // '@' / '`' and '[' / '{' differ only in bit 0x20 , not a case pair
+    b.back() = a.back() ^ 0x20;
+    bool is_alpha = std::isalpha(static_cast<unsigned char>(a.back()));
+    EXPECT_EQ(coio::ascii_iequals(a, b), is_alpha) << n;
+  }
+  EXPECT_TRUE(coio::ascii_iequals("Content-Length", "content-length"));
+  EXPECT_FALSE(coio::ascii_iequals("Content-Length", "content-lengt"));
+  EXPECT_FALSE(
+      coio::ascii_iequals("Transfer-Encoding-[X]", "transfer-encoding-{x}"));
+}
@@ -0,0 +1,291 @@
+#include "future.hpp"
+#include "http/dns_cache.hpp"
+#include "http/dns_message.hpp"
+#include "http/dns_resolver.hpp"
+#include "io_context.hpp"
+#include "ioutils/udp.hpp"
+#include "when_all.hpp"
+#include <array>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+void append_name(std::string &out, std::string_view name) {
+  while (!name.empty()) {
+    auto label = name.substr(0, name.find('.'));
+    out.push_back(static_cast<char>(label.size()));
+    out.append(label);
+    name.remove_prefix(std::min(name.size(), label.size() + 1));
+  }
+  out.push_back('\0');
+}
+
+struct stub_record {
+  std::string name;
+  coio::dns::rr_type type;
+  std::string rdata;
+};
+
+std::string a_rdata(uint8_t last) {
+  return {10, 0, 0, static_cast<char>(last)};
+}
+
+std::string name_rdata(std::string_view name) {
+  auto out = std::string{};
+  append_name(out, name);
+  return out;
+}
+
+// the query with its header turned into a response , then the answers
+std::string make_response(std::string_view query, coio::dns::rcode code,
+                          const std::vector<stub_record> &answers) {
+  auto out = std::string{query};
+  out[2] = static_cast<char>(0x81);
+  out[3] = static_cast<char>(0x80 | static_cast<uint8_t>(code));
+  out[6] = 0;
+  out[7] = static_cast<char>(answers.size());
+  for (auto &rr : answers) {
+    append_name(out, rr.name);
+    coio::dns::details::put16(out, static_cast<uint16_t>(rr.type));
+    coio::dns::details::put16(out, 1);
+    out.append({0, 0, 0, 60}); // ttl
+    coio::dns::details::put16(out, static_cast<uint16_t>(rr.rdata.size()));
+    out.append(rr.rdata);
+  }
+  return out;
+}
+
+struct stub_query {
+  std::string data;
+  std::string name;
+  coio::ipv4::address peer{};
+};
+
+coio::future<stub_query> recv_query(coio::udp_sock<> &sock) {
+  auto buf = std::array<char, 512>{};
+  auto q = stub_query{};
+  auto n =
+      co_await sock.recvfrom(q.peer, std::as_writable_bytes(std::span{buf}));
+  q.data.assign(buf.data(), n);
+  coio::dns::decode_name(q.data, coio::dns::header_size, q.name);
+  co_return q;
+}
+
+// a plain sendto , braced answers can not live in a co_await expression
+void send_response(coio::udp_sock<> &sock, const stub_query &q,
+                   coio::dns::rcode code,
+                   const std::vector<stub_record> &answers) {
+  auto rsp = make_response(q.data, code, answers);
+  ::sendto(sock.native_handle(), rsp.data(), rsp.size(), 0, q.peer.ptr(),
+           q.peer.len());
+}
+
+} // namespace
+
+TEST(test_dns, test_message) {
+  using namespace coio::dns;
+  auto query = std::string{};
+  EXPECT_TRUE(encode_query(query, 0x1234, "www.Example.com.", rr_type::a));
+  EXPECT_EQ(query, "\x12\x34\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                   "\x03www\x07"
+                   "Example\x03"
+                   "com\x00\x00\x01\x00\x01"sv);
+  auto bad = std::string{};
+  EXPECT_FALSE(encode_query(bad, 1, "a..b", rr_type::a));
+  EXPECT_FALSE(encode_query(bad, 1, std::string(64, 'x'), rr_type::a));
+
+  // compressed owner names , a cname chain and an unrelated record
+  auto msg = make_response(query, rcode::no_error,
+                           {{"www.example.com", rr_type::cname,
+                             name_rdata("web.example.com")},
+                            {"other.example.com", rr_type::a, a_rdata(9)},
+                            {"web.example.com", rr_type::a, a_rdata(1)}});
+  msg.append({'\xc0', '\x0c'}); // an extra record named by a pointer
+  msg.append({0, 1, 0, 1, 0, 0, 0, 5, 0, 4, 10, 0, 0, 2});
+  msg[7] = 4;
+  auto rsp = decode_response(msg);
+  ASSERT_TRUE(rsp);
+  EXPECT_EQ(rsp->id, 0x1234);
+  EXPECT_EQ(rsp->code, rcode::no_error);
+  EXPECT_EQ(rsp->question, "www.Example.com");
+  EXPECT_EQ(rsp->answers.size(), 4);
+  EXPECT_EQ(rsp->answers[3].name, "www.Example.com");
+  EXPECT_EQ(rsp->answers[3].ttl, 5);
+
+  auto last = std::vector<int>{};
+  for_each_address(msg, *rsp, rr_type::a, [&](const record &rr) {
+    last.push_back(static_cast<uint8_t>(msg[rr.data_off + 3]));
+  });
+  EXPECT_EQ(last, (std::vector<int>{2, 1}));
+
+  // a pointer to itself , a truncated record
+  auto loop = query;
+  loop[12] = '\xc0', loop[13] = '\x0c';
+  loop[2] = '\x81';
+  EXPECT_FALSE(decode_response(loop));
+  EXPECT_FALSE(decode_response(msg.substr(0, msg.size() - 3)));
+}
+
+TEST(test_dns, test_config) {
+  auto conf = coio::resolv_conf::parse(
+      "# comment\n"
+      "nameserver 10.0.0.1\n"
+      "nameserver ::1\n"
+      "nameserver 10.0.0.2 ; comment\n"
+      "search corp example.com\n"
+      "options ndots:2 timeout:3 attempts:4\n");
+  EXPECT_EQ(conf.nameservers,
+            (std::vector{coio::ipv4::address{53, "10.0.0.1"},
+                         coio::ipv4::address{53, "10.0.0.2"}}));
+  EXPECT_EQ(conf.search, (std::vector<std::string>{"corp", "example.com"}));
+  EXPECT_EQ(conf.ndots, 2);
+  EXPECT_EQ(conf.timeout, 3s);
+  EXPECT_EQ(conf.attempts, 4);
+  EXPECT_EQ(coio::resolv_conf::parse("").nameservers,
+            (std::vector{coio::ipv4::address{53, "127.0.0.1"}}));
+
+  auto hosts = coio::hosts_file::parse("127.0.0.1 localhost\n"
+                                       "::1 localhost ip6-localhost\n"
+                                       "10.9.9.9\tMyHost.local myhost # x\n");
+  ASSERT_TRUE(hosts.find("myhost.LOCAL."));
+  EXPECT_EQ(hosts.find("myhost")->front(), coio::ipv4::address(0, "10.9.9.9"));
+  EXPECT_EQ(hosts.find("localhost")->size(), 1);
+  EXPECT_FALSE(hosts.find("ip6-localhost"));
+}
+
+TEST(test_dns, test_native_resolver) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto stub = coio::udp_sock{};
+  stub.bind(coio::ipv4::address{5393, "127.0.0.1"});
+  auto conf = coio::resolv_conf{
+      .nameservers = {coio::ipv4::address{5393, "127.0.0.1"}},
+      .search = {"corp"},
+      .timeout = 50ms,
+  };
+  auto &resolver = coio::dns_resolver::configure(
+      conf, coio::hosts_file::parse("10.9.9.9 myhost\n"));
+
+  using coio::dns::rcode, coio::dns::rr_type;
+  auto serve = [&]() -> coio::future<void> {
+    // two in flight on one socket , answered in reverse order
+    auto q1 = co_await recv_query(stub);
+    auto q2 = co_await recv_query(stub);
+    EXPECT_EQ(q1.name, "a.coio.test");
+    EXPECT_EQ(q2.name, "b.coio.test");
+    send_response(stub, q2, rcode::no_error,
+                  {{q2.name, rr_type::a, a_rdata(2)}});
+    send_response(stub, q1, rcode::no_error,
+                  {{q1.name, rr_type::a, a_rdata(1)}});
+
+    // the first one is lost , answered on retry
+    auto lost = co_await recv_query(stub);
+    auto retry = co_await recv_query(stub);
+    EXPECT_EQ(lost.data, retry.data);
+    send_response(stub, retry, rcode::no_error,
+                  {{retry.name, rr_type::a, a_rdata(3)}});
+
+    auto nx = co_await recv_query(stub);
+    EXPECT_EQ(nx.name, "nx.coio.test");
+    send_response(stub, nx, rcode::name_error, {});
+
+    // a forged id first
+    auto alias = co_await recv_query(stub);
+    auto forged = alias;
+    forged.data[0] ^= 1;
+    send_response(stub, forged, rcode::no_error,
+                  {{alias.name, rr_type::a, a_rdata(66)}});
+    send_response(stub, alias, rcode::no_error,
+                  {{alias.name, rr_type::cname,
+                    name_rdata("real.coio.test")},
+                   {"real.coio.test", rr_type::a, a_rdata(5)}});
+
+    // the search list first , fewer dots than ndots
+    auto search = co_await recv_query(stub);
+    EXPECT_EQ(search.name, "intranet.corp");
+    send_response(stub, search, rcode::no_error,
+                  {{search.name, rr_type::a, a_rdata(6)}});
+  };
+
+  auto lookup = [&](std::string host) -> coio::future<std::string> {
+    auto r = co_await resolver.lookup(std::move(host), "80");
+    if (r.status == coio::dns_lookup_result::not_found)
+      co_return "not found";
+    if (r.status != coio::dns_lookup_result::ok)
+      co_return "failed";
+    co_return r.addresses.front().to_string();
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      auto both = coio::when_all(lookup("a.coio.test"), lookup("b.coio.test"));
+      auto [a, b] = co_await std::move(both);
+      EXPECT_EQ(a, "10.0.0.1:80");
+      EXPECT_EQ(b, "10.0.0.2:80");
+      EXPECT_EQ(co_await lookup("lost.coio.test"), "10.0.0.3:80");
+      EXPECT_EQ(co_await lookup("nx.coio.test."), "not found");
+      EXPECT_EQ(co_await lookup("alias.coio.test"), "10.0.0.5:80");
+      EXPECT_EQ(co_await lookup("intranet"), "10.0.0.6:80");
+      // answered locally
+      EXPECT_EQ(co_await lookup("MyHost"), "10.9.9.9:80");
+      EXPECT_EQ(co_await lookup("127.0.0.1"), "127.0.0.1:80");
+      // nobody answers any more
+      EXPECT_EQ(co_await lookup("silent.coio.test."), "failed");
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve());
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_dns, test_native_cache) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto stub = coio::udp_sock{};
+  stub.bind(coio::ipv4::address{5394, "127.0.0.1"});
+  coio::dns_resolver::configure(coio::resolv_conf{
+      .nameservers = {coio::ipv4::address{5394, "127.0.0.1"}},
+      .timeout = 50ms,
+  });
+
+  auto serve = [&]() -> coio::future<void> {
+    auto q = co_await recv_query(stub);
+    send_response(stub, q, coio::dns::rcode::no_error,
+                  {{q.name, coio::dns::rr_type::a, a_rdata(7)}});
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      auto cache = coio::dns_cache{{.backend = coio::dns_backend::native}};
+      for (int i = 0; i < 3; ++i) {
+        auto addrs = co_await cache.lookup("cached.coio.test", "http");
+        EXPECT_TRUE(addrs && addrs->front().to_string() == "10.0.0.7:80");
+      }
+      EXPECT_EQ(cache.stats().misses, 1);
+      EXPECT_EQ(cache.stats().hits, 2);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve());
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
@@ -1,9 +1,14 @@
+#include "aligned_buffer_pool.hpp"
 #include "future.hpp"
 #include "io_context.hpp"
+#include "ioutils/direct_file.hpp"
 #include "ioutils/file.hpp"
+#include <cstring>
 #include <filesystem>
 #include <gtest/gtest.h>
 #include <span>
+#include <stdexcept>
+#include <vector>
 
 TEST(test_file, test_trivally_read_write) {
   namespace fs = std::filesystem;
@@ -42,6 +47,15 @@ TEST(test_file, test_trivally_read_write) {
       EXPECT_EQ(std::string_view(b1.data(), 6), "hello ");
       EXPECT_EQ(std::string_view(b2.data(), 6), "world.");
 
+      // readv with a runtime buffer sequence
+      std::array<char, 4> parts[3]{};
+      std::vector<std::span<std::byte>> seq{};
+      for (auto &p : parts)
+        seq.push_back(coio::to_bytes(p));
+      n = co_await file.readv(0, seq);
+      EXPECT_EQ(n, write_str.size());
+      EXPECT_EQ(std::string_view(parts[2].data(), 4), "rld."sv);
+
     } catch (...) {
       exp = std::current_exception();
     }
@@ -51,4 +65,76 @@ TEST(test_file, test_trivally_read_write) {
   ctx.run();
   if (exp)
     std::rethrow_exception(exp);
-}
\ No newline at end of file
+}
+
+TEST(test_file, test_aligned_buffer_pool) {
+  auto pool = coio::aligned_buffer_pool{5000};
+  EXPECT_EQ(pool.buffer_size(), 8192);
+  auto *first = static_cast<std::byte *>(nullptr);
+  {
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    first = a.data();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % 4096, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b.data()) % 4096, 0);
+    EXPECT_EQ(b.data(), a.data() + 8192);
+    std::memset(b.data(), 1, b.size());
+  }
+  // 64 KiB slab , both back
+  EXPECT_EQ(pool.idle(), 8);
+  EXPECT_EQ(pool.acquire().data(), first);
+
+  EXPECT_THROW(coio::aligned_buffer_pool(4096, 3000), std::invalid_argument);
+
+  // falls back to normal pages without reserved huge pages
+  auto huge = coio::aligned_buffer_pool{1 << 20, 4096, true};
+  auto h = huge.acquire();
+  std::memset(h.data(), 1, h.size());
+  EXPECT_EQ(huge.idle(), 1);
+}
+
+TEST(test_file, test_direct_io) {
+  namespace fs = std::filesystem;
+  coio::io_context ctx{};
+  auto _ = ctx.bind_this_thread();
+  std::exception_ptr exp{};
+  auto run = [&]() -> coio::future<void> {
+    try {
+      if (!fs::exists("./tmp"))
+        fs::create_directory("./tmp");
+      auto f = co_await coio::direct_file::openat(
+          "./tmp/direct.bin", O_CREAT | O_TRUNC | O_RDWR, 0644);
+      auto align = f.offset_alignment();
+      EXPECT_GT(align, 0);
+      EXPECT_EQ(align % 512, 0);
+
+      auto pool = coio::aligned_buffer_pool{2 * align, f.memory_alignment()};
+      auto out = pool.acquire();
+      for (std::size_t i = 0; i < out.size(); ++i)
+        out.data()[i] = static_cast<std::byte>(i % 251);
+      EXPECT_EQ(co_await f.write(out, 0), out.size());
+      EXPECT_EQ(co_await f.write(out.first(align), out.size()), align);
+
+      auto in = pool.acquire();
+      EXPECT_EQ(co_await f.read(in, align), in.size());
+      EXPECT_EQ(std::memcmp(in.data(), out.data() + align, align), 0);
+      EXPECT_EQ(std::memcmp(in.data() + align, out.data(), align), 0);
+      // short at the end of the file
+      EXPECT_EQ(co_await f.read(in, 2 * align), align);
+
+      // refused before anything is submitted
+      EXPECT_THROW((void)f.read(in, 1), std::invalid_argument);
+      EXPECT_THROW((void)f.read(in.first(align - 1), 0),
+                   std::invalid_argument);
+      EXPECT_THROW((void)f.write(std::span{in.data() + 1, align}, 0),
+                   std::invalid_argument);
+    } catch (...) {
+      exp = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+  ctx.co_spawn(run());
+  ctx.run();
+  if (exp)
+    std::rethrow_exception(exp);
+}
@@ -1,9 +1,13 @@
+#include "async_generator.hpp"
+#include "future.hpp"
 #include "generator.hpp"
+#include "sync_wait.hpp"
 #include <concepts>
 #include <gtest/gtest.h>
 #include <iterator>
 #include <ranges>
 #include <string>
+#include <vector>
 
 using coio::generator;
 using namespace std::literals;
@@ -201,4 +205,49 @@ TEST(test_generator, test_with_stdranges) {
     ASSERT_EQ(i, v);
     v += 2;
   }
-}
\ No newline at end of file
+}
+namespace {
+
+auto async_square(int i) -> coio::future<int> { co_return i * i; }
+
+auto async_squares(int n) -> coio::async_generator<int> {
+  for (int i = 0; i < n; ++i)
+    co_yield co_await async_square(i);
+}
+
+auto async_sum(int n) -> coio::future<std::vector<int>> {
+  auto values = std::vector<int>{};
+  auto g = async_squares(n);
+  while (auto *v = co_await g.next())
+    values.push_back(*v);
+  // stays exhausted
+  EXPECT_EQ(co_await g.next(), nullptr);
+  co_return values;
+}
+
+auto async_throws() -> coio::async_generator<std::string> {
+  co_yield "first"s;
+  throw std::runtime_error{"second"};
+}
+
+auto async_catch() -> coio::future<std::string> {
+  auto g = async_throws();
+  auto *v = co_await g.next();
+  EXPECT_NE(v, nullptr);
+  // the yielded value is gone once the generator is resumed
+  auto first = *v;
+  try {
+    co_await g.next();
+  } catch (const std::runtime_error &e) {
+    co_return first + e.what();
+  }
+  co_return ""s;
+}
+
+} // namespace
+
+TEST(test_generator, test_async_generator) {
+  EXPECT_EQ(coio::sync_wait(async_sum(5)), (std::vector<int>{0, 1, 4, 9, 16}));
+  EXPECT_TRUE(coio::sync_wait(async_sum(0)).empty());
+  EXPECT_EQ(coio::sync_wait(async_catch()), "firstsecond");
+}
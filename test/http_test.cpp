@@ -1,13 +1,21 @@
 #include "common/scope_guard.hpp"
 #include "details/await_counter.hpp"
 #include "future.hpp"
+#include "http/dns_cache.hpp"
 #include "http/httpclient.hpp"
+#include "http/httpserver.hpp"
 #include "http/resolver.hpp"
 #include "http/url.hpp"
 #include "io_context.hpp"
+#include "ioutils/udp.hpp"
+#include "time_delay.hpp"
+#include "when_all.hpp"
+#include <algorithm>
+#include <array>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <netdb.h>
+#include <thread>
 
 using namespace std::literals;
 
@@ -32,7 +40,7 @@ TEST(test_http, test_resovler) {
     for (auto &l : list) {
       EXPECT_TRUE(l.node);
       auto addr = l.to_address();
-      EXPECT_EQ(addr.addr.sin_family, AF_INET);
+      EXPECT_TRUE(addr.is_v4());
       std::cout << l.get_name() << " " << addr.to_string() << std::endl;
     }
   }());
@@ -47,7 +55,7 @@ TEST(test_http, test_resovler) {
     for (auto &l : list.value()) {
       EXPECT_TRUE(l.node);
       auto addr = l.to_address();
-      EXPECT_EQ(addr.addr.sin_family, AF_INET);
+      EXPECT_TRUE(addr.is_v4() || addr.is_v6());
       std::cout << l.get_name() << " " << addr.to_string() << std::endl;
     }
   }());
@@ -61,6 +69,185 @@ TEST(test_http, test_resovler) {
   ctx.run();
 }
 
+// answers n A queries with 10.0.0.<query index> , and the AAAA query
+// sent along with each of them : only names starting with "v6." have one ,
+// fd00::1. names starting with "nx." do not exist.
+coio::future<void> serve_dns(coio::udp_sock<> &sock, int n) {
+  for (int i = 1, aaaa_cnt = 0; i <= n || aaaa_cnt < i - 1;) {
+    auto buf = std::array<unsigned char, 512>{};
+    auto peer = coio::ipv4::address{};
+    auto len = co_await sock.recvfrom(peer, std::as_writable_bytes(
+                                                std::span{buf}));
+    // header , then the question : labels , type , class
+    auto end = std::size_t{12};
+    while (end < len && buf[end] != 0)
+      end += buf[end] + 1;
+    end += 5;
+    auto aaaa = buf[end - 3] == 28;
+    buf[2] = 0x81, buf[3] = 0x80;  // response , recursion available
+    buf[7] = 1;                    // one answer
+    buf[8] = buf[9] = buf[10] = buf[11] = 0;
+    if (buf[12] == 2 && buf[13] == 'n' && buf[14] == 'x') {
+      buf[3] = 0x83, buf[7] = 0; // NXDOMAIN
+      co_await sock.sendto(peer, std::as_bytes(std::span{buf.data(), end}));
+      aaaa ? ++aaaa_cnt : ++i;
+      continue;
+    }
+    if (aaaa) {
+      auto v6 = buf[12] == 2 && buf[13] == 'v' && buf[14] == '6';
+      const unsigned char answer[] = {
+          0xc0, 12, 0, 28, 0, 1, 0, 0, 0, 60, // name , AAAA , IN , ttl
+          0,    16, 0xfd, 0, 0, 0, 0, 0, 0, 0,
+          0,    0,  0,    0, 0, 0, 0, 1};
+      buf[7] = v6;
+      std::copy(std::begin(answer), std::end(answer), buf.begin() + end);
+      co_await sock.sendto(peer, std::as_bytes(std::span{
+                                     buf.data(), end + v6 * sizeof(answer)}));
+      ++aaaa_cnt;
+      continue;
+    }
+    const unsigned char answer[] = {
+        0xc0, 12, 0, 1, 0, 1, 0, 0, 0, 60, // name , A , IN , ttl
+        0,    4,  10, 0, 0, static_cast<unsigned char>(i)};
+    std::copy(std::begin(answer), std::end(answer), buf.begin() + end);
+    co_await sock.sendto(peer, std::as_bytes(std::span{buf.data(),
+                                                       end + sizeof(answer)}));
+    ++i;
+  }
+}
+
+TEST(test_http, test_resolver_on_uring) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto dns = coio::udp_sock{};
+  dns.bind(coio::ipv4::address{5391, "127.0.0.1"});
+  coio::async_resolver::current().set_servers("127.0.0.1:5391");
+
+  auto query = [](std::string host) -> coio::future<std::string> {
+    auto list = co_await coio::async_query(std::move(host), "80");
+    if (!list || list->begin() == list->end())
+      co_return "";
+    co_return (*list->begin()).to_address().to_string();
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      // in flight together , on the poll of the same socket
+      auto both = coio::when_all(query("a.coio.test"), query("b.coio.test"));
+      auto [ra, rb] = co_await std::move(both);
+      EXPECT_EQ(ra, "10.0.0.1:80");
+      EXPECT_EQ(rb, "10.0.0.2:80");
+      // numeric , answered without a round trip
+      EXPECT_EQ(co_await query("127.0.0.1"), "127.0.0.1:80");
+      // A and AAAA
+      auto list = co_await coio::async_query("v6.coio.test", "80");
+      auto addrs = std::vector<std::string>{};
+      if (list)
+        for (auto &v : *list)
+          addrs.push_back(v.to_address().to_string());
+      std::ranges::sort(addrs);
+      EXPECT_EQ(addrs,
+                (std::vector<std::string>{"10.0.0.3:80", "fd00::1:80"}));
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_dns(dns, 3));
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+// a resolver per thread , the c-ares library initialized once
+TEST(test_http, test_resolver_threads) {
+  auto resolved = std::array<std::string, 4>{};
+  {
+    auto threads = std::vector<std::jthread>{};
+    for (auto &addr : resolved)
+      threads.emplace_back([&addr] {
+        auto ctx = coio::io_context{};
+        auto _ = ctx.bind_this_thread();
+        auto run = [&]() -> coio::future<void> {
+          try {
+            auto list = co_await coio::async_query("127.0.0.1", "80");
+            if (list && list->begin() != list->end())
+              addr = (*list->begin()).to_address().to_string();
+          } catch (...) {
+          }
+          ctx.request_stop();
+        };
+        // a numeric host is answered without suspending , start in run()
+        ctx.post([&] { ctx.co_spawn(run()); });
+        ctx.run();
+      });
+  }
+  for (auto &addr : resolved)
+    EXPECT_EQ(addr, "127.0.0.1:80");
+}
+
+TEST(test_http, test_dns_cache) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto dns = coio::udp_sock{};
+  dns.bind(coio::ipv4::address{5392, "127.0.0.1"});
+  coio::async_resolver::current().set_servers("127.0.0.1:5392");
+
+  auto cache = coio::dns_cache{};
+  // every answer expires at once , stays usable for a minute
+  auto stale = coio::dns_cache{{.min_ttl = 0s, .max_ttl = 0s}};
+  auto lookup = [](coio::dns_cache &c,
+                   std::string_view host) -> coio::future<std::string> {
+    auto addrs = co_await c.lookup(host, "80");
+    co_return addrs ? addrs->front().to_string() : "";
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      // one query for both
+      auto both = coio::when_all(lookup(cache, "a.coio.test"),
+                                 lookup(cache, "a.coio.test"));
+      auto [r1, r2] = co_await std::move(both);
+      EXPECT_EQ(r1, "10.0.0.1:80");
+      EXPECT_EQ(r2, "10.0.0.1:80");
+      EXPECT_EQ(co_await lookup(cache, "a.coio.test"), "10.0.0.1:80");
+      EXPECT_EQ(cache.stats().misses, 1);
+      EXPECT_EQ(cache.stats().coalesced, 1);
+      EXPECT_EQ(cache.stats().hits, 1);
+
+      // not existing , asked once
+      EXPECT_EQ(co_await lookup(cache, "nx.coio.test."), "");
+      EXPECT_EQ(co_await lookup(cache, "nx.coio.test."), "");
+      EXPECT_EQ(cache.stats().misses, 2);
+      EXPECT_EQ(cache.stats().negative_hits, 1);
+
+      // stale while revalidate
+      EXPECT_EQ(co_await lookup(stale, "b.coio.test"), "10.0.0.3:80");
+      EXPECT_EQ(co_await lookup(stale, "b.coio.test"), "10.0.0.3:80");
+      EXPECT_EQ(stale.stats().stale_hits, 1);
+      co_await coio::time_delay(20ms);
+      EXPECT_EQ(co_await lookup(stale, "b.coio.test"), "10.0.0.4:80");
+      EXPECT_EQ(stale.stats().misses, 1);
+      EXPECT_EQ(stale.stats().stale_hits, 2);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_dns(dns, 5));
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
 TEST(test_http, test_url) {
   auto www = "https://en.cppreference.com/w/cpp/20"sv;
   auto result = coio::url::parse(www);
@@ -88,6 +275,14 @@ TEST(test_http, test_url) {
   EXPECT_EQ(result.value().host, "purecpp.org");
   EXPECT_EQ(result.value().path, "/");
   EXPECT_EQ(result.value().query, "");
+  EXPECT_EQ(result.value().port, "");
+
+  result = coio::url::parse("http://127.0.0.1:8080/a?b=1");
+  ASSERT_TRUE(!result.is_error());
+  EXPECT_EQ(result.value().host, "127.0.0.1");
+  EXPECT_EQ(result.value().port, "8080");
+  EXPECT_EQ(result.value().path, "/a");
+  EXPECT_EQ(result.value().query, "b=1");
 }
 
 TEST(test_http, test_header) {
@@ -111,6 +306,57 @@ Set-Cookie: CSESSIONID=aaaaaaaaaaaaaaaaaaaaaaaa; path=/
   // std::cout << parser.status << " " << parser.message << std::endl;
 }
 
+TEST(test_http, test_view_response) {
+  // more headers than the smallest table , a repeated name
+  auto head = std::string{"HTTP/1.1 404 Not Found\r\n"};
+  for (int i = 0; i < 12; ++i)
+    head += "X-Header-" + std::to_string(i) + ": v" + std::to_string(i) +
+            "\r\n";
+  head += "Set-Cookie: a=1\r\nSET-COOKIE: b=2\r\nContent-Length: 5\r\n\r\n";
+
+  coio::http_parser parser{};
+  ASSERT_EQ(parser.parse_response(head), int(head.size()));
+  auto builder = coio::http_view_response::builder{head, parser, 5};
+  builder.append_body("hel");
+  builder.append_body("lo");
+  // the parsed head may go away now
+  head.assign(head.size(), '#');
+  auto rsp = std::move(builder).finish();
+
+  EXPECT_EQ(rsp.status_code(), 404);
+  EXPECT_EQ(rsp.reason(), "Not Found");
+  EXPECT_EQ(rsp.body(), "hello");
+  EXPECT_TRUE(rsp.head().starts_with("HTTP/1.1 404"));
+  EXPECT_EQ(rsp.header_count(), 15);
+  for (int i = 0; i < 12; ++i)
+    EXPECT_EQ(rsp.header("x-HEADER-" + std::to_string(i)),
+              "v" + std::to_string(i));
+  EXPECT_EQ(rsp.header("set-cookie"), "a=1");
+  EXPECT_EQ(rsp.header_at(13).second, "b=2");
+  EXPECT_EQ(rsp.header("content-length"), "5");
+  EXPECT_EQ(rsp.header("x-header-12"), std::nullopt);
+
+  // a body past the first pooled segment , grown without a hint
+  coio::http_parser p2{};
+  auto head2 = "HTTP/1.1 200 OK\r\n\r\n"sv;
+  ASSERT_GT(p2.parse_response(head2), 0);
+  auto b2 = coio::http_view_response::builder{head2, p2};
+  auto chunk = std::string(10000, 'y');
+  for (int i = 0; i < 10; ++i)
+    b2.append_body(chunk);
+  auto big = std::move(b2).finish();
+  EXPECT_EQ(big.body().size(), 100000);
+  EXPECT_EQ(big.header_count(), 0);
+  EXPECT_EQ(big.header("content-length"), std::nullopt);
+
+  // an announced length is not reserved beyond max_body_hint
+  coio::http_parser p3{};
+  ASSERT_GT(p3.parse_response(head2), 0);
+  auto b3 = coio::http_view_response::builder{head2, p3, std::size_t{1} << 40};
+  b3.append_body("small");
+  EXPECT_EQ(std::move(b3).finish().body(), "small");
+}
+
 TEST(test_http, test_client) {
   auto client = coio::http_client{};
   auto ptr = std::exception_ptr{};
@@ -158,3 +404,493 @@ TEST(test_http, test_client) {
   if (ptr)
     std::rethrow_exception(ptr);
 }
+
+TEST(test_http, test_local_server) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+  auto body = "hello from 127.0.0.1"sv;
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8891});
+  acceptor.listen();
+
+  auto run_server = [&]() -> coio::future<void> {
+    try {
+      auto sock = co_await acceptor.accept();
+      auto reader = coio::buffered_reader{sock};
+      auto head = co_await reader.read_until("\r\n\r\n");
+      EXPECT_TRUE(head.starts_with("GET /index?a=1 HTTP/1.1\r\n"));
+      EXPECT_NE(head.find("Host:127.0.0.1:8891\r\n"), std::string_view::npos);
+
+      auto writer = coio::buffered_writer{sock};
+      writer.write("HTTP/1.0 200 OK\r\n"sv);
+      writer.write("Content-Length: " + std::to_string(body.size()));
+      writer.write("\r\n\r\n"sv);
+      writer.write(body);
+      co_await writer.flush();
+      // let the client close first , keeps 8891 out of TIME_WAIT
+      auto eof = co_await reader.read_some(1);
+      EXPECT_TRUE(eof.empty());
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      auto client = coio::http_client{};
+      auto result = co_await client.get("http://127.0.0.1:8891/index?a=1");
+      EXPECT_FALSE(result.is_error());
+      result.map([&](coio::http_response rsp) {
+        EXPECT_EQ(rsp.status_code, 200);
+        EXPECT_EQ(rsp.rsp, body);
+      });
+    } catch (...) {
+      ptr = std::current_exception();
+      ctx.request_stop();
+    }
+  };
+
+  ctx.co_spawn(run_server()); // suspend on : co_await acceptor.accept()
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+// loopback http/1.1 server , respond(head) makes every response.
+// a connection is closed after a "Connection: close" response.
+template <class F>
+coio::future<void> serve_http_conn(coio::tcp_sock<> sock, F &respond) {
+  auto reader = coio::buffered_reader{sock};
+  auto writer = coio::buffered_writer{sock};
+  try {
+    while (true) {
+      auto head = co_await reader.read_until("\r\n\r\n");
+      if (!head.ends_with("\r\n\r\n"))
+        break;
+      auto rsp = respond(head);
+      writer.write(rsp);
+      co_await writer.flush();
+      if (rsp.find("Connection: close") != std::string::npos)
+        break;
+    }
+  } catch (...) {
+  }
+}
+
+template <class F>
+coio::future<void> serve_http(coio::acceptor<> &acceptor, std::size_t &accepted,
+                              F &respond) {
+  while (true) {
+    auto sock = co_await acceptor.accept();
+    ++accepted;
+    coio::io_context::current_context()->co_spawn(
+        serve_http_conn(std::move(sock), respond));
+  }
+}
+
+TEST(test_http, test_keep_alive) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8892});
+  acceptor.listen();
+
+  std::size_t accepted{}, served{};
+  auto respond = [&](std::string_view head) -> std::string {
+    EXPECT_TRUE(head.starts_with("GET / HTTP/1.1\r\n"));
+    if (head.find("connection: close\r\n") != std::string::npos) {
+      // the user's header , in any case , replaces the default one
+      EXPECT_EQ(head.find("Connection:"), std::string::npos);
+      ++served;
+      return "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+             "Connection: close\r\n\r\nfifth";
+    }
+    EXPECT_NE(head.find("Connection: keep-alive\r\n"), std::string::npos);
+    switch (++served) {
+    case 1:
+      return "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nfirst";
+    case 2:
+      return "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+             "3\r\nsec\r\n3\r\nond\r\n0\r\n\r\n";
+    case 3:
+      return "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+             "Connection: close\r\n\r\nthird";
+    default:
+      return "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nfourth";
+    }
+  };
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      auto client = coio::http_client{};
+      auto url = "http://127.0.0.1:8892/"sv;
+      for (auto expect : {"first"sv, "second"sv, "third"sv, "fourth"sv}) {
+        auto result = co_await client.get(url);
+        EXPECT_FALSE(result.is_error());
+        result.map([&](coio::http_response rsp) {
+          EXPECT_EQ(rsp.status_code, 200);
+          EXPECT_EQ(rsp.rsp, expect);
+        });
+      }
+      // one connection for the first three , the server closed it then
+      EXPECT_EQ(accepted, 2);
+      EXPECT_EQ(client.pool().idle_count("127.0.0.1:8892"), 1);
+
+      client.add_header("connection", "close");
+      auto result = co_await client.get(url);
+      EXPECT_FALSE(result.is_error());
+      EXPECT_EQ(served, 5);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_http(acceptor, accepted, respond));
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_http, test_pipelining) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8893});
+  acceptor.listen();
+
+  // the body echoes the path , the 3rd response closes the first connection
+  // with the 4th request already sent on it
+  std::size_t accepted{}, served{};
+  auto respond = [&](std::string_view head) -> std::string {
+    auto path = head.substr(4, head.find(' ', 4) - 4);
+    return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.size()) +
+           (++served == 3 ? "\r\nConnection: close" : "") + "\r\n\r\n" +
+           std::string{path};
+  };
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      auto client = coio::http_client{{.max_pipeline_depth = 4}};
+      auto urls = std::vector<std::string>{};
+      auto futures = std::vector<
+          coio::future<coio::result<coio::http_response, std::string>>>{};
+      for (int i = 0; i < 6; ++i)
+        urls.push_back("http://127.0.0.1:8893/" + std::to_string(i));
+      for (auto &url : urls)
+        futures.push_back(client.pipelined_get(url));
+
+      for (int i = 0; i < 6; ++i) {
+        auto result = co_await std::move(futures[i]);
+        EXPECT_FALSE(result.is_error());
+        result.map([&](coio::http_response rsp) {
+          EXPECT_EQ(rsp.status_code, 200);
+          EXPECT_EQ(rsp.rsp, "/" + std::to_string(i));
+        });
+      }
+      // the 4th is resent on a second connection
+      EXPECT_EQ(accepted, 2);
+      EXPECT_EQ(served, 6);
+      EXPECT_EQ(client.pool().idle_count("127.0.0.1:8893"), 1);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_http(acceptor, accepted, respond));
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_http, test_stream) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8894});
+  acceptor.listen();
+
+  auto big = std::string(1 << 20, 'x');
+  for (std::size_t i = 0; i < big.size(); i += 4096)
+    big[i] = char('a' + i / 4096 % 26);
+
+  std::size_t accepted{};
+  auto respond = [&](std::string_view head) -> std::string {
+    if (head.starts_with("GET /chunked "))
+      return "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+             "5\r\nhello\r\n1\r\n \r\n5\r\nworld\r\n0\r\n\r\n";
+    return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(big.size()) +
+           "\r\n\r\n" + big;
+  };
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      auto client = coio::http_client{};
+      auto key = "127.0.0.1:8894"sv;
+
+      // read to the end , slice by slice
+      auto big_rsp = co_await client.stream(coio::http_method::get,
+                                            "http://127.0.0.1:8894/big");
+      EXPECT_FALSE(big_rsp.is_error());
+      auto &r1 = big_rsp.value();
+      EXPECT_EQ(r1.status_code, 200);
+      EXPECT_EQ(r1.content_length, big.size());
+      auto body = std::string{};
+      auto slices = 0;
+      while (auto *slice = co_await r1.body.next()) {
+        body.append(*slice);
+        ++slices;
+      }
+      EXPECT_EQ(body, big);
+      EXPECT_GT(slices, 1);
+      EXPECT_EQ(client.pool().idle_count(key), 1);
+
+      auto chunked_rsp = co_await client.stream(
+          coio::http_method::get, "http://127.0.0.1:8894/chunked");
+      EXPECT_FALSE(chunked_rsp.is_error());
+      auto &r2 = chunked_rsp.value();
+      EXPECT_EQ(r2.content_length, std::nullopt);
+      body.clear();
+      while (auto *slice = co_await r2.body.next())
+        body.append(*slice);
+      EXPECT_EQ(body, "hello world");
+      EXPECT_EQ(client.pool().idle_count(key), 1);
+      EXPECT_EQ(accepted, 1);
+
+      // a body dropped half way closes its connection
+      {
+        auto rsp = co_await client.stream(coio::http_method::get,
+                                          "http://127.0.0.1:8894/big");
+        EXPECT_FALSE(rsp.is_error());
+        EXPECT_NE(co_await rsp.value().body.next(), nullptr);
+      }
+      EXPECT_EQ(client.pool().idle_count(key), 0);
+
+      // the buffered api still reads the same responses
+      auto whole = co_await client.get("http://127.0.0.1:8894/chunked");
+      EXPECT_FALSE(whole.is_error());
+      EXPECT_EQ(whole.value().rsp, "hello world");
+      EXPECT_EQ(accepted, 2);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_http(acceptor, accepted, respond));
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_http, test_get_view) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8895});
+  acceptor.listen();
+
+  std::size_t accepted{};
+  auto respond = [&](std::string_view head) -> std::string {
+    if (head.starts_with("GET /chunked "))
+      return "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+             "2\r\n{}\r\n0\r\n\r\n";
+    // 1 TiB announced , 3 bytes sent
+    if (head.starts_with("GET /huge "))
+      return "HTTP/1.1 200 OK\r\nContent-Length: 1099511627776\r\n"
+             "Connection: close\r\n\r\nabc";
+    return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+           "Content-Length: 11\r\n\r\n{\"id\": 114}";
+  };
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      auto client = coio::http_client{};
+      auto r1 = co_await client.get_view("http://127.0.0.1:8895/json");
+      EXPECT_FALSE(r1.is_error());
+      EXPECT_EQ(r1.value().status_code(), 200);
+      EXPECT_EQ(r1.value().header("content-type"), "application/json");
+      EXPECT_EQ(r1.value().body(), R"({"id": 114})");
+
+      auto r2 = co_await client.get_view("http://127.0.0.1:8895/chunked");
+      EXPECT_FALSE(r2.is_error());
+      EXPECT_EQ(r2.value().body(), "{}");
+      // the first response outlives the connection reuse
+      EXPECT_EQ(r1.value().body(), R"({"id": 114})");
+      EXPECT_EQ(accepted, 1);
+      EXPECT_EQ(client.pool().idle_count("127.0.0.1:8895"), 1);
+
+      // one connection per host : a leaked slot would block the next request
+      auto small = coio::http_client{{.max_per_host = 1}};
+      auto r3 = co_await small.get_view("http://127.0.0.1:8895/huge");
+      EXPECT_TRUE(r3.is_error());
+      auto r4 = co_await small.get_view("http://127.0.0.1:8895/json");
+      EXPECT_FALSE(r4.is_error());
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(serve_http(acceptor, accepted, respond));
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+coio::future<std::string> read_until_eof(coio::tcp_sock<> &sock) {
+  auto out = std::string{};
+  auto buf = std::array<char, 4096>{};
+  while (auto n = co_await sock.recv(std::as_writable_bytes(std::span{buf})))
+    out.append(buf.data(), n);
+  co_return out;
+}
+
+TEST(test_http, test_server) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8896});
+  acceptor.listen();
+
+  auto admin_hits = 0;
+  auto server = coio::http_server{{.max_request_size = 4096}};
+  server
+      .get("/hello",
+           [](const coio::http_request &, coio::http_reply &rep) {
+             rep.header("Content-Type", "text/plain");
+             rep.body_ref("hello");
+           })
+      .post("/echo",
+            [](const coio::http_request &req, coio::http_reply &rep) {
+              rep.body(req.query);
+              rep.append_body(":");
+              rep.append_body(req.body);
+            })
+      .get("/boom", [](const coio::http_request &, coio::http_reply &) {
+        throw std::runtime_error{"boom"};
+      })
+      .get("/admin", [&](const coio::http_request &, coio::http_reply &) {
+        ++admin_hits;
+      })
+      .get("/gone", [](const coio::http_request &, coio::http_reply &rep) {
+        rep.status(204);
+        rep.body_ref("dropped");
+      });
+
+  auto run_client = [&]() -> coio::future<void> {
+    try {
+      // pipelined in one write , answered in order
+      auto connector = coio::connector{};
+      co_await connector.connect(coio::ipv4::address{8896, "127.0.0.1"});
+      co_await connector.send(std::as_bytes(std::span{
+          "GET /hello HTTP/1.1\r\nHost: a\r\n\r\n"
+          "HEAD /hello HTTP/1.1\r\nHost: a\r\n\r\n"
+          "POST /echo?x=1 HTTP/1.1\r\nHost: a\r\nContent-Length: 3\r\n\r\nabc"
+          "PUT /hello HTTP/1.1\r\nHost: a\r\n\r\n"
+          "GET /nope HTTP/1.1\r\nHost: a\r\n\r\n"
+          "GET /boom HTTP/1.1\r\nHost: a\r\nConnection: close\r\n\r\n"sv}));
+      EXPECT_EQ(co_await read_until_eof(connector),
+                "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+                "Content-Type: text/plain\r\n\r\nhello"
+                "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+                "Content-Type: text/plain\r\n\r\n"
+                "HTTP/1.1 200 OK\r\nContent-Length: 7\r\n\r\nx=1:abc"
+                "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n"
+                "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"
+                "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n");
+
+      // larger than max_request_size
+      auto big = coio::connector{};
+      co_await big.connect(coio::ipv4::address{8896, "127.0.0.1"});
+      co_await big.send(std::as_bytes(std::span{
+          "POST /echo HTTP/1.1\r\nContent-Length: 8192\r\n\r\n"sv}));
+      EXPECT_EQ(co_await read_until_eof(big),
+                "HTTP/1.1 413 Payload Too Large\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n");
+
+      // a length wrapping head + body around must not let the body be read
+      // as the next request
+      auto answer = [](std::string_view raw) -> coio::future<std::string> {
+        auto conn = coio::connector{};
+        co_await conn.connect(coio::ipv4::address{8896, "127.0.0.1"});
+        co_await conn.send(std::as_bytes(std::span{raw}));
+        co_return co_await read_until_eof(conn);
+      };
+      EXPECT_EQ(co_await answer("POST /echo HTTP/1.1\r\n"
+                                "Content-Length: 18446744073709551615\r\n"
+                                "\r\nGET /admin HTTP/1.1\r\n\r\n"),
+                "HTTP/1.1 413 Payload Too Large\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n");
+      EXPECT_EQ(admin_hits, 0);
+      // repeated or conflicting lengths
+      auto bad_request = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n"
+                         "Connection: close\r\n\r\n"s;
+      EXPECT_EQ(co_await answer("POST /echo HTTP/1.1\r\nContent-Length: 3\r\n"
+                                "Content-Length: 3\r\n\r\nabc"),
+                bad_request);
+      EXPECT_EQ(co_await answer("POST /echo HTTP/1.1\r\nContent-Length: 0\r\n"
+                                "content-length: 27\r\n\r\n"
+                                "GET /admin HTTP/1.1\r\n\r\n"),
+                bad_request);
+      EXPECT_EQ(admin_hits, 0);
+
+      // no length , no body
+      EXPECT_EQ(co_await answer("GET /gone HTTP/1.1\r\nConnection: close"
+                                "\r\n\r\n"),
+                "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n");
+
+      // keep-alive and pipelining with http_client
+      auto client = coio::http_client{};
+      auto r1 = co_await client.get("http://127.0.0.1:8896/hello");
+      EXPECT_FALSE(r1.is_error());
+      EXPECT_EQ(r1.value().rsp, "hello");
+      auto urls = std::vector<std::string>(8, "http://127.0.0.1:8896/hello");
+      auto futures = std::vector<
+          coio::future<coio::result<coio::http_response, std::string>>>{};
+      for (auto &url : urls)
+        futures.push_back(client.pipelined_get(url));
+      for (auto &f : futures) {
+        auto r = co_await std::move(f);
+        EXPECT_FALSE(r.is_error());
+        EXPECT_EQ(r.value().rsp, "hello");
+      }
+      EXPECT_EQ(client.pool().idle_count("127.0.0.1:8896"), 1);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(server.serve(acceptor));
+  ctx.co_spawn(run_client());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
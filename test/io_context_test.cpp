@@ -224,4 +224,29 @@ TEST(test_io_context, test_when_all_async) {
   ctx.run();
 }
 
-// TODO:test sqe full
+TEST(test_io_context, test_sqe_full) {
+  using namespace std::chrono_literals;
+
+  // more delays in flight than the sq holds , a full sq is submitted
+  auto ctx = coio::io_context{{.ring_size = 4}};
+  auto _ = ctx.bind_this_thread();
+
+  uint cnt{};
+  auto make_future = [&]() -> coio::future<void> {
+    co_await coio::time_delay(1ms);
+    ++cnt;
+  };
+
+  std::vector<coio::future<void>> fs{};
+  for (int i = 0; i < 64; ++i)
+    fs.emplace_back(make_future());
+
+  auto task = [&]() -> coio::future<void> {
+    co_await when_all(std::move(fs));
+    ctx.request_stop();
+  };
+
+  ctx.post([&] { ctx.co_spawn(task()); });
+  ctx.run();
+  EXPECT_EQ(cnt, 64);
+}
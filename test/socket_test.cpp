@@ -1,11 +1,22 @@
 #include "future.hpp"
 #include "io_context.hpp"
+#include "ioutils/happy_eyeballs.hpp"
+#include "ioutils/pipe.hpp"
+#include "ioutils/proxy.hpp"
+#include "ioutils/send_file.hpp"
 #include "ioutils/tcp.hpp"
 #include "ioutils/udp.hpp"
 #include "time_delay.hpp"
+#include "when_all.hpp"
+#include <array>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <ranges>
 #include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 using namespace std::literals;
 
@@ -18,6 +29,21 @@ TEST(test_sock, test_address) {
   coio::ipv4::address addr_v4{2001, "127.0.0.1"};
   EXPECT_EQ(addr_v4.len(), sizeof(addr_v4.addr));
   EXPECT_EQ(addr_v4.to_string(), "127.0.0.1:2001");
+
+  coio::iplocal::address addr_local{"/tmp/coio.sock"};
+  EXPECT_EQ(addr_local.len(), offsetof(sockaddr_un, sun_path) + 15);
+  EXPECT_EQ(addr_local.to_string(), "/tmp/coio.sock");
+  EXPECT_EQ(addr_local, coio::iplocal::address{"/tmp/coio.sock"});
+  EXPECT_EQ(coio::iplocal::address{}.len(), sizeof(sockaddr_un));
+  auto long_path = std::string(sizeof(sockaddr_un::sun_path), 'x');
+  EXPECT_EQ(coio::iplocal::address{long_path.c_str()}.len(),
+            sizeof(sockaddr_un));
+
+  auto abstract = coio::iplocal::address::abstract("coio");
+  EXPECT_TRUE(abstract.is_abstract());
+  EXPECT_EQ(abstract.len(), offsetof(sockaddr_un, sun_path) + 5);
+  EXPECT_EQ(abstract.to_string(), "@coio");
+  EXPECT_NE(abstract, coio::iplocal::address{"coio"});
 }
 
 TEST(test_sock, test_udp) {
@@ -74,10 +100,55 @@ TEST(test_sock, test_udp) {
     std::rethrow_exception(ptr);
 }
 
+TEST(test_sock, test_udp_connected) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  const auto s_addr = coio::ipv4::address{8904, "127.0.0.1"};
+  auto server = coio::udp_sock{};
+  server.bind(s_addr);
+  auto client = coio::udp_sock{};
+  client.bind(coio::ipv4::address{8905, "127.0.0.1"});
+  client.connect(s_addr);
+  EXPECT_EQ(client.get_peer_address(), s_addr);
+  auto other = coio::udp_sock{};
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      auto ping = "ping"s;
+      EXPECT_EQ(co_await client.send(coio::to_bytes(ping)), 4);
+      auto buf = std::array<char, 16>{};
+      auto peer = coio::ipv4::address{};
+      auto n = co_await server.recvfrom(peer, coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "ping");
+      EXPECT_EQ(peer, (coio::ipv4::address{8905, "127.0.0.1"}));
+
+      // only the connected peer gets through
+      auto pong = "pong"s, stray = "stray"s;
+      const auto &to = peer;
+      co_await other.sendto(to, coio::to_bytes(stray));
+      co_await server.sendto(to, coio::to_bytes(pong));
+      n = co_await client.recv(coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "pong");
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
 TEST(test_sock, test_tcp) {
   auto ctx = coio::io_context{};
   auto _ = ctx.bind_this_thread();
 
+  EXPECT_EQ(coio::tcp_sock<>::invalid().native_handle(), -1);
+
   auto s_addr = coio::ipv4::address{8889};
   char hello[] = {"hello world."};
   auto ptr = std::exception_ptr{};
@@ -161,4 +232,470 @@ TEST(test_sock, test_no_sigpipe) {
     std::rethrow_exception(ptr);
 }
 
+TEST(test_sock, test_reuse_port_steering) {
+  auto a = coio::acceptor{};
+  auto b = coio::acceptor{};
+  for (auto *acc : {&a, &b}) {
+    acc->set_reuse_port();
+    acc->bind(coio::ipv4::address{8890});
+    acc->listen();
+  }
+  EXPECT_ANY_THROW(a.set_reuse_port_cpu_steering(0));
+  EXPECT_NO_THROW(a.set_reuse_port_cpu_steering(2));
+  // threads pinned from cpu 3 on
+  EXPECT_NO_THROW(a.set_reuse_port_cpu_steering(2, 3));
+}
+
+TEST(test_sock, test_accept_multishot) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto acceptor = coio::acceptor{};
+  acceptor.set_reuse_address();
+  acceptor.bind(coio::ipv4::address{8897});
+  acceptor.listen();
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      auto clients = std::vector<coio::connector<>>(4);
+      for (auto &c : clients | std::views::take(3))
+        co_await c.connect(coio::ipv4::address{8897, "127.0.0.1"});
+      {
+        // one sqe , three connections
+        auto accepts = acceptor.accept_multishot();
+        for (int i = 0; i < 3; ++i) {
+          auto sock = co_await accepts.next();
+          EXPECT_TRUE(sock.get_peer_address().to_string().starts_with(
+              "127.0.0.1:"));
+        }
+      } // cancels the multishot accept
+
+      co_await clients[3].connect(coio::ipv4::address{8897, "127.0.0.1"});
+      auto sock = co_await acceptor.accept();
+      co_await clients[3].send(std::as_bytes(std::span{"ping"sv}));
+      auto buf = std::array<std::byte, 4>{};
+      EXPECT_EQ(co_await sock.recv(buf), 4);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_sock, test_udp_multishot) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto client = coio::udp_sock{};
+  client.bind(coio::ipv4::address{8901, "127.0.0.1"});
+  auto server = coio::udp_sock{};
+  auto s_addr = coio::ipv4::address{8902, "127.0.0.1"};
+  server.bind(s_addr);
+  auto gro_server = coio::udp_sock{};
+  auto gro_addr = coio::ipv4::address{8903, "127.0.0.1"};
+  gro_server.bind(gro_addr);
+  gro_server.set_gro();
+
+  auto as_view = [](std::span<const std::byte> s) {
+    return std::string_view{reinterpret_cast<const char *>(s.data()),
+                            s.size()};
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      // six datagrams through four buffers , recycled as they are taken
+      for (auto msg : {"d0"s, "d1"s, "d2"s, "d3"s, "d4"s, "d5"s})
+        co_await client.sendto(s_addr, coio::to_bytes(msg));
+      auto pool = std::make_shared<coio::provided_buffers>(4, 4096);
+      {
+        auto datagrams = server.recvmsg_multishot(pool);
+        for (int i = 0; i < 6; ++i) {
+          auto d = co_await datagrams.next();
+          EXPECT_EQ(as_view(d.payload()), "d" + std::to_string(i));
+          EXPECT_EQ(d.peer(), (coio::ipv4::address{8901, "127.0.0.1"}));
+          EXPECT_EQ(d.segment_count(), 1);
+        }
+      } // cancels the multishot receive
+
+      // one sendmsg , three datagrams
+      auto payload = std::string(1000, 'a') + std::string(1000, 'b') +
+                     std::string(500, 'c');
+      EXPECT_EQ(co_await client.sendto_segmented(
+                    s_addr, coio::to_bytes(payload), 1000),
+                payload.size());
+      auto datagrams = server.recvmsg_multishot(pool);
+      for (auto expect : {'a', 'b', 'c'}) {
+        auto d = co_await datagrams.next();
+        EXPECT_EQ(d.segment_size(), 0);
+        EXPECT_EQ(as_view(d.payload()),
+                  std::string(expect == 'c' ? 500 : 1000, expect));
+      }
+
+      // received coalesced
+      co_await client.sendto_segmented(gro_addr, coio::to_bytes(payload),
+                                       1000);
+      auto coalesced = gro_server.recvmsg_multishot(pool);
+      auto d = co_await coalesced.next();
+      EXPECT_EQ(d.segment_size(), 1000);
+      EXPECT_EQ(d.segment_count(), 3);
+      EXPECT_EQ(as_view(d.payload()), payload);
+      EXPECT_EQ(as_view(d.segment(2)), std::string(500, 'c'));
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_sock, test_unix_socket) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  // a path
+  auto path = coio::iplocal::address{"/tmp/coio_test_unix.sock"};
+  ::unlink("/tmp/coio_test_unix.sock");
+  auto stream_acceptor = coio::acceptor<coio::iplocal>{};
+  stream_acceptor.bind(path);
+  stream_acceptor.listen();
+
+  // the abstract namespace
+  using seqpacket = coio::iplocal::seqpacket;
+  auto name = coio::iplocal::address::abstract("coio_test_seqpacket");
+  auto packet_acceptor = coio::acceptor<seqpacket>{};
+  packet_acceptor.bind(name);
+  packet_acceptor.listen();
+
+  // datagrams between abstract names
+  auto dgram_name = coio::iplocal::address::abstract("coio_test_dgram");
+  auto dgram_server = coio::udp_sock<coio::iplocal>{};
+  dgram_server.bind(dgram_name);
+  auto dgram_client = coio::udp_sock<coio::iplocal>{};
+  dgram_client.bind(coio::iplocal::address::abstract("coio_test_dgram_peer"));
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      auto stream_client = coio::connector<coio::iplocal>{};
+      co_await stream_client.connect(path);
+      auto stream_server = co_await stream_acceptor.accept();
+      EXPECT_EQ(stream_client.get_peer_address(), path);
+      auto ping = "ping"s;
+      co_await stream_client.send(coio::to_bytes(ping));
+      auto buf = std::array<char, 16>{};
+      auto n = co_await stream_server.recv(coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "ping");
+
+      auto client = coio::connector<seqpacket>{};
+      co_await client.connect(name);
+      auto server = co_await packet_acceptor.accept();
+      EXPECT_EQ(client.get_peer_address(), name);
+      EXPECT_EQ(server.get_peer_credentials().pid, ::getpid());
+
+      // message boundaries are kept
+      auto ab = "ab"s, cde = "cde"s;
+      co_await client.send(coio::to_bytes(ab));
+      co_await client.send(coio::to_bytes(cde));
+      EXPECT_EQ(co_await server.recv(coio::to_bytes(buf)), 2);
+      EXPECT_EQ(co_await server.recv(coio::to_bytes(buf)), 3);
+
+      // the read end of a pipe and the credentials , with a message
+      int pipe_fds[2]{};
+      EXPECT_EQ(::pipe(pipe_fds), 0);
+      server.set_pass_credentials();
+      auto fd_msg = "fd"s;
+      {
+        auto out = coio::ancillary_data{};
+        out.add_fds(std::span{pipe_fds, 1});
+        out.add_credentials();
+        EXPECT_EQ(co_await client.sendmsg(out, coio::to_bytes(fd_msg)), 2);
+      }
+      ::close(pipe_fds[0]);
+      auto in = coio::ancillary_data{};
+      n = co_await server.recvmsg(in, coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "fd");
+      EXPECT_EQ(in.fds().size(), 1);
+      EXPECT_TRUE(in.credentials() && in.credentials()->pid == ::getpid());
+      auto fds = in.take_fds();
+      EXPECT_EQ(in.fds().size(), 0);
+      if (fds.size() == 1) {
+        EXPECT_EQ(::write(pipe_fds[1], "x", 1), 1);
+        char c{};
+        EXPECT_EQ(::read(fds[0], &c, 1), 1);
+        EXPECT_EQ(c, 'x');
+        EXPECT_NE(::fcntl(fds[0], F_GETFD) & FD_CLOEXEC, 0);
+        ::close(fds[0]);
+      }
+      ::close(pipe_fds[1]);
+
+      // answered at the abstract name the datagram came from
+      auto peer = coio::iplocal::address{};
+      co_await dgram_client.sendto(dgram_name, coio::to_bytes(ping));
+      n = co_await dgram_server.recvfrom(peer, coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "ping");
+      EXPECT_EQ(peer.to_string(), "@coio_test_dgram_peer");
+      auto pong = "pong"s;
+      co_await dgram_server.sendto(peer, coio::to_bytes(pong));
+      auto from = coio::iplocal::address{};
+      n = co_await dgram_client.recvfrom(from, coio::to_bytes(buf));
+      EXPECT_EQ(std::string_view(buf.data(), n), "pong");
+      EXPECT_EQ(from, dgram_name);
+
+      // the same through a multishot receive
+      co_await dgram_client.sendto(dgram_name, coio::to_bytes(ping));
+      auto pool = std::make_shared<coio::provided_buffers>(2, 256);
+      auto datagrams = dgram_server.recvmsg_multishot(pool);
+      auto d = co_await datagrams.next();
+      EXPECT_EQ(d.peer().to_string(), "@coio_test_dgram_peer");
+      co_await dgram_server.sendto(d.peer(), coio::to_bytes(pong));
+      EXPECT_EQ(co_await dgram_client.recv(coio::to_bytes(buf)), 4);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  ::unlink("/tmp/coio_test_unix.sock");
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_sock, test_splice_proxy) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto front = coio::acceptor{};
+  front.set_reuse_address();
+  front.bind(coio::ipv4::address{8906});
+  front.listen();
+  auto backend = coio::acceptor{};
+  backend.set_reuse_address();
+  backend.bind(coio::ipv4::address{8907});
+  backend.listen();
+
+  using fd_base = coio::file_descriptor_base;
+  auto payload = std::string(300000, 'x');
+  for (std::size_t i = 0; i < payload.size(); i += 1000)
+    payload[i] = static_cast<char>('a' + i / 1000 % 26);
+  auto proxied = coio::proxy_result{};
+
+  // echoes until the proxy half closes it
+  auto echo = [&]() -> coio::future<void> {
+    auto sock = co_await backend.accept();
+    auto buf = std::array<std::byte, 4096>{};
+    while (auto n = co_await sock.recv(buf))
+      co_await sock.send(std::span{buf}.first(n));
+    co_await sock.shutdown(sock.shutdown_write);
+  };
+
+  auto run_proxy = [&]() -> coio::future<void> {
+    auto client = co_await front.accept();
+    auto conn = coio::connector{};
+    co_await conn.connect(coio::ipv4::address{8907, "127.0.0.1"});
+    proxied = co_await coio::proxy(client, conn.socket());
+  };
+
+  auto send_all = [&](coio::tcp_sock<> &sock) -> coio::future<void> {
+    for (std::size_t sent = 0; sent < payload.size();)
+      sent += co_await sock.send(
+          std::as_bytes(std::span{payload}).subspan(sent));
+    co_await sock.shutdown(sock.shutdown_write);
+  };
+
+  auto recv_all = [&](coio::tcp_sock<> &sock) -> coio::future<std::string> {
+    auto out = std::string{};
+    auto buf = std::array<char, 8192>{};
+    while (auto n = co_await sock.recv(coio::to_bytes(buf)))
+      out.append(buf.data(), n);
+    co_return out;
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      // tee leaves the bytes in the first pipe
+      auto p1 = coio::pipe{}, p2 = coio::pipe{};
+      EXPECT_EQ(::write(p1.write_end().native_handle(), "hello", 5), 5);
+      EXPECT_EQ(co_await fd_base::tee(p1.read_end(), p2.write_end(), 5), 5);
+      EXPECT_EQ(p1.size(), 5);
+      EXPECT_EQ(co_await fd_base::splice(p1.read_end(), p2.write_end(), 5),
+                5);
+      EXPECT_EQ(p2.size(), 10);
+      auto buf = std::array<char, 10>{};
+      EXPECT_EQ(::read(p2.read_end().native_handle(), buf.data(), 10), 10);
+      EXPECT_EQ(std::string_view(buf.data(), 10), "hellohello");
+
+      auto client = coio::connector{};
+      co_await client.connect(coio::ipv4::address{8906, "127.0.0.1"});
+      auto both = coio::when_all(send_all(client.socket()),
+                                 recv_all(client.socket()));
+      auto echoed = std::get<1>(co_await std::move(both));
+      EXPECT_TRUE(echoed == payload);
+      // the proxy may still be finishing , let it complete
+      co_await coio::time_delay(10ms);
+      EXPECT_EQ(proxied.a_to_b, payload.size());
+      EXPECT_EQ(proxied.b_to_a, payload.size());
+      // both pipes drained , back in the pool
+      EXPECT_EQ(coio::pipe_pool::current().idle(), 2);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(echo());
+  ctx.co_spawn(run_proxy());
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_sock, test_send_file) {
+  namespace fs = std::filesystem;
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  if (!fs::exists("./tmp"))
+    fs::create_directory("./tmp");
+  auto content = std::string(200000, 'x');
+  for (std::size_t i = 0; i < content.size(); ++i)
+    content[i] = static_cast<char>('a' + i * 7 % 26);
+  std::ofstream{"./tmp/send_file.txt", std::ios::binary} << content;
+
+  auto accpt = coio::acceptor{};
+  accpt.set_reuse_address();
+  accpt.bind(coio::ipv4::address{8908});
+  accpt.listen();
+
+  auto recv_all = [&]() -> coio::future<std::string> {
+    auto sock = co_await accpt.accept();
+    auto out = std::string{};
+    auto buf = std::array<char, 8192>{};
+    while (auto n = co_await sock.recv(coio::to_bytes(buf)))
+      out.append(buf.data(), n);
+    co_return out;
+  };
+
+  // sends [offset , offset + len) and checks what arrives
+  auto check = [&](bool splice, off_t offset,
+                   std::size_t len) -> coio::future<void> {
+    auto f = co_await coio::file::openat("./tmp/send_file.txt", O_RDONLY);
+    auto send = [&]() -> coio::future<std::size_t> {
+      auto conn = coio::connector{};
+      co_await conn.connect(coio::ipv4::address{8908, "127.0.0.1"});
+      auto opt = coio::send_file_options{.splice = splice};
+      auto n = co_await coio::send_file(conn.socket(), f, offset, len, opt);
+      co_await conn.socket().shutdown(conn.socket().shutdown_write);
+      co_return n;
+    };
+    auto both = coio::when_all(send(), recv_all());
+    auto [sent, received] = co_await std::move(both);
+    auto expected = content.substr(offset, len);
+    EXPECT_EQ(sent, expected.size());
+    EXPECT_TRUE(received == expected);
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    try {
+      for (auto splice : {true, false}) {
+        co_await check(splice, 0, content.size());
+        co_await check(splice, 12345, 100000);
+        // past the end of the file , sends what there is
+        co_await check(splice, 150000, 100000);
+      }
+      EXPECT_EQ(coio::pipe_pool::current().idle(), 1);
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
+TEST(test_sock, test_happy_eyeballs) {
+  auto ctx = coio::io_context{};
+  auto _ = ctx.bind_this_thread();
+  auto ptr = std::exception_ptr{};
+
+  auto live = coio::acceptor{};
+  live.set_reuse_address();
+  live.bind(coio::ipv4::address{8898, "127.0.0.1"});
+  live.listen();
+  auto live6 = coio::acceptor{coio::ipv6{}};
+  live6.set_reuse_address();
+  live6.bind(coio::ipv6::address{8898, "::1"});
+  live6.listen();
+  // one connection fills its queue , more connects stall
+  auto stalled = coio::acceptor{};
+  stalled.set_reuse_address();
+  stalled.bind(coio::ipv4::address{8899, "127.0.0.1"});
+  stalled.listen(0);
+
+  auto v4 = [](uint16_t port) {
+    return coio::ip::address{coio::ipv4::address{port, "127.0.0.1"}};
+  };
+  auto v6 = [](uint16_t port) {
+    return coio::ip::address{coio::ipv6::address{port, "::1"}};
+  };
+
+  auto run = [&]() -> coio::future<void> {
+    using clock = std::chrono::steady_clock;
+    try {
+      auto filler = coio::connector{};
+      co_await filler.connect(coio::ipv4::address{8899, "127.0.0.1"});
+      auto opts = coio::happy_eyeballs_options{.attempt_delay = 50ms};
+
+      // the stalled attempt is overtaken , then cancelled
+      auto stall_first = std::vector{v4(8899), v4(8898)};
+      auto beg = clock::now();
+      auto sock = co_await coio::happy_eyeballs_connect(stall_first, opts);
+      EXPECT_GE(clock::now() - beg, 50ms);
+      EXPECT_LT(clock::now() - beg, 1s);
+      EXPECT_EQ(sock.get_peer_address(), v4(8898));
+
+      // a refused attempt does not wait for the delay
+      auto refused_first = std::vector{v4(8900), v6(8898)};
+      beg = clock::now();
+      auto sock6 = co_await coio::happy_eyeballs_connect(refused_first, opts);
+      EXPECT_LT(clock::now() - beg, 50ms);
+      EXPECT_EQ(sock6.get_peer_address(), v6(8898));
+
+      auto all_refused = std::vector{v4(8900), v6(8900)};
+      try {
+        co_await coio::happy_eyeballs_connect(all_refused, opts);
+        ADD_FAILURE();
+      } catch (const std::system_error &e) {
+        EXPECT_EQ(e.code().value(), ECONNREFUSED);
+      }
+    } catch (...) {
+      ptr = std::current_exception();
+    }
+    ctx.request_stop();
+  };
+
+  ctx.co_spawn(run());
+  ctx.run();
+  if (ptr)
+    std::rethrow_exception(ptr);
+}
+
 // TODO : test ipv6 / local socket